@@ -0,0 +1,530 @@
+/*
+Title: Optimizing Collision Detection
+File Name: AABBTreeCircles.cpp
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+A version of DataOptimizedCircles.cpp that uses a dynamic AABB tree (a bounding
+volume hierarchy) as a broadphase, which copes with wildly different radii.
+
+References:
+http://box2d.org/ (b2DynamicTree, which this tree is modeled after)
+*/
+
+#include "AABBTreeCircles.h"
+#include "HelperFunctions.h"
+#include <cstring>
+
+#define NULL_NODE -1
+
+// The perimeter of a box.  In 2D this works better than the area for deciding where
+// new leaves should go, since long skinny boxes get punished properly.
+static float Perimeter(float minX, float minY, float maxX, float maxY){
+	return 2.0f * ((maxX - minX) + (maxY - minY));
+}
+
+static float Min(float a, float b){
+	return a < b ? a : b;
+}
+
+static float Max(float a, float b){
+	return a > b ? a : b;
+}
+
+AABBTreeCircles::AABBTreeCircles(int numCircles, float worldSize)
+{
+	this->numCircles = numCircles;
+	this->worldSize = worldSize;
+
+	xPosition = (float*)malloc(numCircles * sizeof(float));
+	xVelocity = (float*)malloc(numCircles * sizeof(float));
+	yPosition = (float*)malloc(numCircles * sizeof(float));
+	yVelocity = (float*)malloc(numCircles * sizeof(float));
+	radius = (float*)malloc(numCircles * sizeof(float));
+
+	for (int i = 0; i < numCircles; ++i){
+		xPosition[i] = Helper::RandomFloat(0, worldSize);
+		yPosition[i] = Helper::RandomFloat(0, worldSize);
+		xVelocity[i] = Helper::RandomFloat(-1.0f, 1.0f);
+		yVelocity[i] = Helper::RandomFloat(-1.0f, 1.0f);
+		radius[i] = Helper::RandomFloat(5.0f, 100.0f);
+	}
+
+	isCollided = (bool**)malloc(sizeof(bool*) * numCircles);
+	for (int i = 0; i < numCircles; ++i){
+		isCollided[i] = (bool*)malloc(sizeof(bool) * numCircles);
+		memset(isCollided[i], 0, sizeof(bool) * numCircles);
+	}
+
+	// Set up every node in one big free list.
+	nodeCapacity = numCircles * 2;
+	nodes = (Node*)malloc(sizeof(Node) * nodeCapacity);
+	for (int n = 0; n < nodeCapacity; ++n){
+		nodes[n].parent = n + 1;
+		nodes[n].height = -1;
+	}
+	nodes[nodeCapacity - 1].parent = NULL_NODE;
+	freeList = 0;
+	root = NULL_NODE;
+
+	leafNode = (int*)malloc(sizeof(int) * numCircles);
+	for (int i = 0; i < numCircles; ++i){
+		int leaf = AllocateNode();
+		nodes[leaf].circle = i;
+		SetFatBox(leaf, i);
+		InsertLeaf(leaf);
+		leafNode[i] = leaf;
+	}
+
+	lastReinsertions = 0;
+}
+
+
+AABBTreeCircles::~AABBTreeCircles()
+{
+	free(xPosition);
+	free(xVelocity);
+	free(yPosition);
+	free(yVelocity);
+	free(radius);
+
+	for (int i = 0; i < numCircles; ++i){
+		free(isCollided[i]);
+	}
+	free(isCollided);
+
+	free(nodes);
+	free(leafNode);
+}
+
+int AABBTreeCircles::AllocateNode(){
+	int index = freeList;
+	freeList = nodes[index].parent;
+
+	nodes[index].parent = NULL_NODE;
+	nodes[index].child1 = NULL_NODE;
+	nodes[index].child2 = NULL_NODE;
+	nodes[index].height = 0;
+	nodes[index].circle = -1;
+	return index;
+}
+
+void AABBTreeCircles::FreeNode(int index){
+	nodes[index].parent = freeList;
+	nodes[index].height = -1;
+	freeList = index;
+}
+
+void AABBTreeCircles::SetFatBox(int leaf, int circle){
+	// So this is the fattening.  The box in the tree is a little bigger than the circle,
+	// and as long as the circle stays inside it we don't touch the tree at all.
+	// With velocities around 1 a margin of a few units buys us a few frames at a time.
+	float extent = radius[circle] + AABB_MARGIN;
+	nodes[leaf].minX = xPosition[circle] - extent;
+	nodes[leaf].minY = yPosition[circle] - extent;
+	nodes[leaf].maxX = xPosition[circle] + extent;
+	nodes[leaf].maxY = yPosition[circle] + extent;
+}
+
+void AABBTreeCircles::InsertLeaf(int leaf){
+	if (root == NULL_NODE){
+		root = leaf;
+		nodes[root].parent = NULL_NODE;
+		return;
+	}
+
+	float minX = nodes[leaf].minX;
+	float minY = nodes[leaf].minY;
+	float maxX = nodes[leaf].maxX;
+	float maxY = nodes[leaf].maxY;
+
+	// Walk down the tree picking whichever side would grow the least if we put the
+	// leaf in it.  Stop early if making a new parent right here is cheaper than both.
+	int index = root;
+	while (nodes[index].height > 0){
+		Node& node = nodes[index];
+		int child1 = node.child1;
+		int child2 = node.child2;
+
+		float area = Perimeter(node.minX, node.minY, node.maxX, node.maxY);
+		float combinedArea = Perimeter(Min(node.minX, minX), Min(node.minY, minY),
+			Max(node.maxX, maxX), Max(node.maxY, maxY));
+
+		// Cost of making a new parent for this node and the new leaf.
+		float cost = 2.0f * combinedArea;
+
+		// Minimum cost of pushing the leaf further down the tree.  Everything above
+		// it grows no matter which way we go.
+		float inheritanceCost = 2.0f * (combinedArea - area);
+
+		float childCost[2];
+		int children[2] = { child1, child2 };
+		for (int c = 0; c < 2; ++c){
+			Node& child = nodes[children[c]];
+			float grown = Perimeter(Min(child.minX, minX), Min(child.minY, minY),
+				Max(child.maxX, maxX), Max(child.maxY, maxY));
+			if (child.height == 0){
+				childCost[c] = grown + inheritanceCost;
+			}
+			else{
+				childCost[c] = grown - Perimeter(child.minX, child.minY, child.maxX, child.maxY) + inheritanceCost;
+			}
+		}
+
+		if (cost < childCost[0] && cost < childCost[1]){
+			break;
+		}
+
+		index = childCost[0] < childCost[1] ? child1 : child2;
+	}
+
+	int sibling = index;
+
+	// Make a new parent for the sibling and the leaf.
+	int oldParent = nodes[sibling].parent;
+	int newParent = AllocateNode();
+	nodes[newParent].parent = oldParent;
+	nodes[newParent].minX = Min(minX, nodes[sibling].minX);
+	nodes[newParent].minY = Min(minY, nodes[sibling].minY);
+	nodes[newParent].maxX = Max(maxX, nodes[sibling].maxX);
+	nodes[newParent].maxY = Max(maxY, nodes[sibling].maxY);
+	nodes[newParent].height = nodes[sibling].height + 1;
+	nodes[newParent].child1 = sibling;
+	nodes[newParent].child2 = leaf;
+	nodes[sibling].parent = newParent;
+	nodes[leaf].parent = newParent;
+
+	if (oldParent != NULL_NODE){
+		if (nodes[oldParent].child1 == sibling){
+			nodes[oldParent].child1 = newParent;
+		}
+		else{
+			nodes[oldParent].child2 = newParent;
+		}
+	}
+	else{
+		root = newParent;
+	}
+
+	// Everything above the new parent may have grown, so fix it up.
+	Refit(nodes[leaf].parent);
+}
+
+void AABBTreeCircles::RemoveLeaf(int leaf){
+	if (leaf == root){
+		root = NULL_NODE;
+		return;
+	}
+
+	int parent = nodes[leaf].parent;
+	int grandParent = nodes[parent].parent;
+	int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+	// The parent only existed to hold the leaf and its sibling, so the sibling takes
+	// its place and the parent goes back in the free list.
+	if (grandParent != NULL_NODE){
+		if (nodes[grandParent].child1 == parent){
+			nodes[grandParent].child1 = sibling;
+		}
+		else{
+			nodes[grandParent].child2 = sibling;
+		}
+		nodes[sibling].parent = grandParent;
+		FreeNode(parent);
+
+		Refit(grandParent);
+	}
+	else{
+		root = sibling;
+		nodes[sibling].parent = NULL_NODE;
+		FreeNode(parent);
+	}
+}
+
+void AABBTreeCircles::Refit(int index){
+	// This is the incremental refit.  Only the path from the changed node to the root
+	// can have a wrong box or height, so walk up that path (rebalancing as we go) and
+	// leave the rest of the tree alone.
+	while (index != NULL_NODE){
+		index = Balance(index);
+
+		Node& node = nodes[index];
+		Node& child1 = nodes[node.child1];
+		Node& child2 = nodes[node.child2];
+
+		node.height = 1 + (child1.height > child2.height ? child1.height : child2.height);
+		node.minX = Min(child1.minX, child2.minX);
+		node.minY = Min(child1.minY, child2.minY);
+		node.maxX = Max(child1.maxX, child2.maxX);
+		node.maxY = Max(child1.maxY, child2.maxY);
+
+		index = node.parent;
+	}
+}
+
+int AABBTreeCircles::Balance(int iA){
+	// Tree rotation.  If one side of A is more than one level taller than the other, the
+	// taller child gets rotated up into A's place, A becomes its child, and the shorter
+	// of that child's two children gets handed down to A.  This is what keeps the tree
+	// from turning into a linked list when circles get inserted in an unlucky order.
+	Node& A = nodes[iA];
+	if (A.height < 2){
+		return iA;
+	}
+
+	int iB = A.child1;
+	int iC = A.child2;
+	Node& B = nodes[iB];
+	Node& C = nodes[iC];
+
+	int balance = C.height - B.height;
+
+	// Rotate C up.
+	if (balance > 1){
+		int iF = C.child1;
+		int iG = C.child2;
+		Node& F = nodes[iF];
+		Node& G = nodes[iG];
+
+		C.child1 = iA;
+		C.parent = A.parent;
+		A.parent = iC;
+
+		if (C.parent != NULL_NODE){
+			if (nodes[C.parent].child1 == iA){
+				nodes[C.parent].child1 = iC;
+			}
+			else{
+				nodes[C.parent].child2 = iC;
+			}
+		}
+		else{
+			root = iC;
+		}
+
+		// The shorter of C's children moves down under A.
+		int iKeep = F.height > G.height ? iF : iG;
+		int iMove = F.height > G.height ? iG : iF;
+		Node& keep = nodes[iKeep];
+		Node& move = nodes[iMove];
+
+		C.child2 = iKeep;
+		A.child2 = iMove;
+		move.parent = iA;
+
+		A.minX = Min(B.minX, move.minX);
+		A.minY = Min(B.minY, move.minY);
+		A.maxX = Max(B.maxX, move.maxX);
+		A.maxY = Max(B.maxY, move.maxY);
+		C.minX = Min(A.minX, keep.minX);
+		C.minY = Min(A.minY, keep.minY);
+		C.maxX = Max(A.maxX, keep.maxX);
+		C.maxY = Max(A.maxY, keep.maxY);
+
+		A.height = 1 + (B.height > move.height ? B.height : move.height);
+		C.height = 1 + (A.height > keep.height ? A.height : keep.height);
+
+		return iC;
+	}
+
+	// Rotate B up.  Same thing, mirrored.
+	if (balance < -1){
+		int iD = B.child1;
+		int iE = B.child2;
+		Node& D = nodes[iD];
+		Node& E = nodes[iE];
+
+		B.child1 = iA;
+		B.parent = A.parent;
+		A.parent = iB;
+
+		if (B.parent != NULL_NODE){
+			if (nodes[B.parent].child1 == iA){
+				nodes[B.parent].child1 = iB;
+			}
+			else{
+				nodes[B.parent].child2 = iB;
+			}
+		}
+		else{
+			root = iB;
+		}
+
+		int iKeep = D.height > E.height ? iD : iE;
+		int iMove = D.height > E.height ? iE : iD;
+		Node& keep = nodes[iKeep];
+		Node& move = nodes[iMove];
+
+		B.child2 = iKeep;
+		A.child1 = iMove;
+		move.parent = iA;
+
+		A.minX = Min(C.minX, move.minX);
+		A.minY = Min(C.minY, move.minY);
+		A.maxX = Max(C.maxX, move.maxX);
+		A.maxY = Max(C.maxY, move.maxY);
+		B.minX = Min(A.minX, keep.minX);
+		B.minY = Min(A.minY, keep.minY);
+		B.maxX = Max(A.maxX, keep.maxX);
+		B.maxY = Max(A.maxY, keep.maxY);
+
+		A.height = 1 + (C.height > move.height ? C.height : move.height);
+		B.height = 1 + (A.height > keep.height ? A.height : keep.height);
+
+		return iB;
+	}
+
+	return iA;
+}
+
+void AABBTreeCircles::Update(){
+	int reinsertions = 0;
+
+	for (int i = 0; i < numCircles; ++i){
+		xPosition[i] += xVelocity[i];
+		yPosition[i] += yVelocity[i];
+
+		// Still inside the fat box?  Then the tree is still correct for this circle
+		// and there's nothing to do.  This is the common case.
+		Node& leaf = nodes[leafNode[i]];
+		float r = radius[i];
+		if (xPosition[i] - r >= leaf.minX && xPosition[i] + r <= leaf.maxX &&
+			yPosition[i] - r >= leaf.minY && yPosition[i] + r <= leaf.maxY){
+			continue;
+		}
+
+		// Otherwise pull it out, re-fatten it around where it is now, and put it back.
+		RemoveLeaf(leafNode[i]);
+		SetFatBox(leafNode[i], i);
+		InsertLeaf(leafNode[i]);
+		++reinsertions;
+	}
+
+	lastReinsertions = reinsertions;
+}
+
+void AABBTreeCircles::CheckForCollisions(){
+	for (size_t c = 0; c < contacts.size(); ++c){
+		isCollided[contacts[c].i][contacts[c].j] = false;
+	}
+	contacts.clear();
+
+	if (root == NULL_NODE){
+		return;
+	}
+
+	// Instead of asking the tree "what touches circle i?" once per circle (which finds
+	// every pair twice), we walk the tree against itself.  Each entry on the stack is a
+	// pair of nodes whose leaves might touch.  A node paired with itself means "every
+	// pair inside this node", which splits into each child with itself plus the two
+	// children against each other.  That way every pair of leaves comes up exactly once.
+	pairStack.clear();
+	pairStack.push_back(root);
+	pairStack.push_back(root);
+	while (!pairStack.empty()){
+		int b = pairStack.back();
+		pairStack.pop_back();
+		int a = pairStack.back();
+		pairStack.pop_back();
+
+		const Node& nodeA = nodes[a];
+		const Node& nodeB = nodes[b];
+
+		if (a == b){
+			if (nodeA.height > 0){
+				pairStack.push_back(nodeA.child1);
+				pairStack.push_back(nodeA.child1);
+				pairStack.push_back(nodeA.child2);
+				pairStack.push_back(nodeA.child2);
+				pairStack.push_back(nodeA.child1);
+				pairStack.push_back(nodeA.child2);
+			}
+			continue;
+		}
+
+		// If the two boxes don't touch, nothing under them can either.
+		if (nodeA.maxX < nodeB.minX || nodeA.minX > nodeB.maxX || nodeA.maxY < nodeB.minY || nodeA.minY > nodeB.maxY){
+			continue;
+		}
+
+		// Open up whichever side is bigger (and isn't a leaf) and keep going.
+		if (nodeA.height > 0 || nodeB.height > 0){
+			if (nodeB.height == 0 || (nodeA.height > 0 &&
+				Perimeter(nodeA.minX, nodeA.minY, nodeA.maxX, nodeA.maxY) > Perimeter(nodeB.minX, nodeB.minY, nodeB.maxX, nodeB.maxY))){
+				pairStack.push_back(nodeA.child1);
+				pairStack.push_back(b);
+				pairStack.push_back(nodeA.child2);
+				pairStack.push_back(b);
+			}
+			else{
+				pairStack.push_back(a);
+				pairStack.push_back(nodeB.child1);
+				pairStack.push_back(a);
+				pairStack.push_back(nodeB.child2);
+			}
+			continue;
+		}
+
+		// Two leaves, so two circles.  Put them in i < j order for the top right triangle.
+		int i = nodeA.circle < nodeB.circle ? nodeA.circle : nodeB.circle;
+		int j = nodeA.circle < nodeB.circle ? nodeB.circle : nodeA.circle;
+
+		float xDif = xPosition[i] - xPosition[j];
+		float yDif = yPosition[i] - yPosition[j];
+		float radiusAdd = radius[i] + radius[j];
+		if (xDif * xDif + yDif * yDif < radiusAdd * radiusAdd){
+			isCollided[i][j] = true;
+			Contact contact = { i, j };
+			contacts.push_back(contact);
+		}
+	}
+}
+
+int AABBTreeCircles::CountMismatches(){
+	int mismatches = 0;
+	for (int i = 0; i < numCircles; ++i){
+		for (int j = i + 1; j < numCircles; ++j){
+			bool expected = (xPosition[i] - xPosition[j]) * (xPosition[i] - xPosition[j])
+				+ (yPosition[i] - yPosition[j]) * (yPosition[i] - yPosition[j])
+				< (radius[i] + radius[j]) * (radius[i] + radius[j]);
+			mismatches += expected != isCollided[i][j];
+		}
+	}
+	return mismatches;
+}
+
+size_t AABBTreeCircles::MemoryUsage(){
+	return sizeof(Node) * nodeCapacity + sizeof(int) * (numCircles + pairStack.capacity())
+		+ sizeof(Contact) * contacts.capacity();
+}
+
+int AABBTreeCircles::Height(){
+	return root == NULL_NODE ? 0 : nodes[root].height;
+}
+
+// The tree doesn't care how big anything is.  A 100 radius circle just makes a bigger
+// leaf, instead of making every cell in a grid huge.  The cost is pointer chasing: each
+// query hops around the nodes array, which is exactly the kind of memory access
+// DataOptimizedCircles taught us to avoid.  The node array helps some, since at least
+// all the nodes are in one place instead of scattered around the heap by new.
+//
+// Notice how little Update() does most frames.  Most circles are still inside their
+// fat boxes, so the tree only changes for the handful that weren't.
@@ -0,0 +1,107 @@
+/*
+Title: Optimizing Collision Detection
+File Name: AABBTreeCircles.h
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+A version of DataOptimizedCircles.cpp that uses a dynamic AABB tree (a bounding
+volume hierarchy) as a broadphase, which copes with wildly different radii.
+*/
+
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "Settings.h"
+
+class AABBTreeCircles
+{
+public:
+	int numCircles;
+	float worldSize;
+
+	float* xPosition;
+	float* xVelocity;
+	float* yPosition;
+	float* yVelocity;
+	float* radius;
+
+	bool** isCollided;
+
+	// How many circles left their fattened box in the last Update() and had to be
+	// pulled out of the tree and put back in.
+	int lastReinsertions;
+
+	AABBTreeCircles(int numCircles = NUM_CIRCLES, float worldSize = 1000.0f);
+	~AABBTreeCircles();
+
+	void Update();
+	void CheckForCollisions();
+
+	// Tests every pair the slow way and returns how many entries of isCollided
+	// disagree with it.  Should always be 0.
+	int CountMismatches();
+
+	// Bytes used by the tree itself (not the circles or isCollided).
+	size_t MemoryUsage();
+	int Height();
+
+private:
+	// Every node has a box.  Leaves hold one circle, everything else holds two children
+	// and a box around both of them.
+	struct Node{
+		float minX;
+		float minY;
+		float maxX;
+		float maxY;
+
+		int parent; // Doubles as the next pointer while the node is in the free list.
+		int child1;
+		int child2;
+		int height; // 0 for a leaf, -1 while free.
+		int circle; // -1 unless this is a leaf.
+	};
+
+	// The nodes all live in one array and point at each other by index.  A tree with
+	// N leaves always has exactly N - 1 inner nodes, so we never need more than 2N.
+	Node* nodes;
+	int nodeCapacity;
+	int freeList;
+	int root;
+
+	int* leafNode;
+
+	struct Contact{
+		int i;
+		int j;
+	};
+	std::vector<Contact> contacts;
+
+	// Our own stack of node pairs for walking the tree, so we don't have to recurse.
+	std::vector<int> pairStack;
+
+	int AllocateNode();
+	void FreeNode(int index);
+	void InsertLeaf(int leaf);
+	void RemoveLeaf(int leaf);
+	void Refit(int index);
+	int Balance(int index);
+	void SetFatBox(int leaf, int circle);
+};
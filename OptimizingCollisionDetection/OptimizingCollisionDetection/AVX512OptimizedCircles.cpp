@@ -0,0 +1,194 @@
+/*
+Title: Optimizing Collision Detection
+File Name: AVX512OptimizedCircles.cpp
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+Optimization of AVXOptimizedCircles.cpp with AVX-512, 16 circles at a time, using
+mask registers for the comparison results.
+
+References:
+https://software.intel.com/sites/landingpage/IntrinsicsGuide/
+*/
+#include "AVX512OptimizedCircles.h"
+#include "Platform.h"
+#include "HelperFunctions.h"
+
+AVX512OptimizedCircles::AVX512OptimizedCircles(int numCircles)
+{
+	// A zmm register is 64 bytes, which also happens to be a whole cache line.
+	this->numCircles = numCircles;
+	paddedCircles = Helper::PadCircles(numCircles, 16);
+
+	xPosition = (float*)_aligned_malloc(paddedCircles * sizeof(float), 64);
+	xVelocity = (float*)_aligned_malloc(paddedCircles * sizeof(float), 64);
+	yPosition = (float*)_aligned_malloc(paddedCircles * sizeof(float), 64);
+	yVelocity = (float*)_aligned_malloc(paddedCircles * sizeof(float), 64);
+	radius = (float*)_aligned_malloc(paddedCircles * sizeof(float), 64);
+
+	memset(xPosition, 0, paddedCircles * sizeof(float));
+	memset(xVelocity, 0, paddedCircles * sizeof(float));
+	memset(yPosition, 0, paddedCircles * sizeof(float));
+	memset(yVelocity, 0, paddedCircles * sizeof(float));
+	memset(radius, 0, paddedCircles * sizeof(float));
+	isCollided = (float**)malloc(sizeof(float*) * numCircles);
+
+	for (int i = 0; i < numCircles; ++i){
+		xPosition[i] = Helper::RandomFloat(0, 1000.0f);
+		yPosition[i] = Helper::RandomFloat(0, 1000.0f);
+		xVelocity[i] = Helper::RandomFloat(-1.0f, 1.0f);
+		yVelocity[i] = Helper::RandomFloat(-1.0f, 1.0f);
+		radius[i] = Helper::RandomFloat(5.0f, 100.0f);
+
+		isCollided[i] = (float*)_aligned_malloc(sizeof(float) * paddedCircles, 64);
+		memset(isCollided[i], 0, sizeof(float) * paddedCircles);
+	}
+
+	wordsPerRow = CollisionBits::WordsPerRow(numCircles);
+	collisionBits = (unsigned int*)_aligned_malloc(sizeof(unsigned int) * wordsPerRow * numCircles, 64);
+	memset(collisionBits, 0, sizeof(unsigned int) * wordsPerRow * numCircles);
+}
+
+AVX512OptimizedCircles::~AVX512OptimizedCircles()
+{
+	_aligned_free(xPosition);
+	_aligned_free(yPosition);
+	_aligned_free(xVelocity);
+	_aligned_free(yVelocity);
+	_aligned_free(radius);
+	_aligned_free(collisionBits);
+
+	for (int i = 0; i < numCircles; ++i){
+		_aligned_free(isCollided[i]);
+	}
+	free(isCollided);
+}
+
+#ifdef HAS_AVX512_INTRINSICS
+
+TARGET_AVX512 void AVX512OptimizedCircles::Update(){
+	for (int i = 0; i < paddedCircles; i += 16){
+		_mm512_store_ps(xPosition + i, _mm512_add_ps(_mm512_load_ps(xPosition + i), _mm512_load_ps(xVelocity + i)));
+		_mm512_store_ps(yPosition + i, _mm512_add_ps(_mm512_load_ps(yPosition + i), _mm512_load_ps(yVelocity + i)));
+	}
+}
+
+TARGET_AVX512 void AVX512OptimizedCircles::CheckForCollisions(){
+	// Here's the big change from SSE and AVX.  Those compares give back a whole register
+	// of all 1s or all 0s per lane, and to get bits out of that you need movemask.
+	// AVX-512 compares write straight into a mask register instead: k0 through k7, one bit
+	// per lane.  Almost every AVX-512 instruction can then take a mask, and only touch the
+	// lanes whose bit is set.
+	const __m512 allTrue = _mm512_castsi512_ps(_mm512_set1_epi32(-1));
+
+	// numCircles doesn't have to be a multiple of 16.  The lanes in the last group past
+	// the end are padding, so they get left out of the loads, the compare and the store
+	// entirely with this mask.
+	const __mmask16 lastLanes = (__mmask16)(numCircles % 16 == 0 ? 0xFFFF : (1 << (numCircles % 16)) - 1);
+
+	for (int i = 0; i < numCircles; ++i){
+		__m512 xPos = _mm512_set1_ps(xPosition[i]);
+		__m512 yPos = _mm512_set1_ps(yPosition[i]);
+		__m512 rad = _mm512_set1_ps(radius[i]);
+
+		float* row = isCollided[i];
+
+		for (int j = i & ~15; j < numCircles; j += 16){
+			__mmask16 lanes = j + 16 <= numCircles ? (__mmask16)0xFFFF : lastLanes;
+
+			// maskz means "zero the lanes whose bit isn't set".  For a load that means the
+			// lanes past the end aren't even read.
+			__m512 xDif = _mm512_sub_ps(_mm512_maskz_load_ps(lanes, xPosition + j), xPos);
+			__m512 yDif = _mm512_sub_ps(_mm512_maskz_load_ps(lanes, yPosition + j), yPos);
+			__m512 radiusAdd = _mm512_add_ps(_mm512_maskz_load_ps(lanes, radius + j), rad);
+
+			__m512 distance = _mm512_fmadd_ps(yDif, yDif, _mm512_mul_ps(xDif, xDif));
+
+			// Only the lanes in "lanes" get compared, the rest come out 0.
+			__mmask16 hit = _mm512_mask_cmp_ps_mask(lanes, distance, _mm512_mul_ps(radiusAdd, radiusAdd), _CMP_LT_OQ);
+
+			// And maskz on a mov turns the mask back into the all 1s or all 0s floats
+			// everyone else writes, in one instruction.  The masked store leaves anything
+			// past the end of the row alone.
+			_mm512_mask_store_ps(row + j, lanes, _mm512_maskz_mov_ps(hit, allTrue));
+		}
+	}
+}
+
+TARGET_AVX512 void AVX512OptimizedCircles::CheckForCollisionsPacked(){
+	// And this is where mask registers really pay off.  The mask already is the 16 bits
+	// we want for the bit matrix, so we just store it.  No movemask, no shifting 4 bits at
+	// a time like SIMDOptimizedCircles has to.
+	const __mmask16 lastLanes = (__mmask16)(numCircles % 16 == 0 ? 0xFFFF : (1 << (numCircles % 16)) - 1);
+
+	for (int i = 0; i < numCircles; ++i){
+		__m512 xPos = _mm512_set1_ps(xPosition[i]);
+		__m512 yPos = _mm512_set1_ps(yPosition[i]);
+		__m512 rad = _mm512_set1_ps(radius[i]);
+
+		// Each row of words read as 16 bit halves.  x86 is little endian, so half h is the
+		// low or high half of word h / 2, and bit b of half h is still pair h * 16 + b.
+		unsigned short* row = (unsigned short*)(collisionBits + i * wordsPerRow);
+
+		for (int j = i & ~15; j < numCircles; j += 16){
+			__mmask16 lanes = j + 16 <= numCircles ? (__mmask16)0xFFFF : lastLanes;
+
+			__m512 xDif = _mm512_sub_ps(_mm512_maskz_load_ps(lanes, xPosition + j), xPos);
+			__m512 yDif = _mm512_sub_ps(_mm512_maskz_load_ps(lanes, yPosition + j), yPos);
+			__m512 radiusAdd = _mm512_add_ps(_mm512_maskz_load_ps(lanes, radius + j), rad);
+
+			__m512 distance = _mm512_fmadd_ps(yDif, yDif, _mm512_mul_ps(xDif, xDif));
+
+			row[j >> 4] = (unsigned short)_mm512_mask_cmp_ps_mask(lanes, distance, _mm512_mul_ps(radiusAdd, radiusAdd), _CMP_LT_OQ);
+		}
+	}
+}
+
+#else
+
+// This compiler doesn't know AVX-512, so there's nothing to run.  Platform::SupportsAVX512()
+// says no on this build, so main.cpp never calls these.
+void AVX512OptimizedCircles::Update(){}
+void AVX512OptimizedCircles::CheckForCollisions(){}
+void AVX512OptimizedCircles::CheckForCollisionsPacked(){}
+
+#endif
+
+int AVX512OptimizedCircles::CountMismatches(){
+	int mismatches = 0;
+
+	for (int i = 0; i < numCircles; ++i){
+		for (int j = i + 1; j < numCircles; ++j){
+			bool expected = (xPosition[i] - xPosition[j]) * (xPosition[i] - xPosition[j])
+				+ (yPosition[i] - yPosition[j]) * (yPosition[i] - yPosition[j])
+				< (radius[i] + radius[j]) * (radius[i] + radius[j]);
+			mismatches += expected != (isCollided[i][j] != 0.0f);
+			mismatches += expected != CollisionBits::Get(collisionBits, wordsPerRow, i, j);
+		}
+	}
+
+	return mismatches;
+}
+
+// 16 at a time is twice as much work per instruction as AVX, but don't expect twice the
+// speed.  At 1000 circles the float matrix is 4MB, and writing it is a lot of what we're
+// timing, so the packed version is the one to watch.  Some chips also slow their clock
+// down a little while running AVX-512.
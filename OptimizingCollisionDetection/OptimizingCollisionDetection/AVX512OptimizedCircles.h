@@ -0,0 +1,61 @@
+/*
+Title: Optimizing Collision Detection
+File Name: AVX512OptimizedCircles.h
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+Optimization of AVXOptimizedCircles.cpp with AVX-512, 16 circles at a time, using
+mask registers for the comparison results.
+*/
+#pragma once
+#include "Settings.h"
+#include "CollisionBits.h"
+
+class AVX512OptimizedCircles
+{
+public:
+	float* xPosition;
+	float* xVelocity;
+	float* yPosition;
+	float* yVelocity;
+	float* radius;
+
+	// 16 at a time now, so pad to a multiple of 16.
+	int numCircles;
+	int paddedCircles;
+
+	float** isCollided;
+
+	// Same layout as SIMDOptimizedCircles::collisionBits, see CollisionBits.h.
+	unsigned int* collisionBits;
+	int wordsPerRow;
+
+	AVX512OptimizedCircles(int numCircles = NUM_CIRCLES);
+	~AVX512OptimizedCircles();
+
+	void Update();
+	void CheckForCollisions();
+	void CheckForCollisionsPacked();
+
+	// Checks isCollided and collisionBits against the plain C++ test and returns how many
+	// pairs (j > i) either one gets wrong.  Should always be 0.
+	int CountMismatches();
+};
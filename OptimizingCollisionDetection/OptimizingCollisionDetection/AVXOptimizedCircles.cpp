@@ -22,155 +22,162 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 Description:
-Optimization of SIMDOptimizedCircle.cpp with inline assembly and AVX operations.
+Optimization of SIMDOptimizedCircle.cpp with AVX2 and FMA intrinsics.
 
 References:
-http://www.cs.virginia.edu/~evans/cs216/guides/x86.html
+https://software.intel.com/sites/landingpage/IntrinsicsGuide/
 */
 #include "AVXOptimizedCircles.h"
+#include "Platform.h"
 #include "HelperFunctions.h"
 
-AVXOptimizedCircles::AVXOptimizedCircles()
+AVXOptimizedCircles::AVXOptimizedCircles(int numCircles, Arena* arena)
 {
+	// Same as the SIMD version, except AVX registers are 32 bytes wide, so everything is
+	// 32 byte aligned instead of 16.  Everything is also padded out to a multiple of 8 so
+	// the last group of 8 never reads or writes off the end.  The padding circles sit at
+	// the origin with no radius or velocity, and nobody ever reads their results.
+	this->numCircles = numCircles;
+	paddedCircles = Helper::PadCircles(numCircles, 8);
+
+	// One block for everything, the same as SIMDOptimizedCircles.  Cache line alignment
+	// covers the 32 bytes AVX wants.
+	ownArena = 0;
+	if (!arena){
+		arena = ownArena = new Arena(MemoryNeeded(numCircles));
+	}
+	arena->Require(MemoryNeeded(numCircles), "AVXOptimizedCircles");
+
+	boolTest = arena->Allocate<float>(4);
+	xPosition = arena->Allocate<float>(paddedCircles);
+	xVelocity = arena->Allocate<float>(paddedCircles);
+	yPosition = arena->Allocate<float>(paddedCircles);
+	yVelocity = arena->Allocate<float>(paddedCircles);
+	radius = arena->Allocate<float>(paddedCircles);
+
+	// This used to be sizeof(float) * NUM_CIRCLES, which only worked because a pointer
+	// and a float are both 4 bytes in a 32 bit build.  In a 64 bit build it's half the
+	// size it needs to be.
+	isCollided = arena->Allocate<float*>(numCircles);
+
+	for (int i = 0; i < paddedCircles; ++i){
+		xPosition[i] = 0.0f;
+		yPosition[i] = 0.0f;
+		xVelocity[i] = 0.0f;
+		yVelocity[i] = 0.0f;
+		radius[i] = 0.0f;
+	}
 
-	// This stuff is all the same as the SIMD stuff because we'll be using the 
-	// SSE x86 instruction set of assembly instructions.
-	boolTest = (float*)_aligned_malloc(4 * sizeof(float), 32);
-	xPosition = (float*)_aligned_malloc(NUM_CIRCLES * sizeof(float), 32);
-	xVelocity = (float*)_aligned_malloc(NUM_CIRCLES * sizeof(float), 32);
-	yPosition = (float*)_aligned_malloc(NUM_CIRCLES * sizeof(float), 32);
-	yVelocity = (float*)_aligned_malloc(NUM_CIRCLES * sizeof(float), 32);
-	radius = (float*)_aligned_malloc(NUM_CIRCLES * sizeof(float), 32);
-
-	isCollided = (float**)_aligned_malloc(sizeof(float) * NUM_CIRCLES, 32);
-
-	for (int i = 0; i < NUM_CIRCLES; ++i){
+	for (int i = 0; i < numCircles; ++i){
 		xPosition[i] = Helper::RandomFloat(0, 100.0f);
 		yPosition[i] = Helper::RandomFloat(0, 100.0f);
 		xVelocity[i] = Helper::RandomFloat(-5.0f, 5.0f);
 		yVelocity[i] = Helper::RandomFloat(-5.0f, 5.0f);
 		radius[i] = Helper::RandomFloat(5.0f, 100.0f);
 
-		isCollided[i] = (float*)_aligned_malloc(sizeof(float) * NUM_CIRCLES, 32);
-		memset(isCollided[i], 0, sizeof(float) * NUM_CIRCLES);
+		isCollided[i] = arena->Allocate<float>(paddedCircles);
+		memset(isCollided[i], 0, sizeof(float) * paddedCircles);
 	}
-
-	int b = 0;
 }
 
 AVXOptimizedCircles::~AVXOptimizedCircles()
 {
-	_aligned_free(boolTest);
-	_aligned_free(xPosition);
-	_aligned_free(yPosition);
-	_aligned_free(xVelocity);
-	_aligned_free(yVelocity);
-	_aligned_free(radius);
-
-	for (int i = 0; i < NUM_CIRCLES; ++i){
-		_aligned_free(isCollided[i]);
-	}
-	_aligned_free(isCollided);
+	delete ownArena;
 }
 
-void AVXOptimizedCircles::Update(){
-
-	/*
-	__asm{
-		mov edi, dword ptr[this]; //edi will contain this.
-		xor esi, esi; //esi will be used as our counter.  Set it to 0.
-
-		mov eax, [edi].xPosition;//eax is the xPosition Register
-		mov ebx, [edi].xVelocity;//ebx is the xVelocity Register
-		mov ecx, [edi].yPosition;//ecx is the yPosition Register
-		mov edx, [edi].yVelocity;//edx is the yVelocity Register
-
-	MovementLoop: //Beginning of a do{...esi+=32}while(esi < NUM_CIRCLES*4) loop.
-
-		vmovaps ymm0, ymmword ptr[eax + esi];//Move the xPosition at index esi into the ymm0 register.
-		vmovaps ymm1, ymmword ptr[ecx + esi];//Move the yPosition at index esi into ymm1
-		vaddps ymm0, ymm0, ymmword ptr[ebx + esi];//Add to the ymm0 register the floats stored at xVelocity + esi.
-		vaddps ymm1, ymm1, ymmword ptr[edx + esi];//Adds to ymm1 the float stored at yVelocity + esi
-		vmovaps ymmword ptr[eax + esi], ymm0;//Store the ymm0 register into xPosition + esi
-		vmovaps ymmword ptr[ecx + esi], ymm1;//Stores ymm1 to yPosition + esi
-
-		add esi, 32;//esi += 32 (it's += 8, but * 4 since a float is four bytes.
-
-		cmp esi, NUM_CIRCLES * 4; //Compare esi to NUM_CIRCLES * 4 (times four to both)
-		jl MovementLoop;// If it's less then jump back up to MovementLoop.
-	}*/
-
+size_t AVXOptimizedCircles::MemoryNeeded(int numCircles){
+	int paddedCircles = Helper::PadCircles(numCircles, 8);
+	return Arena::Footprint(4 * sizeof(float))
+		+ 5 * Arena::Footprint(paddedCircles * sizeof(float))
+		+ Arena::Footprint(numCircles * sizeof(float*))
+		+ numCircles * Arena::Footprint(paddedCircles * sizeof(float));
 }
 
-void AVXOptimizedCircles::CheckForCollisions(){
-	
-	int i = 0;
-
-	/*
-	__asm{
-		mov edi, dword ptr[this];//Move this to edi, edi will store this
-		mov ebx, [edi].xPosition;//store xPosition in ebx
-		mov ecx, [edi].yPosition;//store yPosition in ecx
-		mov edx, [edi].radius;//store radius in edx
-		mov edi, [edi].isCollided;//store isCollided in edi, since we don't need this anymore actually.
-		xor esi, esi;//0 out esi which will be our "i" counter.
-
-	OuterLoop:
-
-		mov eax, esi;//Make a "j" counter that starts at i.  J is in eax
-		and al, 0xE0;//make sure it's a multiple of eight, round down.
-
-
-		// This code sets all parts of the register to the same value.
-		vmovss xmm0, dword ptr[ebx + esi];
-		vmovss xmm1, dword ptr[ecx + esi];
-		vmovss xmm2, dword ptr[edx + esi];
-		vshufps xmm0, xmm0, xmm0, 0;
-		vshufps xmm1, xmm1, xmm1, 0; 
-		vshufps xmm2, xmm2, xmm2, 0;
-		vinsertf128 ymm0, ymm0, xmm0, 1;
-		vinsertf128 ymm1, ymm1, xmm1, 1;
-		vinsertf128 ymm2, ymm2, xmm2, 1;
-
-
-
-		// We don't actually need esi in the program... so this seems okay.
-		mov i, esi;
-		mov esi, dword ptr[edi + esi]; //So that means this code should still function.
-		// So from now on esi is the pointer pointing to the current i's isCollided array in the buffer.
-
-	CollisionStart:
-		vmovaps ymm3, ymmword ptr[ebx + eax];//So load the current 4 xPositions into xmm3.
-		vmovaps ymm4, ymmword ptr[ecx + eax];//xmm4 is the yPositions
-		vmovaps ymm5, ymmword ptr[edx + eax];//xmm5 is the radiuses.
-		// Note that since we stored the xPosition, yPosition, and zPosition into buffers without
-		// worrying about temp storage we could really really quickly load the right ones here.
-
-		vsubps ymm3, ymm3, ymm0;//(x2-x1)
-		vsubps ymm4, ymm4, ymm1;//(y2-y1)
-		vaddps ymm5, ymm5, ymm2;//(r1+r2)
-		vmulps ymm3, ymm3, ymm3;//(x2-x1)^2
-		vmulps ymm4, ymm4, ymm4;//(y2-y1)^2
-		vmulps ymm5, ymm5, ymm5;//(r1 + r2)^2
-		vaddps ymm3, ymm3, ymm4;//(x2-x1)^2 + (y2-y1)^2
-
-		vcmpltps ymm3, ymm3, ymm5;//(x2-x1)^2 + (y2-y1)^2 < (r1+r2)^2
-
-
-		vmovaps ymmword ptr[esi + eax], ymm3;//Store the result into isCollided[i] + j (esi + j)
-
-		add eax, 32;// Push j up by 8, multiplied by 4 because it's a floating point and that's 4 bytes.
-		cmp eax, NUM_CIRCLES * 4;//Multiply j by 4, multiply this by 4.
-		jl CollisionStart;//Jump if less than, yadah yadah.
+// This used to be 32 bit Visual Studio inline assembly, commented out so the project
+// would still run on machines without AVX.  Inline assembly doesn't exist at all in a
+// 64 bit Visual Studio build, or look anything like this in GCC or Clang, so here it is
+// again with intrinsics.  main.cpp asks the CPU whether it has AVX2 before calling us.
+//
+// TARGET_AVX2 (see Platform.h) lets GCC and Clang use AVX2 in just these functions.
+TARGET_AVX2 void AVXOptimizedCircles::Update(){
+	for (int i = 0; i < paddedCircles; i += 8){
+		_mm256_store_ps(xPosition + i, _mm256_add_ps(_mm256_load_ps(xPosition + i), _mm256_load_ps(xVelocity + i)));
+		_mm256_store_ps(yPosition + i, _mm256_add_ps(_mm256_load_ps(yPosition + i), _mm256_load_ps(yVelocity + i)));
+	}
+}
 
-		mov esi, i;
+TARGET_AVX2 void AVXOptimizedCircles::CheckForCollisions(){
+	// Every row ends at the same place, so the last group of 8 (the one that might hang
+	// off the end) is the same group in every row.  Work out which of its lanes are real
+	// circles once, up here: lane k is real if there are more than k circles left.
+	int lastGroup = numCircles & ~7;
+	__m256i lastLanes = _mm256_cmpgt_epi32(_mm256_set1_epi32(numCircles - lastGroup),
+		_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+	for (int i = 0; i < numCircles; ++i){
+		// Broadcast copies one float into all 8 lanes, which took 6 instructions in the
+		// old assembly (shuffle into the low half, then copy that into the high half).
+		__m256 xPos = _mm256_broadcast_ss(xPosition + i);
+		__m256 yPos = _mm256_broadcast_ss(yPosition + i);
+		__m256 rad = _mm256_broadcast_ss(radius + i);
+
+		float* row = isCollided[i];
+
+		// Round down to a multiple of 8.  The old assembly did "and al, 0xE0" here, which
+		// only looked at the low byte of j and rounded to 32 bytes, so the same trick
+		// SIMDOptimizedCircles used but in bytes.  ~7 is the same idea in floats, and it
+		// keeps working past i = 255.
+		int j = i & ~7;
+
+		for (; j < lastGroup; j += 8){
+			__m256 xDif = _mm256_sub_ps(_mm256_load_ps(xPosition + j), xPos);
+			__m256 yDif = _mm256_sub_ps(_mm256_load_ps(yPosition + j), yPos);
+			__m256 radiusAdd = _mm256_add_ps(_mm256_load_ps(radius + j), rad);
+
+			// FMA is the new part.  Fused multiply add does a * b + c in one instruction,
+			// and only rounds once at the end instead of after the multiply and the add.
+			// So (x2-x1)^2 + (y2-y1)^2 is one multiply and one FMA instead of two
+			// multiplies and an add.
+			__m256 distance = _mm256_fmadd_ps(yDif, yDif, _mm256_mul_ps(xDif, xDif));
+
+			// AVX compares take the comparison as a number instead of having one
+			// instruction per comparison.  _CMP_LT_OQ is less than, false if either is NaN.
+			__m256 result = _mm256_cmp_ps(distance, _mm256_mul_ps(radiusAdd, radiusAdd), _CMP_LT_OQ);
+
+			_mm256_store_ps(row + j, result);
+		}
+
+		// The leftovers.  maskload only reads the lanes in the mask (the rest come back 0)
+		// and maskstore only writes them, so nothing past numCircles gets touched.  It's
+		// still a whole group of 8 at once, not a little loop one circle at a time.
+		if (j < numCircles){
+			__m256 xDif = _mm256_sub_ps(_mm256_maskload_ps(xPosition + j, lastLanes), xPos);
+			__m256 yDif = _mm256_sub_ps(_mm256_maskload_ps(yPosition + j, lastLanes), yPos);
+			__m256 radiusAdd = _mm256_add_ps(_mm256_maskload_ps(radius + j, lastLanes), rad);
+
+			__m256 distance = _mm256_fmadd_ps(yDif, yDif, _mm256_mul_ps(xDif, xDif));
+			_mm256_maskstore_ps(row + j, lastLanes,
+				_mm256_cmp_ps(distance, _mm256_mul_ps(radiusAdd, radiusAdd), _CMP_LT_OQ));
+		}
+	}
+}
 
-		add esi, 4;//increase i by 1 * 4.
-		cmp esi, NUM_CIRCLES * 4;//*4 for both.
-		jl OuterLoop;
+int AVXOptimizedCircles::CountMismatches(){
+	int mismatches = 0;
+
+	for (int i = 0; i < numCircles; ++i){
+		for (int j = i + 1; j < numCircles; ++j){
+			// The FMA only rounds once, so a pair sitting right on the edge could come out
+			// the other way here.  With random floats that basically never happens.
+			bool expected = (xPosition[i] - xPosition[j]) * (xPosition[i] - xPosition[j])
+				+ (yPosition[i] - yPosition[j]) * (yPosition[i] - yPosition[j])
+				< (radius[i] + radius[j]) * (radius[i] + radius[j]);
+			bool actual = isCollided[i][j] != 0.0f;
+			mismatches += expected != actual;
+		}
 	}
-	*/
 
+	return mismatches;
 }
 
 // I wish someone told me AVX existed before.  This is so good.
\ No newline at end of file
@@ -22,16 +22,20 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 Description:
-Optimization of SIMDOptimizedCircle.cpp with inline assembly and AVX instructions.
+Optimization of SIMDOptimizedCircle.cpp with AVX2 and FMA instructions.
 */
 #pragma once
 #include "Settings.h"
+#include "Arena.h"
 
 class AVXOptimizedCircles
 {
 private:
 	float* boolTest;
 
+	// The arena this made for itself, or 0 if it was handed one.
+	Arena* ownArena;
+
 public:
 	float* xPosition;
 	float* xVelocity;
@@ -39,13 +43,24 @@ public:
 	float* yVelocity;
 	float* radius;
 
-
+	// AVX does 8 at a time, so the arrays and rows get padded out to a multiple of 8.
+	int numCircles;
+	int paddedCircles;
 
 	float** isCollided;
 
-	AVXOptimizedCircles();
+	// Everything is carved out of one Arena.  Pass one in to share it, or to Reset() it
+	// and build the next world in the same memory.  Leave it out and this makes its own.
+	AVXOptimizedCircles(int numCircles = NUM_CIRCLES, Arena* arena = 0);
 	~AVXOptimizedCircles();
 
+	// How big an Arena has to be to hold one of these.
+	static size_t MemoryNeeded(int numCircles);
+
 	void Update();
 	void CheckForCollisions();
+
+	// Checks isCollided against the plain C++ test and returns how many pairs (j > i)
+	// disagree.  Should always be 0.
+	int CountMismatches();
 };
@@ -0,0 +1,178 @@
+/*
+Title: Optimizing Collision Detection
+File Name: Arena.cpp
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+A bump allocator over one cache line aligned block, so a whole world can be
+allocated, and thrown away, all at once.
+*/
+
+#include "Arena.h"
+#include "Platform.h"
+#include <cstdio>
+#include <cstdlib>
+
+#ifdef _MSC_VER
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+// Huge pages are 2MB on x86-64, on both Windows and Linux.
+static const size_t hugePageSize = 2 * 1024 * 1024;
+
+
+Arena::Arena(size_t capacity, bool hugePages)
+{
+	this->capacity = Footprint(capacity);
+	used = 0;
+	block = 0;
+	this->hugePages = false;
+	fromVirtualAlloc = false;
+
+	if (hugePages){
+		size_t hugeCapacity = (this->capacity + hugePageSize - 1) & ~(hugePageSize - 1);
+#ifdef _MSC_VER
+		// Windows calls them large pages, and only hands them out to users with the "Lock
+		// pages in memory" right.  Most people don't have it, so this usually fails and
+		// we fall through to normal pages below.
+		if (GetLargePageMinimum() == hugePageSize){
+			block = (char*)VirtualAlloc(0, hugeCapacity, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+			if (block){
+				this->capacity = hugeCapacity;
+				this->hugePages = true;
+				fromVirtualAlloc = true;
+			}
+		}
+#else
+		// Linux calls them transparent huge pages.  Line the block up on a 2MB boundary and
+		// ask nicely.  The kernel may still say no (it's off on some systems), in which case
+		// the memory is fine, it's just in 4KB pages.
+		block = (char*)_aligned_malloc(hugeCapacity, hugePageSize);
+		if (block){
+			this->capacity = hugeCapacity;
+#ifdef MADV_HUGEPAGE
+			this->hugePages = madvise(block, hugeCapacity, MADV_HUGEPAGE) == 0;
+#endif
+		}
+#endif
+	}
+
+	if (!block){
+		block = (char*)_aligned_malloc(this->capacity, CACHE_LINE_SIZE);
+	}
+}
+
+Arena::~Arena()
+{
+#ifdef _MSC_VER
+	if (fromVirtualAlloc){
+		VirtualFree(block, 0, MEM_RELEASE);
+		return;
+	}
+#endif
+	_aligned_free(block);
+}
+
+void* Arena::Allocate(size_t bytes){
+	size_t size = Footprint(bytes);
+	Require(size, "Arena::Allocate");
+
+	void* memory = block + used;
+	used += size;
+	return memory;
+}
+
+void Arena::Reset(){
+	used = 0;
+}
+
+size_t Arena::Used(){
+	return used;
+}
+
+void Arena::Require(size_t bytes, const char* who){
+	if (bytes > Remaining()){
+		std::fprintf(stderr, "%s needs %llu bytes, but the arena only has %llu of %llu left.\n", who,
+			(unsigned long long)bytes, (unsigned long long)Remaining(), (unsigned long long)capacity);
+		std::abort();
+	}
+}
+
+size_t Arena::Capacity(){
+	return capacity;
+}
+
+size_t Arena::Remaining(){
+	return capacity - used;
+}
+
+bool Arena::HugePages(){
+	return hugePages;
+}
+
+size_t Arena::HugePageBytes(){
+#ifdef _MSC_VER
+	// Large pages on Windows are locked in when VirtualAlloc hands them over, so if we
+	// got the block that way, all of it is huge pages.
+	return fromVirtualAlloc ? capacity : 0;
+#else
+	// madvise returning 0 only means the kernel heard us.  Whether it actually found
+	// 2MB pages to use is in /proc/self/smaps, as AnonHugePages on the mappings our
+	// block lives in.  Pages only get backed once they're touched, so ask after the
+	// world has been built, not right after the constructor.
+	if (!hugePages){
+		return 0;
+	}
+
+	std::FILE* smaps = std::fopen("/proc/self/smaps", "r");
+	if (!smaps){
+		return 0;
+	}
+
+	unsigned long long blockStart = (unsigned long long)(size_t)block;
+	unsigned long long blockEnd = blockStart + capacity;
+	bool inBlock = false;
+	size_t hugeBytes = 0;
+	char line[512];
+	while (std::fgets(line, sizeof(line), smaps)){
+		unsigned long long start, end, kilobytes;
+		// Each mapping starts with a "start-end perms ..." line, and the fields for it
+		// follow until the next one.
+		if (std::sscanf(line, "%llx-%llx ", &start, &end) == 2){
+			inBlock = start < blockEnd && end > blockStart;
+		}
+		else if (inBlock && std::sscanf(line, "AnonHugePages: %llu kB", &kilobytes) == 1){
+			hugeBytes += (size_t)kilobytes * 1024;
+		}
+	}
+	std::fclose(smaps);
+
+	return hugeBytes < capacity ? hugeBytes : capacity;
+#endif
+}
@@ -0,0 +1,88 @@
+/*
+Title: Optimizing Collision Detection
+File Name: Arena.h
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+A bump allocator over one cache line aligned block, so a whole world can be
+allocated, and thrown away, all at once.
+*/
+#pragma once
+#include <cstddef>
+#include "Settings.h"
+
+class Arena
+{
+public:
+	// One block of memory, allocated once, that everything else gets carved out of.
+	// Carving is just moving a pointer forward, and there's no freeing things one at a
+	// time: Reset() hands the whole block back at once, and the destructor frees it.
+	//
+	// hugePages asks the OS to back the block with 2MB pages instead of 4KB ones, so a
+	// few MB of isCollided is a couple of TLB entries instead of a thousand.  If the OS
+	// says no, you just get normal pages.  HugePages() says whether the OS took the
+	// request, which on Linux is only a promise to try.  HugePageBytes() says how much
+	// of the block it actually backed with them.
+	Arena(size_t capacity, bool hugePages = false);
+	~Arena();
+
+	// Every allocation starts on its own cache line, which covers the 16 and 32 byte
+	// alignment SSE and AVX want.  Running out of room is a bug in whoever sized the
+	// arena, so rather than hand back 0 for someone to write through, it says so and
+	// stops the program.
+	void* Allocate(size_t bytes);
+
+	template<class T>
+	T* Allocate(size_t count){
+		return (T*)Allocate(sizeof(T) * count);
+	}
+
+	// Forgets everything allocated so far, without giving anything back to the OS.  The
+	// next world built in here reuses the same memory, pages and all.
+	void Reset();
+
+	// Call this before carving anything up, with everything you're about to allocate,
+	// so running out of room fails right away and says who was short, instead of halfway
+	// through building a world.
+	void Require(size_t bytes, const char* who);
+
+	size_t Used();
+	size_t Capacity();
+	size_t Remaining();
+	bool HugePages();
+	size_t HugePageBytes();
+
+	// How much of the arena an allocation of this many bytes really takes up, once it's
+	// rounded up to a whole cache line.  Add these up to size an arena.
+	static size_t Footprint(size_t bytes){
+		return (bytes + CACHE_LINE_SIZE - 1) & ~(size_t)(CACHE_LINE_SIZE - 1);
+	}
+
+private:
+	char* block;
+	size_t capacity;
+	size_t used;
+	bool hugePages;
+	bool fromVirtualAlloc;
+
+	Arena(const Arena&);
+	Arena& operator=(const Arena&);
+};
@@ -29,49 +29,83 @@ http://www.cs.virginia.edu/~evans/cs216/guides/x86.html
 */
 #include "AssemblyOptimizedCircles.h"
 #include "HelperFunctions.h"
-//Look ma, no fancy includes.
-
-AssemblyOptimizedCircles::AssemblyOptimizedCircles()
+#include "Platform.h"
+//Look ma, no fancy includes.  (Platform.h is only for the 64 bit version, see below.)
+
+// Visual Studio only allows __asm blocks in 32 bit x86 builds.  Everywhere else the
+// assembly lives in AssemblyKernels_x64.S, which is written for 64 bit Linux, and we call
+// it like any other function.  Anything that's neither (64 bit Visual Studio, for one)
+// falls back on the same intrinsics as SIMDOptimizedCircles.cpp.
+#if defined(_MSC_VER) && defined(_M_IX86)
+#define ASSEMBLY_INLINE_X86
+#elif defined(__x86_64__) && !defined(_MSC_VER)
+#define ASSEMBLY_SYSV_X64
+extern "C" void AssemblyUpdate_x64(float* xPosition, float* yPosition,
+	const float* xVelocity, const float* yVelocity, int numCircles);
+extern "C" void AssemblyCheckForCollisions_x64(const float* xPosition, const float* yPosition,
+	const float* radius, float** isCollided, int numCircles);
+#endif
+
+AssemblyOptimizedCircles::AssemblyOptimizedCircles(int numCircles, Arena* arena)
 {
 
 	// This stuff is all the same as the SIMD stuff because we'll be using the 
-	// SSE x86 instruction set of assembly instructions.
-	boolTest = (float*)_aligned_malloc(4 * sizeof(float), 16);
-	xPosition = (float*)_aligned_malloc(NUM_CIRCLES * sizeof(float), 16);
-	xVelocity = (float*)_aligned_malloc(NUM_CIRCLES * sizeof(float), 16);
-	yPosition = (float*)_aligned_malloc(NUM_CIRCLES * sizeof(float), 16);
-	yVelocity = (float*)_aligned_malloc(NUM_CIRCLES * sizeof(float), 16);
-	radius = (float*)_aligned_malloc(NUM_CIRCLES * sizeof(float), 16);
+	// SSE x86 instruction set of assembly instructions.  That includes the padding out to
+	// a multiple of 4 with circles that can't collide, which the 32 bit assembly relies
+	// on.  (The 64 bit assembly masks off the end instead, so it doesn't need it.)
+	this->numCircles = numCircles;
+	paddedCircles = Helper::PadCircles(numCircles, 4);
+
+	// One block for everything, the same as SIMDOptimizedCircles.
+	ownArena = 0;
+	if (!arena){
+		arena = ownArena = new Arena(MemoryNeeded(numCircles));
+	}
+	arena->Require(MemoryNeeded(numCircles), "AssemblyOptimizedCircles");
 
-	isCollided = (float**)_aligned_malloc(sizeof(float) * NUM_CIRCLES, 16);
+	boolTest = arena->Allocate<float>(4);
+	xPosition = arena->Allocate<float>(paddedCircles);
+	xVelocity = arena->Allocate<float>(paddedCircles);
+	yPosition = arena->Allocate<float>(paddedCircles);
+	yVelocity = arena->Allocate<float>(paddedCircles);
+	radius = arena->Allocate<float>(paddedCircles);
 
-	for (int i = 0; i < NUM_CIRCLES; ++i){
+	// sizeof(float*), not sizeof(float).  They're the same in a 32 bit build, but the 64
+	// bit version needs twice the room.  Allocate<float*> gets that right on its own.
+	isCollided = arena->Allocate<float*>(numCircles);
+
+	for (int i = 0; i < numCircles; ++i){
 		xPosition[i] = Helper::RandomFloat(0, 100.0f);
 		yPosition[i] = Helper::RandomFloat(0, 100.0f);
 		xVelocity[i] = Helper::RandomFloat(-5.0f, 5.0f);
 		yVelocity[i] = Helper::RandomFloat(-5.0f, 5.0f);
 		radius[i] = Helper::RandomFloat(5.0f, 100.0f);
 
-		isCollided[i] = (float*)_aligned_malloc(sizeof(float) * NUM_CIRCLES, 16);
-		memset(isCollided[i], 0, sizeof(float) * NUM_CIRCLES);
+		isCollided[i] = arena->Allocate<float>(paddedCircles);
+		memset(isCollided[i], 0, sizeof(float) * paddedCircles);
 	}
+	Helper::FillPadding(xPosition, xVelocity, yPosition, yVelocity, radius, numCircles, paddedCircles);
+
+	wordsPerRow = CollisionBits::WordsPerRow(numCircles);
+	collisionBits = arena->Allocate<unsigned int>(wordsPerRow * numCircles);
+	memset(collisionBits, 0, sizeof(unsigned int) * wordsPerRow * numCircles);
 
-	int b = 0;
+	// The 64 bit assembly uses AVX2 and FMA, so only use it if the CPU has them.
+	hasAVX2 = Platform::SupportsAVX2();
 }
 
 AssemblyOptimizedCircles::~AssemblyOptimizedCircles()
 {
-	_aligned_free(boolTest);
-	_aligned_free(xPosition);
-	_aligned_free(yPosition);
-	_aligned_free(xVelocity);
-	_aligned_free(yVelocity);
-	_aligned_free(radius);
-
-	for (int i = 0; i < NUM_CIRCLES; ++i){
-		_aligned_free(isCollided[i]);
-	}
-	_aligned_free(isCollided);
+	delete ownArena;
+}
+
+size_t AssemblyOptimizedCircles::MemoryNeeded(int numCircles){
+	int paddedCircles = Helper::PadCircles(numCircles, 4);
+	return Arena::Footprint(4 * sizeof(float))
+		+ 5 * Arena::Footprint(paddedCircles * sizeof(float))
+		+ Arena::Footprint(numCircles * sizeof(float*))
+		+ numCircles * Arena::Footprint(paddedCircles * sizeof(float))
+		+ Arena::Footprint(CollisionBits::WordsPerRow(numCircles) * numCircles * sizeof(unsigned int));
 }
 
 void AssemblyOptimizedCircles::Update(){
@@ -171,6 +205,11 @@ void AssemblyOptimizedCircles::Update(){
 	//So what's going on?  that seemed like WAY too many instructions for what
 	//was actually happening.
 
+#ifdef ASSEMBLY_INLINE_X86
+	// The size of the arrays isn't a constant anymore, so it can't be baked into the cmp.
+	// Instead it sits in a local, and cmp reads it straight off the stack.
+	int paddedBytes = paddedCircles * 4;
+
 	__asm{
 		mov edi, dword ptr[this]; //edi will contain this.
 		xor esi, esi; //esi will be used as our counter.  Set it to 0.
@@ -180,7 +219,7 @@ void AssemblyOptimizedCircles::Update(){
 		mov ecx, [edi].yPosition;//ecx is the yPosition Register
 		mov edx, [edi].yVelocity;//edx is the yVelocity Register
 
-		MovementLoop: //Beginning of a do{...esi+=16}while(esi < NUM_CIRCLES*4) loop.
+		MovementLoop: //Beginning of a do{...esi+=16}while(esi < paddedCircles*4) loop.
 
 		movaps xmm0, xmmword ptr[eax + esi];//Move the xPosition at index esi into the xmm0 register.
 		movaps xmm1, xmmword ptr[ecx + esi];//Move the yPosition at index esi into xmm1
@@ -198,9 +237,21 @@ void AssemblyOptimizedCircles::Update(){
 
 		add esi, 16;//esi += 16 (it's += 4, but * 4 since a float is four bytes.
 
-		cmp esi, NUM_CIRCLES * 4; //Compare esi to NUM_CIRCLES * 4 (times four to both)
+		cmp esi, paddedBytes; //Compare esi to paddedCircles * 4 (times four to both)
 		jl MovementLoop;// If it's less then jump back up to MovementLoop.
 	}
+#else
+#ifdef ASSEMBLY_SYSV_X64
+	if (hasAVX2){
+		AssemblyUpdate_x64(xPosition, yPosition, xVelocity, yVelocity, numCircles);
+		return;
+	}
+#endif
+	for (int i = 0; i < paddedCircles; i += 4){
+		_mm_store_ps(xPosition + i, _mm_add_ps(_mm_load_ps(xPosition + i), _mm_load_ps(xVelocity + i)));
+		_mm_store_ps(yPosition + i, _mm_add_ps(_mm_load_ps(yPosition + i), _mm_load_ps(yVelocity + i)));
+	}
+#endif
 
 }
 
@@ -342,7 +393,10 @@ do {
 // So it's like the compiler has no awareness of XMM1 - XMM7.  However, I do, so let's see
 // how I use them.
 
+#ifdef ASSEMBLY_INLINE_X86
 int i = 0;
+int numBytes = numCircles * 4;
+int paddedBytes = paddedCircles * 4;
 
 	__asm{
 		mov edi, dword ptr[this];//Move this to edi, edi will store this
@@ -392,7 +446,7 @@ int i = 0;
 		movaps xmmword ptr[esi + eax], xmm3;//Store the result into isCollided[i] + j (esi + j)
 
 		add eax, 16;// Push j up by 4, multiplied by 4 because it's a floating point and that's 4 bytes.
-		cmp eax, NUM_CIRCLES * 4;//Multiply j by 4, multiply this by 4.
+		cmp eax, paddedBytes;//Multiply j by 4, multiply this by 4.
 		jl CollisionStart;//Jump if less than, yadah yadah.
 
 		mov esi, i;//Oh hey look it's i again.  Remember what I said about pulling things out of loops?
@@ -400,10 +454,183 @@ int i = 0;
 		// it went down to 0.19.  Yeah, those sorts of things are important.
 
 		add esi, 4;//increase i by 1 * 4.
-		cmp esi, NUM_CIRCLES * 4;//*4 for both.
+		cmp esi, numBytes;//*4 for both.
 		jl OuterLoop;
 	}
+#else
+#ifdef ASSEMBLY_SYSV_X64
+	// Go read AssemblyKernels_x64.S.  It's this same loop, except with 16 registers to play
+	// with it keeps 4 groups of 8 going at once.
+	if (hasAVX2){
+		AssemblyCheckForCollisions_x64(xPosition, yPosition, radius, isCollided, numCircles);
+		return;
+	}
+#endif
+	for (int i = 0; i < numCircles; ++i){
+		__m128 xPos = _mm_load1_ps(xPosition + i);
+		__m128 yPos = _mm_load1_ps(yPosition + i);
+		__m128 rad = _mm_load1_ps(radius + i);
+		float* row = isCollided[i];
+
+		for (int j = i & ~3; j < paddedCircles; j += 4){
+			__m128 xDif = _mm_sub_ps(xPos, _mm_load_ps(xPosition + j));
+			__m128 yDif = _mm_sub_ps(yPos, _mm_load_ps(yPosition + j));
+			__m128 radiusAdd = _mm_add_ps(rad, _mm_load_ps(radius + j));
+
+			_mm_store_ps(row + j, _mm_cmplt_ps(
+				_mm_add_ps(_mm_mul_ps(xDif, xDif), _mm_mul_ps(yDif, yDif)),
+				_mm_mul_ps(radiusAdd, radiusAdd)));
+		}
+	}
+#endif
+
+}
+
+void AssemblyOptimizedCircles::CheckForCollisionsPacked(){
+
+	// This is CheckForCollisions again, except it writes one bit per pair into
+	// collisionBits (see SIMDOptimizedCircles::CheckForCollisionsPacked for why).
+	// movmskps is the instruction behind _mm_movemask_ps.
+
+	// We're out of general purpose registers here.  eax is j, ebx ecx and edx are the
+	// three arrays, esi points at the word we're filling in, and edi holds the movmskps
+	// result.  So instead of building the word in a register we build it right in
+	// memory: shift the word right by 4 and or the new 4 bits in at the top.  After 8
+	// groups the first group has been pushed all the way down to bits 0-3, which is
+	// exactly where it belongs.  It's the same cache line over and over, so it never
+	// leaves L1, and only the finished word ever gets written back out.
+
+#ifdef ASSEMBLY_INLINE_X86
+	int i = 0;
+	unsigned int* bits = collisionBits;
+	int rowWords = wordsPerRow;
+	int numBytes = numCircles * 4;
+	int paddedBytes = paddedCircles * 4;
+
+	__asm{
+		mov edi, dword ptr[this];//Same setup as before.
+		mov ebx, [edi].xPosition;
+		mov ecx, [edi].yPosition;
+		mov edx, [edi].radius;
+		xor esi, esi;//esi is "i" (times 4).
+
+	OuterLoop:
+
+		mov eax, esi;//j starts at i...
+		and eax, 0xFFFFFF80;//...rounded down to a multiple of 32 (128 bytes).
+
+		movss xmm0, dword ptr[ebx + esi];
+		movss xmm1, dword ptr[ecx + esi];
+		movss xmm2, dword ptr[edx + esi];
+		shufps xmm0, xmm0, 0;
+		shufps xmm1, xmm1, 0;
+		shufps xmm2, xmm2, 0;
+
+		mov i, esi;
+		imul esi, rowWords;//esi = i * bytes per row (i is already times 4)
+		mov edi, eax;
+		shr edi, 5;//j * 4 / 32 is the byte offset of j's word in the row.
+		add esi, edi;
+		add esi, bits;//esi now points at the word holding bit j of row i.
+
+	CollisionStart:
+		movaps xmm3, xmmword ptr[ebx + eax];
+		movaps xmm4, xmmword ptr[ecx + eax];
+		movaps xmm5, xmmword ptr[edx + eax];
+
+		subps xmm3, xmm0;//(x2-x1)
+		subps xmm4, xmm1;//(y2-y1)
+		addps xmm5, xmm2;//(r1+r2)
+		mulps xmm3, xmm3;//(x2-x1)^2
+		mulps xmm4, xmm4;//(y2-y1)^2
+		mulps xmm5, xmm5;//(r1 + r2)^2
+		addps xmm3, xmm4;//(x2-x1)^2 + (y2-y1)^2
+
+		cmpltps xmm3, xmm5;//(x2-x1)^2 + (y2-y1)^2 < (r1+r2)^2
+
+		movmskps edi, xmm3;//Top bit of each of the 4 results into the bottom 4 bits of edi.
+		shl edi, 28;//Move them to the top of the word.
+		shr dword ptr[esi], 4;//Make room...
+		or dword ptr[esi], edi;//...and drop them in.
+
+		add eax, 16;//Next 4 j's.
+		test eax, 127;//Did we just finish a word (32 j's, 128 bytes)?
+		jnz SameWord;
+		add esi, 4;//If so move on to the next one.
+	SameWord:
+		cmp eax, paddedBytes;
+		jl CollisionStart;
+
+		// If paddedCircles isn't a multiple of 32 the last word is only partly filled, and
+		// its bits are still sitting at the top.  Keep shifting until they're at the bottom.
+		test eax, 127;
+		jz RowDone;
+	PadWord:
+		shr dword ptr[esi], 4;
+		add eax, 16;
+		test eax, 127;
+		jnz PadWord;
+
+	RowDone:
+		mov esi, i;
+		add esi, 4;
+		cmp esi, numBytes;
+		jl OuterLoop;
+	}
+#else
+	// No 64 bit assembly for this one yet, so it's SIMDOptimizedCircles::CheckForCollisionsPacked.
+	for (int i = 0; i < numCircles; ++i){
+		__m128 xPos = _mm_load1_ps(xPosition + i);
+		__m128 yPos = _mm_load1_ps(yPosition + i);
+		__m128 rad = _mm_load1_ps(radius + i);
+		unsigned int* row = collisionBits + i * wordsPerRow;
+
+		int j = i & ~31;
+		do {
+			int word = j >> 5;
+			unsigned int bits = 0;
+			for (int shift = 0; shift < 32 && j < paddedCircles; shift += 4, j += 4){
+				__m128 xDif = _mm_sub_ps(xPos, _mm_load_ps(xPosition + j));
+				__m128 yDif = _mm_sub_ps(yPos, _mm_load_ps(yPosition + j));
+				__m128 radiusAdd = _mm_add_ps(rad, _mm_load_ps(radius + j));
+
+				int mask = _mm_movemask_ps(
+					_mm_cmplt_ps(
+						_mm_add_ps(_mm_mul_ps(xDif, xDif), _mm_mul_ps(yDif, yDif)),
+						_mm_mul_ps(radiusAdd, radiusAdd)));
+
+				bits |= (unsigned int)mask << shift;
+			}
+			row[word] = bits;
+		} while (j < paddedCircles);
+	}
+#endif
+
+}
+
+const char* AssemblyOptimizedCircles::Implementation(){
+#if defined(ASSEMBLY_INLINE_X86)
+	return "x86 inline assembly";
+#elif defined(ASSEMBLY_SYSV_X64)
+	return hasAVX2 ? "x86-64 AVX2 assembly" : "SSE intrinsics, no AVX2";
+#else
+	return "SSE intrinsics";
+#endif
+}
+
+int AssemblyOptimizedCircles::CountMismatches(){
+	int mismatches = 0;
+
+	for (int i = 0; i < numCircles; ++i){
+		for (int j = i + 1; j < numCircles; ++j){
+			bool expected = (xPosition[i] - xPosition[j]) * (xPosition[i] - xPosition[j])
+				+ (yPosition[i] - yPosition[j]) * (yPosition[i] - yPosition[j])
+				< (radius[i] + radius[j]) * (radius[i] + radius[j]);
+			mismatches += expected != (isCollided[i][j] != 0.0f);
+		}
+	}
 
+	return mismatches;
 }
 
 // So yeah.
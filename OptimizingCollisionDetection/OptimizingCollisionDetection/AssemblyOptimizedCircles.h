@@ -26,12 +26,17 @@ Optimization of SIMDOptimizedCircle.cpp with inline assembly.
 */
 #pragma once
 #include "Settings.h"
+#include "Arena.h"
+#include "CollisionBits.h"
 
 class AssemblyOptimizedCircles
 {
 private:
 	float* boolTest;
 
+	// The arena this made for itself, or 0 if it was handed one.
+	Arena* ownArena;
+
 public:
 	float* xPosition;
 	float* xVelocity;
@@ -39,13 +44,34 @@ public:
 	float* yVelocity;
 	float* radius;
 
-
+	int numCircles;
+	int paddedCircles;
 
 	float** isCollided;
 
-	AssemblyOptimizedCircles();
+	// One bit per pair instead of one float.  See CollisionBits.h.
+	unsigned int* collisionBits;
+	int wordsPerRow;
+
+	// Everything is carved out of one Arena.  Pass one in to share it, or to Reset() it
+	// and build the next world in the same memory.  Leave it out and this makes its own.
+	AssemblyOptimizedCircles(int numCircles = NUM_CIRCLES, Arena* arena = 0);
 	~AssemblyOptimizedCircles();
 
+	// How big an Arena has to be to hold one of these.
+	static size_t MemoryNeeded(int numCircles);
+
 	void Update();
 	void CheckForCollisions();
+	void CheckForCollisionsPacked();
+
+	// Which version actually runs in this build, on this CPU.  See the top of the .cpp.
+	const char* Implementation();
+
+	// Checks isCollided against the plain C++ test and returns how many pairs (j > i)
+	// disagree.  Should always be 0.
+	int CountMismatches();
+
+private:
+	bool hasAVX2;
 };
@@ -0,0 +1,258 @@
+/*
+Title: Optimizing Collision Detection
+File Name: Autotuner.cpp
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+Times every backend and setting on this machine at startup, picks the fastest,
+and remembers it in a file so the next run can skip straight to it.
+*/
+
+// Visual Studio would rather we used fopen_s.  Plain fopen is fine here.
+#define _CRT_SECURE_NO_WARNINGS
+#include "Autotuner.h"
+#include "Platform.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock TuneClock;
+
+// Tile sizes work stealing gets to try.  Smaller tiles steal better, bigger ones cost
+// less overhead per pair, see the end of WorkStealingCircles.cpp.
+static const int tileSizes[] = { 16, 32, 64, 128, 256 };
+
+Autotuner::Autotuner(int numCircles, const char* cacheFile)
+{
+	this->numCircles = numCircles;
+	this->cacheFile = cacheFile;
+
+	numCores = (int)std::thread::hardware_concurrency();
+	if (numCores < 1){
+		numCores = 1;
+	}
+	Platform::CpuModel(cpuModel);
+
+	fromCache = false;
+	candidatesTried = 0;
+	tuningSeconds = 0.0;
+}
+
+bool Autotuner::FromCache(){
+	return fromCache;
+}
+
+int Autotuner::CandidatesTried(){
+	return candidatesTried;
+}
+
+double Autotuner::TuningSeconds(){
+	return tuningSeconds;
+}
+
+const char* Autotuner::CpuModel(){
+	return cpuModel;
+}
+
+TunedCircles::Config Autotuner::Tune(bool retune){
+	TuneClock::time_point start = TuneClock::now();
+	TunedCircles::Config best;
+	candidatesTried = 0;
+
+	fromCache = !retune && Load(&best);
+	if (fromCache){
+		tuningSeconds = std::chrono::duration<double>(TuneClock::now() - start).count();
+		return best;
+	}
+
+	// Every setting worth trying.  Thread counts go up in powers of 2 and then the core
+	// count itself, so a 12 core machine tries 1, 2, 4, 8 and 12.
+	std::vector<int> threadCounts;
+	for (int threads = 1; threads < numCores; threads *= 2){
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(numCores);
+
+	std::vector<TunedCircles::Config> candidates;
+	TunedCircles::Config candidate;
+	candidate.kernel = DispatchedCircles::BestKernel();
+	candidate.threads = 1;
+	candidate.tileSize = TILE_SIZE;
+	candidate.frameSeconds = 0.0;
+
+	candidate.backend = TunedCircles::BACKEND_DISPATCHED;
+	for (int k = 0; k < DispatchedCircles::KERNEL_COUNT; ++k){
+		if (DispatchedCircles::IsSupported((DispatchedCircles::Kernel)k)){
+			candidate.kernel = (DispatchedCircles::Kernel)k;
+			candidates.push_back(candidate);
+		}
+	}
+	candidate.kernel = DispatchedCircles::BestKernel();
+
+	for (size_t t = 0; t < threadCounts.size(); ++t){
+		candidate.threads = threadCounts[t];
+
+		candidate.backend = TunedCircles::BACKEND_THREADED;
+		candidates.push_back(candidate);
+
+		candidate.backend = TunedCircles::BACKEND_WORK_STEALING;
+		for (size_t s = 0; s < sizeof(tileSizes) / sizeof(tileSizes[0]); ++s){
+			candidate.tileSize = tileSizes[s];
+			candidates.push_back(candidate);
+		}
+		candidate.tileSize = TILE_SIZE;
+	}
+
+	// Winner takes all.  The times are only good to a few percent, so a near tie could go
+	// either way from run to run, but then it doesn't much matter which one we get.
+	for (size_t c = 0; c < candidates.size(); ++c){
+		candidates[c].frameSeconds = Benchmark(candidates[c]);
+		if (c == 0 || candidates[c].frameSeconds < best.frameSeconds){
+			best = candidates[c];
+		}
+	}
+	candidatesTried = (int)candidates.size();
+
+	Save(best);
+	tuningSeconds = std::chrono::duration<double>(TuneClock::now() - start).count();
+	return best;
+}
+
+double Autotuner::Benchmark(const TunedCircles::Config& config){
+	TunedCircles circles(config, numCircles);
+
+	// The first frame pays for faulting in the memory and waking the threads.  A game
+	// only pays that once, so don't count it.
+	circles.Update();
+	circles.CheckForCollisions();
+
+	// clock() would add up every thread's time, which makes threads look slower than one
+	// core, so this uses the wall clock.  Best of three batches, because the best case is
+	// the one that wasn't interrupted by something else on the machine.
+	double bestFrame = 0.0;
+	for (int batch = 0; batch < 3; ++batch){
+		int frames = 0;
+		double seconds = 0.0;
+		TuneClock::time_point start = TuneClock::now();
+		do {
+			circles.Update();
+			circles.CheckForCollisions();
+			++frames;
+			seconds = std::chrono::duration<double>(TuneClock::now() - start).count();
+		} while (seconds < AUTOTUNE_SECONDS);
+
+		if (batch == 0 || seconds / frames < bestFrame){
+			bestFrame = seconds / frames;
+		}
+	}
+	return bestFrame;
+}
+
+// The cache is a text file, one line per CPU and size, tab separated:
+//   cpu model, cores, circles, backend, kernel, threads, tile size, seconds per frame
+// Tabs because CPU names are full of spaces.  Delete the file to make everything retune.
+
+bool Autotuner::Load(TunedCircles::Config* config){
+	FILE* file = fopen(cacheFile, "r");
+	if (!file){
+		return false;
+	}
+
+	bool found = false;
+	char line[256];
+	while (!found && fgets(line, sizeof(line), file)){
+		char model[64];
+		char backendName[32];
+		char kernelName[32];
+		int cores, circles, threads, tileSize;
+		double frameSeconds;
+		if (sscanf(line, "%63[^\t]\t%d\t%d\t%31[^\t]\t%31[^\t]\t%d\t%d\t%lf",
+			model, &cores, &circles, backendName, kernelName, &threads, &tileSize, &frameSeconds) != 8){
+			continue;
+		}
+		if (strcmp(model, cpuModel) != 0 || cores != numCores || circles != numCircles){
+			continue;
+		}
+
+		// Don't trust a line just because it matched.  Someone could have edited it, or
+		// run an older build that wrote names this one doesn't know.
+		int backend = 0;
+		while (backend < TunedCircles::BACKEND_COUNT && strcmp(backendName, TunedCircles::BackendName((TunedCircles::Backend)backend)) != 0){
+			++backend;
+		}
+		int kernel = 0;
+		while (kernel < DispatchedCircles::KERNEL_COUNT && strcmp(kernelName, DispatchedCircles::KernelName((DispatchedCircles::Kernel)kernel)) != 0){
+			++kernel;
+		}
+		if (backend == TunedCircles::BACKEND_COUNT || kernel == DispatchedCircles::KERNEL_COUNT ||
+			!DispatchedCircles::IsSupported((DispatchedCircles::Kernel)kernel) || threads < 1 || tileSize < 4){
+			continue;
+		}
+
+		config->backend = (TunedCircles::Backend)backend;
+		config->kernel = (DispatchedCircles::Kernel)kernel;
+		config->threads = threads;
+		config->tileSize = tileSize;
+		config->frameSeconds = frameSeconds;
+		found = true;
+	}
+
+	fclose(file);
+	return found;
+}
+
+void Autotuner::Save(const TunedCircles::Config& config){
+	// Keep every other machine's and size's lines, and replace ours.
+	std::vector<std::string> lines;
+	char keyPrefix[128];
+	snprintf(keyPrefix, sizeof(keyPrefix), "%s\t%d\t%d\t", cpuModel, numCores, numCircles);
+
+	FILE* file = fopen(cacheFile, "r");
+	if (file){
+		char line[256];
+		while (fgets(line, sizeof(line), file)){
+			if (strncmp(line, keyPrefix, strlen(keyPrefix)) != 0){
+				lines.push_back(line);
+			}
+		}
+		fclose(file);
+	}
+
+	// If we can't write it (a read only folder, say) that's fine, we just tune again next time.
+	file = fopen(cacheFile, "w");
+	if (!file){
+		return;
+	}
+	for (size_t l = 0; l < lines.size(); ++l){
+		fputs(lines[l].c_str(), file);
+	}
+	fprintf(file, "%s%s\t%s\t%d\t%d\t%.9f\n", keyPrefix, TunedCircles::BackendName(config.backend),
+		DispatchedCircles::KernelName(config.kernel), config.threads, config.tileSize, config.frameSeconds);
+	fclose(file);
+}
+
+// Why bother?  Look at the tables main.cpp prints.  Which kernel wins depends on N (at
+// 64 circles threads are pure overhead, at 100000 they're everything), on how many cores
+// there are, and on how the chip handles its widest registers.  Nobody can pick once for
+// every machine, but each machine can pick for itself in a fraction of a second.
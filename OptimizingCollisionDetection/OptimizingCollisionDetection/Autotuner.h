@@ -0,0 +1,64 @@
+/*
+Title: Optimizing Collision Detection
+File Name: Autotuner.h
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+Times every backend and setting on this machine at startup, picks the fastest,
+and remembers it in a file so the next run can skip straight to it.
+*/
+#pragma once
+#include "Settings.h"
+#include "TunedCircles.h"
+
+class Autotuner
+{
+public:
+	Autotuner(int numCircles = NUM_CIRCLES, const char* cacheFile = AUTOTUNE_CACHE_FILE);
+
+	// Looks for an answer in the cache file first.  If there isn't one for this CPU and
+	// N (or retune is true), times every candidate, writes the winner to the file and
+	// returns it.
+	TunedCircles::Config Tune(bool retune = false);
+
+	// About the last Tune().
+	bool FromCache();
+	int CandidatesTried();
+	double TuningSeconds();
+
+	const char* CpuModel();
+
+private:
+	int numCircles;
+	int numCores;
+	const char* cacheFile;
+	char cpuModel[64];
+
+	bool fromCache;
+	int candidatesTried;
+	double tuningSeconds;
+
+	// The best time per frame out of a few batches.
+	double Benchmark(const TunedCircles::Config& config);
+
+	bool Load(TunedCircles::Config* config);
+	void Save(const TunedCircles::Config& config);
+};
@@ -0,0 +1,58 @@
+/*
+Title: Optimizing Collision Detection
+File Name: CollisionBits.h
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+A few simple helper functions for reading and sizing a collision matrix that
+stores one bit per pair instead of one float per pair.
+*/
+#pragma once
+#include "Settings.h"
+
+// Each row is a run of 32 bit words.  Bit b of word w in row i is the pair (i, w * 32 + b).
+// Rows are padded out to a multiple of 4 words so every row starts 16 byte aligned,
+// which is what lets the SIMD and assembly code treat each row the same way.
+// The classes work out WordsPerRow once when they're built and keep it.
+
+namespace CollisionBits{
+
+	/// <summary>
+	/// Returns how many 32 bit words a row of the bit matrix takes up
+	/// </summary>
+	/// <param name="numCircles">Number of circles in the world</param>
+	/// <returns>Words per row, padded to a multiple of 4</returns>
+	static int WordsPerRow(int numCircles){
+		return ((numCircles + 127) / 128) * 4;
+	}
+
+	/// <summary>
+	/// Returns whether circle i and circle j are colliding
+	/// </summary>
+	/// <param name="bits">The bit matrix</param>
+	/// <param name="wordsPerRow">Words per row, from WordsPerRow</param>
+	/// <param name="i">The first circle</param>
+	/// <param name="j">The second circle, which should be greater than i</param>
+	/// <returns>True if the bit for (i, j) is set</returns>
+	static bool Get(const unsigned int* bits, int wordsPerRow, int i, int j){
+		return (bits[i * wordsPerRow + (j >> 5)] >> (j & 31)) & 1;
+	}
+}
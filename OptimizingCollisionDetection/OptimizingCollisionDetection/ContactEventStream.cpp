@@ -0,0 +1,157 @@
+/*
+Title: Optimizing Collision Detection
+File Name: ContactEventStream.cpp
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+Compares each frame's packed collision bits with the last frame's and turns the
+difference into a short list of contacts that began and ended.
+*/
+
+#include "ContactEventStream.h"
+#include "CollisionBits.h"
+#include "Platform.h"
+
+ContactEventStream::ContactEventStream(int numCircles)
+{
+	this->numCircles = numCircles;
+	wordsPerRow = CollisionBits::WordsPerRow(numCircles);
+
+	previous = (unsigned int*)_aligned_malloc(sizeof(unsigned int) * wordsPerRow * numCircles, 64);
+	memset(previous, 0, sizeof(unsigned int) * wordsPerRow * numCircles);
+
+	capacity = 1024;
+	events = (ContactEvent*)malloc(sizeof(ContactEvent) * capacity);
+	count = 0;
+
+	reportPersisting = false;
+	began = 0;
+	persisted = 0;
+	ended = 0;
+	contacts = 0;
+}
+
+ContactEventStream::~ContactEventStream()
+{
+	_aligned_free(previous);
+	free(events);
+}
+
+int ContactEventStream::Contacts(){
+	return contacts;
+}
+
+void ContactEventStream::Emit(int i, int wordIndex, unsigned int bits, int type){
+	// One event per set bit.  bits & (bits - 1) clears the lowest one, so this loops
+	// exactly as many times as there are events, no matter how wide the word is.
+	while (bits){
+		if (count == capacity){
+			capacity *= 2;
+			events = (ContactEvent*)realloc(events, sizeof(ContactEvent) * capacity);
+		}
+		events[count].i = i;
+		events[count].j = wordIndex * 32 + Platform::LowestBit(bits);
+		events[count].type = type;
+		++count;
+		bits &= bits - 1;
+	}
+}
+
+void ContactEventStream::Update(const unsigned int* collisionBits){
+	// Between two frames almost nothing changes.  Circles move about 1 a frame, so only
+	// the pairs right on the edge of touching flip.  Out of half a million pairs that's
+	// a few dozen.  But the matrix gets rewritten from scratch every frame, so anyone
+	// who wants to know what changed has to compare the whole thing.
+	//
+	// With one bit per pair, the compare is cheap.  this ^ last is 1 exactly where
+	// something changed, for 128 pairs in a single SSE instruction.  If a whole group of
+	// 4 words comes out 0, which is nearly all of them, there's nothing to do but copy
+	// this frame over last frame's and move on.  Only the handful of words with bits set
+	// ever get looked at one bit at a time.
+	//
+	// Of the changed bits, the ones set now are contacts that began, and the ones that
+	// were set before are contacts that ended.
+	count = 0;
+	began = 0;
+	ended = 0;
+
+	__m128i zero = _mm_setzero_si128();
+
+	for (int i = 0; i < numCircles; ++i){
+		const unsigned int* row = collisionBits + i * wordsPerRow;
+		unsigned int* lastRow = previous + i * wordsPerRow;
+
+		// The kernels only write j's from i rounded down to 32, and the bits up to and
+		// including i in that word are junk (i against itself always "collides").  So
+		// start on the 4 word group holding i, and mask off everything up to i.
+		int firstWord = i >> 5;
+		int word = firstWord & ~3;
+		unsigned int firstMask[4] = { 0, 0, 0, 0 };
+		for (int lane = firstWord - word; lane < 4; ++lane){
+			firstMask[lane] = 0xFFFFFFFFu;
+		}
+		firstMask[firstWord - word] = (0xFFFFFFFFu << (i & 31)) << 1;
+		__m128i mask = _mm_loadu_si128((const __m128i*)firstMask);
+
+		for (; word < wordsPerRow; word += 4){
+			__m128i now = _mm_load_si128((const __m128i*)(row + word));
+			__m128i before = _mm_load_si128((const __m128i*)(lastRow + word));
+			__m128i changed = _mm_and_si128(_mm_xor_si128(now, before), mask);
+			_mm_store_si128((__m128i*)(lastRow + word), now);
+
+			if (reportPersisting || _mm_movemask_epi8(_mm_cmpeq_epi32(changed, zero)) != 0xFFFF){
+				unsigned int nowWords[4];
+				unsigned int changedWords[4];
+				unsigned int stayedWords[4];
+				_mm_storeu_si128((__m128i*)nowWords, now);
+				_mm_storeu_si128((__m128i*)changedWords, changed);
+				_mm_storeu_si128((__m128i*)stayedWords, _mm_and_si128(_mm_and_si128(now, before), mask));
+
+				for (int lane = 0; lane < 4; ++lane){
+					int beforeCount = count;
+					Emit(i, word + lane, changedWords[lane] & nowWords[lane], CONTACT_BEGIN);
+					began += count - beforeCount;
+
+					beforeCount = count;
+					Emit(i, word + lane, changedWords[lane] & ~nowWords[lane], CONTACT_END);
+					ended += count - beforeCount;
+
+					if (reportPersisting){
+						Emit(i, word + lane, stayedWords[lane], CONTACT_PERSIST);
+					}
+				}
+			}
+
+			mask = _mm_set1_epi32(-1);
+		}
+	}
+
+	// Contacts that persisted are whatever we had, minus the ones that ended.  No need
+	// to count them bit by bit.
+	persisted = contacts - ended;
+	contacts = persisted + began;
+}
+
+// Compare this with what a consumer had to do before: look at all half a million pairs
+// every frame to find the few dozen that changed.  The diff still looks at every word,
+// but that's 32 times fewer things than pairs, 4 at a time, and the only per event
+// work is for the events themselves.  main.cpp prints how many there are next to how
+// many contacts, and what the diff costs on top of the packed kernel.
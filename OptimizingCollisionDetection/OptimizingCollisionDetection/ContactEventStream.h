@@ -0,0 +1,83 @@
+/*
+Title: Optimizing Collision Detection
+File Name: ContactEventStream.h
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+Compares each frame's packed collision bits with the last frame's and turns the
+difference into a short list of contacts that began and ended.
+*/
+#pragma once
+#include "Settings.h"
+
+struct ContactEvent{
+	int i;
+	int j;
+	int type;
+};
+
+class ContactEventStream
+{
+public:
+	enum Type{
+		CONTACT_BEGIN,
+		CONTACT_PERSIST,
+		CONTACT_END
+	};
+
+	// This frame's events, in row order.  Rebuilt by every Update().
+	ContactEvent* events;
+	int count;
+
+	// Persisting contacts are the bulk of them, and most consumers don't want to hear
+	// about them every frame.  Off by default, so the work stays proportional to changes.
+	bool reportPersisting;
+
+	// How many of each there were this frame, whether they were reported or not.
+	int began;
+	int persisted;
+	int ended;
+
+	ContactEventStream(int numCircles = NUM_CIRCLES);
+	~ContactEventStream();
+
+	// Diffs a frame's bit matrix (see CollisionBits.h) against the last one it was given
+	// and writes out the events.  The first frame diffs against no contacts at all, so
+	// everything begins.
+	void Update(const unsigned int* collisionBits);
+
+	// How many contacts there are now.  The same as began + persisted.
+	int Contacts();
+
+private:
+	int numCircles;
+	int wordsPerRow;
+	int capacity;
+	int contacts;
+
+	// Last frame's bit matrix.
+	unsigned int* previous;
+
+	void Emit(int i, int wordIndex, unsigned int bits, int type);
+
+	ContactEventStream(const ContactEventStream&);
+	ContactEventStream& operator=(const ContactEventStream&);
+};
@@ -0,0 +1,116 @@
+/*
+Title: Optimizing Collision Detection
+File Name: ContactList.h
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+A simple growable list of colliding pairs, used instead of an N by N matrix
+when only a few pairs actually collide.
+*/
+#pragma once
+#include <cstdlib>
+
+struct ContactPair{
+	int i;
+	int j;
+};
+
+class ContactList
+{
+public:
+	ContactPair* pairs;
+	int count;
+	int capacity;
+
+	ContactList(int initialCapacity = 1024){
+		pairs = (ContactPair*)malloc(sizeof(ContactPair) * initialCapacity);
+		count = 0;
+		capacity = initialCapacity;
+	}
+
+	~ContactList(){
+		free(pairs);
+	}
+
+	void Clear(){
+		count = 0;
+	}
+
+	// Makes sure there's room for at least this many more pairs.  The kernels call this
+	// once up front and then write without checking, so the check isn't in the hot loop.
+	void Reserve(int extra){
+		if (count + extra > capacity){
+			while (count + extra > capacity){
+				capacity *= 2;
+			}
+			pairs = (ContactPair*)realloc(pairs, sizeof(ContactPair) * capacity);
+		}
+	}
+
+	size_t MemoryUsage(){
+		return sizeof(ContactPair) * capacity;
+	}
+
+private:
+	// Copying this would mean two lists freeing the same pairs.
+	ContactList(const ContactList&);
+	ContactList& operator=(const ContactList&);
+};
+
+// Checks a list of i < j pairs against the brute force answer for the same circles.
+// falsePositives are pairs in the list that aren't really touching, falseNegatives are
+// pairs that are touching but missing.  Every pair is listed at most once, so if the
+// counts match nothing is missing.  A template so the double circles can use it too.
+template<class Scalar>
+void CountContactErrors(const ContactList& contacts, const Scalar* xPosition, const Scalar* yPosition,
+	const Scalar* radius, int numCircles, int& falsePositives, int& falseNegatives){
+	falsePositives = 0;
+
+	int listed = 0;
+	for (int c = 0; c < contacts.count; ++c){
+		int i = contacts.pairs[c].i;
+		int j = contacts.pairs[c].j;
+		bool expected = i < j && (xPosition[i] - xPosition[j]) * (xPosition[i] - xPosition[j])
+			+ (yPosition[i] - yPosition[j]) * (yPosition[i] - yPosition[j])
+			< (radius[i] + radius[j]) * (radius[i] + radius[j]);
+		falsePositives += !expected;
+		listed += expected;
+	}
+
+	int colliding = 0;
+	for (int i = 0; i < numCircles; ++i){
+		for (int j = i + 1; j < numCircles; ++j){
+			colliding += (xPosition[i] - xPosition[j]) * (xPosition[i] - xPosition[j])
+				+ (yPosition[i] - yPosition[j]) * (yPosition[i] - yPosition[j])
+				< (radius[i] + radius[j]) * (radius[i] + radius[j]);
+		}
+	}
+	falseNegatives = colliding - listed;
+}
+
+// Both kinds of error added up, which is what every CountMismatches() returns.
+template<class Scalar>
+int CountContactMismatches(const ContactList& contacts, const Scalar* xPosition, const Scalar* yPosition,
+	const Scalar* radius, int numCircles){
+	int falsePositives, falseNegatives;
+	CountContactErrors(contacts, xPosition, yPosition, radius, numCircles, falsePositives, falseNegatives);
+	return falsePositives + falseNegatives;
+}
@@ -0,0 +1,132 @@
+/*
+Title: Optimizing Collision Detection
+File Name: ContactListCircles.cpp
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+A version of SIMDOptimizedCircles.cpp that writes out a list of the pairs that
+collide instead of an N by N matrix.
+*/
+
+#include "ContactListCircles.h"
+#include "Platform.h"
+#include "HelperFunctions.h"
+
+
+ContactListCircles::ContactListCircles(int numCircles)
+{
+	// Padded to a multiple of 4 the same way as SIMDOptimizedCircles.  The padding
+	// circles never collide, so they never make it into the list.
+	this->numCircles = numCircles;
+	paddedCircles = Helper::PadCircles(numCircles, 4);
+
+	xPosition = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	xVelocity = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	yPosition = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	yVelocity = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	radius = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+
+	for (int i = 0; i < numCircles; ++i){
+		xPosition[i] = Helper::RandomFloat(0, 1000.0f);
+		yPosition[i] = Helper::RandomFloat(0, 1000.0f);
+		xVelocity[i] = Helper::RandomFloat(-1.0f, 1.0f);
+		yVelocity[i] = Helper::RandomFloat(-1.0f, 1.0f);
+		radius[i] = Helper::RandomFloat(5.0f, 100.0f);
+	}
+	Helper::FillPadding(xPosition, xVelocity, yPosition, yVelocity, radius, numCircles, paddedCircles);
+}
+
+ContactListCircles::~ContactListCircles()
+{
+	_aligned_free(xPosition);
+	_aligned_free(yPosition);
+	_aligned_free(xVelocity);
+	_aligned_free(yVelocity);
+	_aligned_free(radius);
+}
+
+void ContactListCircles::Update(){
+	for (int i = 0; i < paddedCircles; i += 4){
+		_mm_store_ps(xPosition + i, _mm_add_ps(_mm_load_ps(xPosition + i), _mm_load_ps(xVelocity + i)));
+		_mm_store_ps(yPosition + i, _mm_add_ps(_mm_load_ps(yPosition + i), _mm_load_ps(yVelocity + i)));
+	}
+}
+
+void ContactListCircles::CheckForCollisions(){
+	// The comment in main.cpp says the point of isCollided is so you can resolve collisions
+	// afterwards.  If that's what we're doing, the resolver doesn't want a million yes or
+	// no answers, it wants the handful of yeses.  So let's just hand it those.
+	contacts.Clear();
+
+	for (int i = 0; i < numCircles; ++i){
+		__m128 xPos = _mm_load1_ps(xPosition + i);
+		__m128 yPos = _mm_load1_ps(yPosition + i);
+		__m128 rad = _mm_load1_ps(radius + i);
+
+		// Round down to a multiple of 4.  SIMDOptimizedCircles used to do i & 0xFC here,
+		// which only works for i < 256.  That was just wasted work for a matrix, but here
+		// it would have meant wrong pairs.
+		int j = i & ~3;
+
+		// The first group of 4 overlaps j <= i, which we don't want in the list.  This
+		// mask only lets through the lanes past i.  After the first group they're all fine.
+		int validLanes = (0xF << ((i & 3) + 1)) & 0xF;
+
+		// Worst case every j in this row collides.  Make sure there's room for all of them
+		// (plus the 3 extra slots the trick below can scribble on) once, up front.
+		contacts.Reserve(paddedCircles - j + 4);
+		ContactPair* out = contacts.pairs + contacts.count;
+
+		do {
+			__m128 xDif = _mm_sub_ps(xPos, _mm_load_ps(xPosition + j));
+			__m128 yDif = _mm_sub_ps(yPos, _mm_load_ps(yPosition + j));
+			__m128 radiusAdd = _mm_add_ps(rad, _mm_load_ps(radius + j));
+
+			int mask = _mm_movemask_ps(
+				_mm_cmplt_ps(
+					_mm_add_ps(_mm_mul_ps(xDif, xDif), _mm_mul_ps(yDif, yDif)),
+					_mm_mul_ps(radiusAdd, radiusAdd))) & validLanes;
+
+			// Here's the trick.  No if statements.  We write every lane into the next slot
+			// whether it collided or not, but only move the pointer forward if it did.
+			// A lane that didn't collide just gets overwritten by the next one.
+			// Almost nothing collides, so an if here would be a branch the CPU has to guess
+			// on for every single pair, and every time it guesses wrong it costs us.
+			out->i = i; out->j = j;     out += mask & 1;
+			out->i = i; out->j = j + 1; out += (mask >> 1) & 1;
+			out->i = i; out->j = j + 2; out += (mask >> 2) & 1;
+			out->i = i; out->j = j + 3; out += (mask >> 3) & 1;
+
+			validLanes = 0xF;
+			j += 4;
+		} while (j < paddedCircles);
+
+		contacts.count = (int)(out - contacts.pairs);
+	}
+}
+
+int ContactListCircles::CountMismatches(){
+	return CountContactMismatches(contacts, xPosition, yPosition, radius, numCircles);
+}
+
+// The list is 8 bytes per contact.  The float matrix is 4 bytes per pair, whether they
+// collide or not.  So as long as fewer than half the pairs collide, the list wins, and in
+// a real game it's usually a tiny fraction of a percent.
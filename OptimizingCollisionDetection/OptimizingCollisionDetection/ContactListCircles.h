@@ -0,0 +1,56 @@
+/*
+Title: Optimizing Collision Detection
+File Name: ContactListCircles.h
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+A version of SIMDOptimizedCircles.cpp that writes out a list of the pairs that
+collide instead of an N by N matrix.
+*/
+#pragma once
+#include "Settings.h"
+#include "ContactList.h"
+
+class ContactListCircles
+{
+public:
+	float* xPosition;
+	float* xVelocity;
+	float* yPosition;
+	float* yVelocity;
+	float* radius;
+
+	int numCircles;
+	int paddedCircles;
+
+	// No isCollided here.  Just the pairs that actually touch, with i < j.
+	ContactList contacts;
+
+	ContactListCircles(int numCircles = NUM_CIRCLES);
+	~ContactListCircles();
+
+	void Update();
+	void CheckForCollisions();
+
+	// Checks the list against the brute force answer and returns how many pairs are
+	// missing from it or shouldn't be in it.  Should always be 0.
+	int CountMismatches();
+};
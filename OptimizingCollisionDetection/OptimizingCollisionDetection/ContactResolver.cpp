@@ -0,0 +1,234 @@
+/*
+Title: Optimizing Collision Detection
+File Name: ContactResolver.cpp
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+Takes the contacts detection found and actually does something about them: pushes
+the circles apart and bounces them, 4 contacts at a time.
+*/
+
+#include "ContactResolver.h"
+#include "Platform.h"
+#include "HelperFunctions.h"
+#include <cmath>
+
+ContactResolver::ContactResolver(int numCircles)
+{
+	restitution = 0.5f;
+	correctionPercent = 0.8f;
+	slop = 0.01f;
+
+	this->numCircles = numCircles;
+	paddedCircles = Helper::PadCircles(numCircles, 4);
+
+	xCorrection = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	yCorrection = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	xImpulse = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	yImpulse = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	contactCount = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+
+	memset(xCorrection, 0, paddedCircles * sizeof(float));
+	memset(yCorrection, 0, paddedCircles * sizeof(float));
+	memset(xImpulse, 0, paddedCircles * sizeof(float));
+	memset(yImpulse, 0, paddedCircles * sizeof(float));
+	memset(contactCount, 0, paddedCircles * sizeof(float));
+}
+
+ContactResolver::~ContactResolver()
+{
+	_aligned_free(xCorrection);
+	_aligned_free(yCorrection);
+	_aligned_free(xImpulse);
+	_aligned_free(yImpulse);
+	_aligned_free(contactCount);
+}
+
+void ContactResolver::Resolve(const ContactList& contacts, float* xPosition, float* yPosition,
+	float* xVelocity, float* yVelocity, const float* radius){
+	// Detection was easy to do 4 at a time because every i ran against a nice straight
+	// row of j's.  Contacts aren't like that.  Contact 0 might be circles 5 and 700, and
+	// contact 1 might be 5 and 12.  So there are two problems.
+	//
+	// One: the 4 lanes want data from 8 different places.  SSE can't load from scattered
+	// addresses, so we build each register out of 4 separate loads.  That's slow-ish, but
+	// the math after it is long enough to be worth it.
+	//
+	// Two: circle 5 is in both contacts.  If each contact wrote circle 5's new position
+	// straight back, one would overwrite the other, and which one wins would depend on
+	// which lane it landed in.  So nobody writes positions here.  Every contact adds what
+	// it wants to do to a per circle total, one lane at a time so two lanes on the same
+	// circle just add up, and Apply() does all the circles at the end.
+	__m128 zero = _mm_setzero_ps();
+	__m128 one = _mm_set1_ps(1.0f);
+	__m128 bounce = _mm_set1_ps(1.0f + restitution);
+	__m128 percent = _mm_set1_ps(correctionPercent);
+	__m128 allowedOverlap = _mm_set1_ps(slop);
+
+	float out[4][4];
+
+	for (int c = 0; c < contacts.count; c += 4){
+		// The last batch can be short.  Fill it with copies of the last real contact and
+		// throw their results away.
+		int lanes = contacts.count - c < 4 ? contacts.count - c : 4;
+		int i[4], j[4];
+		for (int lane = 0; lane < 4; ++lane){
+			const ContactPair& pair = contacts.pairs[c + (lane < lanes ? lane : lanes - 1)];
+			i[lane] = pair.i;
+			j[lane] = pair.j;
+		}
+
+#define GATHER(array, index) _mm_setr_ps(array[index[0]], array[index[1]], array[index[2]], array[index[3]])
+		__m128 xNormal = _mm_sub_ps(GATHER(xPosition, j), GATHER(xPosition, i));
+		__m128 yNormal = _mm_sub_ps(GATHER(yPosition, j), GATHER(yPosition, i));
+		__m128 xRelative = _mm_sub_ps(GATHER(xVelocity, j), GATHER(xVelocity, i));
+		__m128 yRelative = _mm_sub_ps(GATHER(yVelocity, j), GATHER(yVelocity, i));
+		__m128 radiusI = GATHER(radius, i);
+		__m128 radiusJ = GATHER(radius, j);
+#undef GATHER
+
+		// Heavier circles should move less.  Mass goes with area, so inverse mass is
+		// 1 / r^2 (the pi cancels out).
+		__m128 inverseMassI = _mm_div_ps(one, _mm_mul_ps(radiusI, radiusI));
+		__m128 inverseMassJ = _mm_div_ps(one, _mm_mul_ps(radiusJ, radiusJ));
+		__m128 inverseMassSum = _mm_add_ps(inverseMassI, inverseMassJ);
+
+		// The normal points from i to j.  Two circles exactly on top of each other have
+		// no direction, so those get pushed apart along x.
+		__m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(xNormal, xNormal), _mm_mul_ps(yNormal, yNormal)));
+		__m128 stacked = _mm_cmple_ps(distance, zero);
+		__m128 inverseDistance = _mm_div_ps(one, _mm_or_ps(_mm_and_ps(stacked, one), _mm_andnot_ps(stacked, distance)));
+		xNormal = _mm_or_ps(_mm_and_ps(stacked, one), _mm_andnot_ps(stacked, _mm_mul_ps(xNormal, inverseDistance)));
+		yNormal = _mm_andnot_ps(stacked, _mm_mul_ps(yNormal, inverseDistance));
+
+		// Position: push apart along the normal by most of the overlap.
+		__m128 overlap = _mm_sub_ps(_mm_sub_ps(_mm_add_ps(radiusI, radiusJ), distance), allowedOverlap);
+		__m128 correction = _mm_div_ps(_mm_mul_ps(_mm_max_ps(overlap, zero), percent), inverseMassSum);
+
+		// Velocity: if they're moving towards each other along the normal, take that speed
+		// away and send some of it back the other way.  If they're already moving apart,
+		// leave them alone, or we'd pull them back together.
+		__m128 normalSpeed = _mm_add_ps(_mm_mul_ps(xRelative, xNormal), _mm_mul_ps(yRelative, yNormal));
+		__m128 impulse = _mm_div_ps(_mm_mul_ps(_mm_sub_ps(zero, bounce), normalSpeed), inverseMassSum);
+		impulse = _mm_and_ps(_mm_cmplt_ps(normalSpeed, zero), impulse);
+
+		// What i gets, j gets the opposite of scaled by its own mass.
+		_mm_storeu_ps(out[0], _mm_mul_ps(xNormal, correction));
+		_mm_storeu_ps(out[1], _mm_mul_ps(yNormal, correction));
+		_mm_storeu_ps(out[2], _mm_mul_ps(xNormal, impulse));
+		_mm_storeu_ps(out[3], _mm_mul_ps(yNormal, impulse));
+		float massI[4], massJ[4];
+		_mm_storeu_ps(massI, inverseMassI);
+		_mm_storeu_ps(massJ, inverseMassJ);
+
+		for (int lane = 0; lane < lanes; ++lane){
+			xCorrection[i[lane]] -= out[0][lane] * massI[lane];
+			yCorrection[i[lane]] -= out[1][lane] * massI[lane];
+			xImpulse[i[lane]] -= out[2][lane] * massI[lane];
+			yImpulse[i[lane]] -= out[3][lane] * massI[lane];
+			contactCount[i[lane]] += 1.0f;
+
+			xCorrection[j[lane]] += out[0][lane] * massJ[lane];
+			yCorrection[j[lane]] += out[1][lane] * massJ[lane];
+			xImpulse[j[lane]] += out[2][lane] * massJ[lane];
+			yImpulse[j[lane]] += out[3][lane] * massJ[lane];
+			contactCount[j[lane]] += 1.0f;
+		}
+	}
+
+	Apply(xPosition, yPosition, xVelocity, yVelocity);
+}
+
+void ContactResolver::Apply(float* xPosition, float* yPosition, float* xVelocity, float* yVelocity){
+	// Back to nice straight rows, so back to full speed SIMD.  A circle in 3 contacts
+	// gets a third of each.  Without that, a circle squeezed between two others would
+	// get pushed twice as hard as it should and fly off.  Circles with no contacts get
+	// 0 / 1, so no branch for them either.  Then zero the totals for next frame.
+	__m128 zero = _mm_setzero_ps();
+	__m128 one = _mm_set1_ps(1.0f);
+
+	for (int i = 0; i < paddedCircles; i += 4){
+		__m128 share = _mm_div_ps(one, _mm_max_ps(_mm_load_ps(contactCount + i), one));
+
+		_mm_store_ps(xPosition + i, _mm_add_ps(_mm_load_ps(xPosition + i), _mm_mul_ps(_mm_load_ps(xCorrection + i), share)));
+		_mm_store_ps(yPosition + i, _mm_add_ps(_mm_load_ps(yPosition + i), _mm_mul_ps(_mm_load_ps(yCorrection + i), share)));
+		_mm_store_ps(xVelocity + i, _mm_add_ps(_mm_load_ps(xVelocity + i), _mm_mul_ps(_mm_load_ps(xImpulse + i), share)));
+		_mm_store_ps(yVelocity + i, _mm_add_ps(_mm_load_ps(yVelocity + i), _mm_mul_ps(_mm_load_ps(yImpulse + i), share)));
+
+		_mm_store_ps(xCorrection + i, zero);
+		_mm_store_ps(yCorrection + i, zero);
+		_mm_store_ps(xImpulse + i, zero);
+		_mm_store_ps(yImpulse + i, zero);
+		_mm_store_ps(contactCount + i, zero);
+	}
+}
+
+void ContactResolver::ResolveScalar(const ContactList& contacts, float* xPosition, float* yPosition,
+	float* xVelocity, float* yVelocity, const float* radius){
+	for (int c = 0; c < contacts.count; ++c){
+		int i = contacts.pairs[c].i;
+		int j = contacts.pairs[c].j;
+
+		float xNormal = xPosition[j] - xPosition[i];
+		float yNormal = yPosition[j] - yPosition[i];
+		float inverseMassI = 1.0f / (radius[i] * radius[i]);
+		float inverseMassJ = 1.0f / (radius[j] * radius[j]);
+		float inverseMassSum = inverseMassI + inverseMassJ;
+
+		float distance = sqrtf(xNormal * xNormal + yNormal * yNormal);
+		if (distance <= 0.0f){
+			xNormal = 1.0f;
+			yNormal = 0.0f;
+		}
+		else{
+			float inverseDistance = 1.0f / distance;
+			xNormal *= inverseDistance;
+			yNormal *= inverseDistance;
+		}
+
+		float overlap = radius[i] + radius[j] - distance - slop;
+		float correction = (overlap > 0.0f ? overlap : 0.0f) * correctionPercent / inverseMassSum;
+
+		float normalSpeed = (xVelocity[j] - xVelocity[i]) * xNormal + (yVelocity[j] - yVelocity[i]) * yNormal;
+		float impulse = normalSpeed < 0.0f ? -(1.0f + restitution) * normalSpeed / inverseMassSum : 0.0f;
+
+		xCorrection[i] -= xNormal * correction * inverseMassI;
+		yCorrection[i] -= yNormal * correction * inverseMassI;
+		xImpulse[i] -= xNormal * impulse * inverseMassI;
+		yImpulse[i] -= yNormal * impulse * inverseMassI;
+		contactCount[i] += 1.0f;
+
+		xCorrection[j] += xNormal * correction * inverseMassJ;
+		yCorrection[j] += yNormal * correction * inverseMassJ;
+		xImpulse[j] += xNormal * impulse * inverseMassJ;
+		yImpulse[j] += yNormal * impulse * inverseMassJ;
+		contactCount[j] += 1.0f;
+	}
+
+	Apply(xPosition, yPosition, xVelocity, yVelocity);
+}
+
+// Averaging like this is called a Jacobi solve.  Resolving contacts one after another,
+// each seeing the last one's result, converges faster (that's Gauss-Seidel), but then
+// every contact depends on the one before it and there's nothing left to do 4 at a time.
+// Real engines run the Jacobi version a few times a frame instead.  The time this takes
+// is mostly the gathers and scatters, not the math, which is why main.cpp times it next
+// to detection: in a crowded scene it's not the cheap part.
@@ -0,0 +1,73 @@
+/*
+Title: Optimizing Collision Detection
+File Name: ContactResolver.h
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+Takes the contacts detection found and actually does something about them: pushes
+the circles apart and bounces them, 4 contacts at a time.
+*/
+#pragma once
+#include "Settings.h"
+#include "ContactList.h"
+
+class ContactResolver
+{
+public:
+	// How bouncy a collision is.  0 and they stop dead along the normal, 1 and they bounce
+	// off with all their speed.
+	float restitution;
+
+	// How much of the overlap gets pushed out each frame, and how much overlap is left
+	// alone so resting circles don't jitter.  Pushing out all of it at once overshoots.
+	float correctionPercent;
+	float slop;
+
+	ContactResolver(int numCircles = NUM_CIRCLES);
+	~ContactResolver();
+
+	// Pushes every contact in the list apart and bounces them off each other, 4 contacts
+	// at a time.  Every contact sees the circles as they were before any of them were
+	// resolved, and a circle in several contacts gets the average of what they all asked
+	// for.  The arrays are the usual SoA ones, padded to a multiple of 4.
+	void Resolve(const ContactList& contacts, float* xPosition, float* yPosition,
+		float* xVelocity, float* yVelocity, const float* radius);
+
+	// Exactly the same thing, one contact at a time in plain C++.
+	void ResolveScalar(const ContactList& contacts, float* xPosition, float* yPosition,
+		float* xVelocity, float* yVelocity, const float* radius);
+
+private:
+	int numCircles;
+	int paddedCircles;
+
+	// What every contact asked for, added up per circle, and how many asked.
+	float* xCorrection;
+	float* yCorrection;
+	float* xImpulse;
+	float* yImpulse;
+	float* contactCount;
+
+	void Apply(float* xPosition, float* yPosition, float* xVelocity, float* yVelocity);
+
+	ContactResolver(const ContactResolver&);
+	ContactResolver& operator=(const ContactResolver&);
+};
@@ -27,42 +27,56 @@ Shows off a version of BasicCircle.cpp that is data oriented in nature.
 
 #include "DataOptimizedCircles.h"
 #include "HelperFunctions.h"
+#include <cstring>
 
 
-DataOptimizedCircles::DataOptimizedCircles()
+DataOptimizedCircles::DataOptimizedCircles(int numCircles)
 {
+	this->numCircles = numCircles;
+	xPosition = (float*)malloc(sizeof(float) * numCircles);
+	xVelocity = (float*)malloc(sizeof(float) * numCircles);
+	yPosition = (float*)malloc(sizeof(float) * numCircles);
+	yVelocity = (float*)malloc(sizeof(float) * numCircles);
+	radius = (float*)malloc(sizeof(float) * numCircles);
 
 	// Setup is still kind of object oriented.  That's fine.
-	for (int i = 0; i < NUM_CIRCLES; ++i){
+	for (int i = 0; i < numCircles; ++i){
 		xPosition[i] = Helper::RandomFloat(0, 1000.0f);
 		yPosition[i] = Helper::RandomFloat(0, 1000.0f);
 		xVelocity[i] = Helper::RandomFloat(-1.0f, 1.0f);
 		yVelocity[i] = Helper::RandomFloat(-1.0f, 1.0f);
 		radius[i] = Helper::RandomFloat(5.0f, 100.0f);
 	}
-	for (int i = 0; i < NUM_CIRCLES; ++i){
-		isCollided[i] = (bool*)malloc(sizeof(bool) * NUM_CIRCLES);
-		memset(isCollided[i], 0, sizeof(bool) * NUM_CIRCLES);
+	isCollided = (bool**)malloc(sizeof(bool*) * numCircles);
+	for (int i = 0; i < numCircles; ++i){
+		isCollided[i] = (bool*)malloc(sizeof(bool) * numCircles);
+		memset(isCollided[i], 0, sizeof(bool) * numCircles);
 	}
 }
 
 
 DataOptimizedCircles::~DataOptimizedCircles()
 {
-	for (int i = 0; i < NUM_CIRCLES; ++i){
+	for (int i = 0; i < numCircles; ++i){
 		free(isCollided[i]);
 	}
+	free(isCollided);
+	free(xPosition);
+	free(xVelocity);
+	free(yPosition);
+	free(yVelocity);
+	free(radius);
 }
 
 void DataOptimizedCircles::CheckForCollisions(){
 	
 	// See, now it's getting kind of hard to read what's going on.  And this is still just
 	// a simple algorithm.
-	for (int i = 0; i < NUM_CIRCLES; ++i){
-		for (int j = i + 1; j < NUM_CIRCLES; ++j){
+	for (int i = 0; i < numCircles; ++i){
+		for (int j = i + 1; j < numCircles; ++j){
 			isCollided[i][j] = (xPosition[i] - xPosition[j]) * (xPosition[i] - xPosition[j])
 				+ (yPosition[i] - yPosition[j]) * (yPosition[i] - yPosition[j])
-				< (radius[i] + radius[j]) + (radius[i] + radius[j]);
+				< (radius[i] + radius[j]) * (radius[i] + radius[j]);
 		}
 	}
 }
@@ -73,7 +87,7 @@ void DataOptimizedCircles::Update(){
 	// There's a lot of potential for optimization with this format, I suggest moving things
 	// around and profiling the results.  The number one rule of optimization is testing
 	// testing testing.
-	for (int i = 0; i < NUM_CIRCLES; ++i){
+	for (int i = 0; i < numCircles; ++i){
 		xPosition[i] += xVelocity[i];
 		yPosition[i] += yVelocity[i];
 	}
@@ -34,11 +34,12 @@ public:
 	// Okay, so remember that AOS thing I mentioned in TEST FOUR?
 
 	// This is the alternative, Struct of Arrays.
-	float xPosition[NUM_CIRCLES];
-	float xVelocity[NUM_CIRCLES];
-	float yPosition[NUM_CIRCLES];
-	float yVelocity[NUM_CIRCLES];
-	float radius[NUM_CIRCLES];
+	float* xPosition;
+	float* xVelocity;
+	float* yPosition;
+	float* yVelocity;
+	float* radius;
+	int numCircles;
 	// You'll notice that all of these arrays are within one structure, the
 	// dataOptimizedCircles class.
 
@@ -53,9 +54,9 @@ public:
 	// What are the advantages of SOA?  I'll write them in DataOptimizedCircles.cpp, let's
 	// go there.
 
-	bool* isCollided[NUM_CIRCLES];
+	bool** isCollided;
 
-	DataOptimizedCircles();
+	DataOptimizedCircles(int numCircles = NUM_CIRCLES);
 	~DataOptimizedCircles();
 
 	void Update();
@@ -0,0 +1,386 @@
+/*
+Title: Optimizing Collision Detection
+File Name: DispatchedCircles.cpp
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+One set of circles with a scalar, SSE, AVX2 and AVX-512 version of Update and
+CheckForCollisions, picking the widest one the CPU supports when the program runs.
+*/
+#include "DispatchedCircles.h"
+#include "Platform.h"
+#include "HelperFunctions.h"
+#include "FixedSizeKernels.h"
+#include <cstdio>
+
+static const char* kernelNames[DispatchedCircles::KERNEL_COUNT] = { "scalar", "sse", "avx2", "avx512" };
+
+// -1 until the first time anyone asks.
+static int bestKernel = -1;
+
+// Every size FixedSizeKernels.h gets built for, and its copy for each kernel.  There's no
+// scalar copy, the whole point is giving the SIMD loops constant bounds.
+struct FixedSizeEntry{
+	int numCircles;
+	void (*update[DispatchedCircles::KERNEL_COUNT])(float*, float*, const float*, const float*);
+	void (*check[DispatchedCircles::KERNEL_COUNT])(const float*, const float*, const float*, float**);
+};
+
+#ifdef HAS_AVX512_INTRINSICS
+#define FIXED_SIZE_ENTRY(N) { N, \
+	{ 0, FixedSizeKernel<N, SimdSSE>::Update, FixedSizeKernel<N, SimdAVX2>::Update, FixedSizeKernel<N, SimdAVX512>::Update }, \
+	{ 0, FixedSizeKernel<N, SimdSSE>::CheckForCollisions, FixedSizeKernel<N, SimdAVX2>::CheckForCollisions, FixedSizeKernel<N, SimdAVX512>::CheckForCollisions } }
+#else
+#define FIXED_SIZE_ENTRY(N) { N, \
+	{ 0, FixedSizeKernel<N, SimdSSE>::Update, FixedSizeKernel<N, SimdAVX2>::Update, 0 }, \
+	{ 0, FixedSizeKernel<N, SimdSSE>::CheckForCollisions, FixedSizeKernel<N, SimdAVX2>::CheckForCollisions, 0 } }
+#endif
+
+static const FixedSizeEntry fixedSizes[] = {
+	FIXED_SIZE_ENTRY(64),
+	FIXED_SIZE_ENTRY(256),
+	FIXED_SIZE_ENTRY(1024)
+};
+
+DispatchedCircles::DispatchedCircles(int numCircles)
+{
+	this->numCircles = numCircles;
+	paddedCircles = Helper::PadCircles(numCircles, 16);
+
+	xPosition = (float*)_aligned_malloc(paddedCircles * sizeof(float), 64);
+	xVelocity = (float*)_aligned_malloc(paddedCircles * sizeof(float), 64);
+	yPosition = (float*)_aligned_malloc(paddedCircles * sizeof(float), 64);
+	yVelocity = (float*)_aligned_malloc(paddedCircles * sizeof(float), 64);
+	radius = (float*)_aligned_malloc(paddedCircles * sizeof(float), 64);
+	isCollided = (float**)malloc(sizeof(float*) * numCircles);
+
+	for (int i = 0; i < numCircles; ++i){
+		xPosition[i] = Helper::RandomFloat(0, 1000.0f);
+		yPosition[i] = Helper::RandomFloat(0, 1000.0f);
+		xVelocity[i] = Helper::RandomFloat(-1.0f, 1.0f);
+		yVelocity[i] = Helper::RandomFloat(-1.0f, 1.0f);
+		radius[i] = Helper::RandomFloat(5.0f, 100.0f);
+
+		isCollided[i] = (float*)_aligned_malloc(sizeof(float) * paddedCircles, 64);
+		memset(isCollided[i], 0, sizeof(float) * paddedCircles);
+	}
+	Helper::FillPadding(xPosition, xVelocity, yPosition, yVelocity, radius, numCircles, paddedCircles);
+
+	fixedSize = true;
+	SelectKernel(BestKernel());
+}
+
+DispatchedCircles::~DispatchedCircles()
+{
+	_aligned_free(xPosition);
+	_aligned_free(yPosition);
+	_aligned_free(xVelocity);
+	_aligned_free(yVelocity);
+	_aligned_free(radius);
+
+	for (int i = 0; i < numCircles; ++i){
+		_aligned_free(isCollided[i]);
+	}
+	free(isCollided);
+}
+
+bool DispatchedCircles::IsSupported(Kernel kernel){
+	switch (kernel){
+	case KERNEL_SCALAR:
+		return true;
+	case KERNEL_SSE:
+		// Every x86 chip that can run a 64 bit OS has SSE2, and the SIMD test has been
+		// assuming SSE since Test Six anyway.
+		return true;
+	case KERNEL_AVX2:
+		return Platform::SupportsAVX2();
+	case KERNEL_AVX512:
+		return Platform::SupportsAVX512();
+	default:
+		return false;
+	}
+}
+
+DispatchedCircles::Kernel DispatchedCircles::BestKernel(){
+	if (bestKernel < 0){
+		bestKernel = KERNEL_SCALAR;
+		for (int k = KERNEL_COUNT - 1; k > KERNEL_SCALAR; --k){
+			if (IsSupported((Kernel)k)){
+				bestKernel = k;
+				break;
+			}
+		}
+	}
+	return (Kernel)bestKernel;
+}
+
+const char* DispatchedCircles::KernelName(Kernel kernel){
+	return kernel >= 0 && kernel < KERNEL_COUNT ? kernelNames[kernel] : "unknown";
+}
+
+DispatchedCircles::Kernel DispatchedCircles::ChooseKernel(const char* requested){
+	if (requested == 0 || requested[0] == 0 || strcmp(requested, "auto") == 0){
+		return BestKernel();
+	}
+
+	for (int k = 0; k < KERNEL_COUNT; ++k){
+		if (strcmp(requested, kernelNames[k]) == 0){
+			if (IsSupported((Kernel)k)){
+				return (Kernel)k;
+			}
+			std::printf("Kernel %s isn't supported on this CPU, using %s.\n", requested, KernelName(BestKernel()));
+			return BestKernel();
+		}
+	}
+
+	std::printf("Unknown kernel %s (try scalar, sse, avx2, avx512 or auto), using %s.\n",
+		requested, KernelName(BestKernel()));
+	return BestKernel();
+}
+
+bool DispatchedCircles::SelectKernel(Kernel kernel){
+	if (!IsSupported(kernel)){
+		return false;
+	}
+
+	// This is the whole trick.  Pick the functions once, here, and from then on Update and
+	// CheckForCollisions just call through the pointer.  That's one indirect call a frame,
+	// which is nothing next to the million pairs each call tests.  Checking the CPU inside
+	// the loops instead would cost us on every single group.
+	switch (kernel){
+	case KERNEL_SCALAR:
+		updateFunction = &DispatchedCircles::UpdateScalar;
+		checkFunction = &DispatchedCircles::CheckScalar;
+		break;
+	case KERNEL_SSE:
+		updateFunction = &DispatchedCircles::UpdateSSE;
+		checkFunction = &DispatchedCircles::CheckSSE;
+		break;
+	case KERNEL_AVX2:
+		updateFunction = &DispatchedCircles::UpdateAVX2;
+		checkFunction = &DispatchedCircles::CheckAVX2;
+		break;
+	case KERNEL_AVX512:
+		updateFunction = &DispatchedCircles::UpdateAVX512;
+		checkFunction = &DispatchedCircles::CheckAVX512;
+		break;
+	default:
+		return false;
+	}
+
+	// numCircles never changes after the constructor, so the fixed size lookup happens
+	// here too and never again.
+	fixedUpdate = 0;
+	fixedCheck = 0;
+	for (size_t s = 0; s < sizeof(fixedSizes) / sizeof(fixedSizes[0]); ++s){
+		if (fixedSizes[s].numCircles == numCircles){
+			fixedUpdate = fixedSizes[s].update[kernel];
+			fixedCheck = fixedSizes[s].check[kernel];
+		}
+	}
+
+	this->kernel = kernel;
+	return true;
+}
+
+DispatchedCircles::Kernel DispatchedCircles::SelectedKernel(){
+	return kernel;
+}
+
+bool DispatchedCircles::HasFixedSizeKernel(){
+	return fixedCheck != 0;
+}
+
+void DispatchedCircles::Update(){
+	if (fixedSize && fixedUpdate){
+		fixedUpdate(xPosition, yPosition, xVelocity, yVelocity);
+	}
+	else{
+		(this->*updateFunction)();
+	}
+}
+
+void DispatchedCircles::CheckForCollisions(){
+	if (fixedSize && fixedCheck){
+		fixedCheck(xPosition, yPosition, radius, isCollided);
+	}
+	else{
+		(this->*checkFunction)();
+	}
+}
+
+// Everything below here is the same kernels as the earlier tests, just side by side on
+// the same data.  All of them write all 1 bits for a collision and 0 for a miss, for
+// j >= i rounded down to their width.  The padding past numCircles means the updates can
+// run straight off the end, and the SSE check can store its last group of 4 whole (the
+// padding circles never collide).  The AVX2 and AVX-512 checks mask off the end instead,
+// so they never write anything past numCircles.
+
+void DispatchedCircles::UpdateScalar(){
+	for (int i = 0; i < numCircles; ++i){
+		xPosition[i] += xVelocity[i];
+		yPosition[i] += yVelocity[i];
+	}
+}
+
+void DispatchedCircles::CheckScalar(){
+	// An int with every bit set, as a float.  Same thing the SIMD compares write.
+	float trueBits;
+	int allOnes = -1;
+	memcpy(&trueBits, &allOnes, sizeof(float));
+
+	for (int i = 0; i < numCircles; ++i){
+		float* row = isCollided[i];
+		for (int j = i + 1; j < numCircles; ++j){
+			float xDif = xPosition[j] - xPosition[i];
+			float yDif = yPosition[j] - yPosition[i];
+			float radiusAdd = radius[i] + radius[j];
+			row[j] = xDif * xDif + yDif * yDif < radiusAdd * radiusAdd ? trueBits : 0.0f;
+		}
+	}
+}
+
+void DispatchedCircles::UpdateSSE(){
+	for (int i = 0; i < paddedCircles; i += 4){
+		_mm_store_ps(xPosition + i, _mm_add_ps(_mm_load_ps(xPosition + i), _mm_load_ps(xVelocity + i)));
+		_mm_store_ps(yPosition + i, _mm_add_ps(_mm_load_ps(yPosition + i), _mm_load_ps(yVelocity + i)));
+	}
+}
+
+void DispatchedCircles::CheckSSE(){
+	for (int i = 0; i < numCircles; ++i){
+		__m128 xPos = _mm_load1_ps(xPosition + i);
+		__m128 yPos = _mm_load1_ps(yPosition + i);
+		__m128 rad = _mm_load1_ps(radius + i);
+		float* row = isCollided[i];
+
+		for (int j = i & ~3; j < numCircles; j += 4){
+			__m128 xDif = _mm_sub_ps(_mm_load_ps(xPosition + j), xPos);
+			__m128 yDif = _mm_sub_ps(_mm_load_ps(yPosition + j), yPos);
+			__m128 radiusAdd = _mm_add_ps(_mm_load_ps(radius + j), rad);
+
+			_mm_store_ps(row + j, _mm_cmplt_ps(
+				_mm_add_ps(_mm_mul_ps(xDif, xDif), _mm_mul_ps(yDif, yDif)),
+				_mm_mul_ps(radiusAdd, radiusAdd)));
+		}
+	}
+}
+
+TARGET_AVX2 void DispatchedCircles::UpdateAVX2(){
+	for (int i = 0; i < paddedCircles; i += 8){
+		_mm256_store_ps(xPosition + i, _mm256_add_ps(_mm256_load_ps(xPosition + i), _mm256_load_ps(xVelocity + i)));
+		_mm256_store_ps(yPosition + i, _mm256_add_ps(_mm256_load_ps(yPosition + i), _mm256_load_ps(yVelocity + i)));
+	}
+}
+
+TARGET_AVX2 void DispatchedCircles::CheckAVX2(){
+	// See AVXOptimizedCircles::CheckForCollisions for the mask.
+	int lastGroup = numCircles & ~7;
+	__m256i lastLanes = _mm256_cmpgt_epi32(_mm256_set1_epi32(numCircles - lastGroup),
+		_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+	for (int i = 0; i < numCircles; ++i){
+		__m256 xPos = _mm256_broadcast_ss(xPosition + i);
+		__m256 yPos = _mm256_broadcast_ss(yPosition + i);
+		__m256 rad = _mm256_broadcast_ss(radius + i);
+		float* row = isCollided[i];
+
+		int j = i & ~7;
+		for (; j < lastGroup; j += 8){
+			__m256 xDif = _mm256_sub_ps(_mm256_load_ps(xPosition + j), xPos);
+			__m256 yDif = _mm256_sub_ps(_mm256_load_ps(yPosition + j), yPos);
+			__m256 radiusAdd = _mm256_add_ps(_mm256_load_ps(radius + j), rad);
+
+			__m256 distance = _mm256_fmadd_ps(yDif, yDif, _mm256_mul_ps(xDif, xDif));
+			_mm256_store_ps(row + j, _mm256_cmp_ps(distance, _mm256_mul_ps(radiusAdd, radiusAdd), _CMP_LT_OQ));
+		}
+
+		if (j < numCircles){
+			__m256 xDif = _mm256_sub_ps(_mm256_maskload_ps(xPosition + j, lastLanes), xPos);
+			__m256 yDif = _mm256_sub_ps(_mm256_maskload_ps(yPosition + j, lastLanes), yPos);
+			__m256 radiusAdd = _mm256_add_ps(_mm256_maskload_ps(radius + j, lastLanes), rad);
+
+			__m256 distance = _mm256_fmadd_ps(yDif, yDif, _mm256_mul_ps(xDif, xDif));
+			_mm256_maskstore_ps(row + j, lastLanes, _mm256_cmp_ps(distance, _mm256_mul_ps(radiusAdd, radiusAdd), _CMP_LT_OQ));
+		}
+	}
+}
+
+#ifdef HAS_AVX512_INTRINSICS
+
+TARGET_AVX512 void DispatchedCircles::UpdateAVX512(){
+	for (int i = 0; i < paddedCircles; i += 16){
+		_mm512_store_ps(xPosition + i, _mm512_add_ps(_mm512_load_ps(xPosition + i), _mm512_load_ps(xVelocity + i)));
+		_mm512_store_ps(yPosition + i, _mm512_add_ps(_mm512_load_ps(yPosition + i), _mm512_load_ps(yVelocity + i)));
+	}
+}
+
+TARGET_AVX512 void DispatchedCircles::CheckAVX512(){
+	const __m512 allTrue = _mm512_castsi512_ps(_mm512_set1_epi32(-1));
+	const __mmask16 lastLanes = (__mmask16)(numCircles % 16 == 0 ? 0xFFFF : (1 << (numCircles % 16)) - 1);
+
+	for (int i = 0; i < numCircles; ++i){
+		__m512 xPos = _mm512_set1_ps(xPosition[i]);
+		__m512 yPos = _mm512_set1_ps(yPosition[i]);
+		__m512 rad = _mm512_set1_ps(radius[i]);
+		float* row = isCollided[i];
+
+		for (int j = i & ~15; j < numCircles; j += 16){
+			__mmask16 lanes = j + 16 <= numCircles ? (__mmask16)0xFFFF : lastLanes;
+
+			__m512 xDif = _mm512_sub_ps(_mm512_maskz_load_ps(lanes, xPosition + j), xPos);
+			__m512 yDif = _mm512_sub_ps(_mm512_maskz_load_ps(lanes, yPosition + j), yPos);
+			__m512 radiusAdd = _mm512_add_ps(_mm512_maskz_load_ps(lanes, radius + j), rad);
+
+			__m512 distance = _mm512_fmadd_ps(yDif, yDif, _mm512_mul_ps(xDif, xDif));
+			__mmask16 hit = _mm512_mask_cmp_ps_mask(lanes, distance, _mm512_mul_ps(radiusAdd, radiusAdd), _CMP_LT_OQ);
+			_mm512_mask_store_ps(row + j, lanes, _mm512_maskz_mov_ps(hit, allTrue));
+		}
+	}
+}
+
+#else
+
+// IsSupported() never says yes to AVX-512 on a compiler without it, so these never run.
+void DispatchedCircles::UpdateAVX512(){}
+void DispatchedCircles::CheckAVX512(){}
+
+#endif
+
+int DispatchedCircles::CountMismatches(){
+	int mismatches = 0;
+
+	for (int i = 0; i < numCircles; ++i){
+		for (int j = i + 1; j < numCircles; ++j){
+			bool expected = (xPosition[i] - xPosition[j]) * (xPosition[i] - xPosition[j])
+				+ (yPosition[i] - yPosition[j]) * (yPosition[i] - yPosition[j])
+				< (radius[i] + radius[j]) * (radius[i] + radius[j]);
+			mismatches += expected != (isCollided[i][j] != 0.0f);
+		}
+	}
+
+	return mismatches;
+}
+
+// Why not just build the whole program for AVX-512?  Because then it crashes on
+// everything else.  Why not just build it for SSE?  Because then the machines with
+// AVX-512 sit there doing a quarter of the work they could.  This way one build runs
+// everywhere and still goes as fast as each machine can.
@@ -0,0 +1,109 @@
+/*
+Title: Optimizing Collision Detection
+File Name: DispatchedCircles.h
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+One set of circles with a scalar, SSE, AVX2 and AVX-512 version of Update and
+CheckForCollisions, picking the widest one the CPU supports when the program runs.
+*/
+#pragma once
+#include "Settings.h"
+
+class DispatchedCircles
+{
+public:
+	enum Kernel{
+		KERNEL_SCALAR,
+		KERNEL_SSE,
+		KERNEL_AVX2,
+		KERNEL_AVX512,
+		KERNEL_COUNT
+	};
+
+	float* xPosition;
+	float* xVelocity;
+	float* yPosition;
+	float* yVelocity;
+	float* radius;
+
+	// Padded for the widest kernel, so every kernel can run on the same arrays.
+	int numCircles;
+	int paddedCircles;
+
+	float** isCollided;
+
+	// When numCircles is one of the sizes FixedSizeKernels.h is built for, the selected
+	// kernel has a copy with N baked in, and Update and CheckForCollisions use that one.
+	// Turn this off to compare against the ordinary kernels on the same data.
+	bool fixedSize;
+
+	// Starts out on BestKernel().
+	DispatchedCircles(int numCircles = NUM_CIRCLES);
+	~DispatchedCircles();
+
+	// Returns false, and changes nothing, if this CPU can't run that kernel.
+	bool SelectKernel(Kernel kernel);
+	Kernel SelectedKernel();
+
+	// Whether the selected kernel has a fixed size copy for this numCircles.
+	bool HasFixedSizeKernel();
+
+	void Update();
+	void CheckForCollisions();
+
+	// Checks isCollided against the plain C++ test and returns how many pairs (j > i)
+	// disagree.  Should always be 0.
+	int CountMismatches();
+
+	static bool IsSupported(Kernel kernel);
+
+	// The widest kernel this CPU supports.  CPUID only gets asked the first time.
+	static Kernel BestKernel();
+
+	// "scalar", "sse", "avx2" or "avx512".
+	static const char* KernelName(Kernel kernel);
+
+	// Turns a name from the command line or environment into a kernel.  null, "" or
+	// "auto" means BestKernel().  Anything unknown or unsupported gets a warning and
+	// BestKernel() too, so a bad setting never stops the program from running.
+	static Kernel ChooseKernel(const char* requested);
+
+private:
+	Kernel kernel;
+	void (DispatchedCircles::*updateFunction)();
+	void (DispatchedCircles::*checkFunction)();
+
+	// The fixed size kernels are plain functions on the arrays, not members.  Both null
+	// when there's no copy for this size.
+	void (*fixedUpdate)(float* xPosition, float* yPosition, const float* xVelocity, const float* yVelocity);
+	void (*fixedCheck)(const float* xPosition, const float* yPosition, const float* radius, float** isCollided);
+
+	void UpdateScalar();
+	void UpdateSSE();
+	void UpdateAVX2();
+	void UpdateAVX512();
+
+	void CheckScalar();
+	void CheckSSE();
+	void CheckAVX2();
+	void CheckAVX512();
+};
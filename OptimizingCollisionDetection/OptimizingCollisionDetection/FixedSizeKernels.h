@@ -0,0 +1,147 @@
+/*
+Title: Optimizing Collision Detection
+File Name: FixedSizeKernels.h
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+The collision kernels as templates on the number of circles and the instruction
+set, so fixed size worlds get loops with constant bounds.
+*/
+#pragma once
+#include "Settings.h"
+#include "Platform.h"
+
+// These are the same kernels as DispatchedCircles, except the number of circles is a
+// template parameter instead of a member variable.  When N is a constant the compiler
+// knows exactly how many groups each row has, can unroll the short rows, and throws away
+// the leftover code entirely when N divides evenly by the register width.  There's no
+// numCircles to load, and no check for the end of the arrays beyond the loop itself.
+//
+// The catch is that every N you want is a separate copy of the code.  So we only build
+// the sizes we actually use, see FixedSizeKernels_SSE.cpp and friends.
+
+// One of these per instruction set.  The template below is the loops, and it asks these
+// for the math on one register's worth of circles.  They all want the arrays padded out
+// to a whole register, the same way DispatchedCircles pads them.
+//
+// Only the declarations live here.  The bodies are in the matching .cpp, built for that
+// instruction set and nothing else.  If they were inline in this header, the AVX2 file and
+// the SSE file would each build their own copy of SimdSSE, and the linker is allowed to
+// keep either one, AVX2 instructions and all.
+struct SimdSSE{
+	typedef __m128 Vector;
+	enum { width = 4 };
+
+	static Vector Broadcast(const float* value);
+	static void Add(float* position, const float* velocity);
+	static void TestGroup(Vector xPos, Vector yPos, Vector rad,
+		const float* xPosition, const float* yPosition, const float* radius, float* out);
+
+	// The last count lanes of a row, when N isn't a whole number of registers.
+	static void TestLastGroup(Vector xPos, Vector yPos, Vector rad,
+		const float* xPosition, const float* yPosition, const float* radius, float* out, int count);
+};
+
+struct SimdAVX2{
+	typedef __m256 Vector;
+	enum { width = 8 };
+
+	static Vector Broadcast(const float* value);
+	static void Add(float* position, const float* velocity);
+	static void TestGroup(Vector xPos, Vector yPos, Vector rad,
+		const float* xPosition, const float* yPosition, const float* radius, float* out);
+	static void TestLastGroup(Vector xPos, Vector yPos, Vector rad,
+		const float* xPosition, const float* yPosition, const float* radius, float* out, int count);
+};
+
+#ifdef HAS_AVX512_INTRINSICS
+struct SimdAVX512{
+	typedef __m512 Vector;
+	enum { width = 16 };
+
+	static Vector Broadcast(const float* value);
+	static void Add(float* position, const float* velocity);
+	static void TestGroup(Vector xPos, Vector yPos, Vector rad,
+		const float* xPosition, const float* yPosition, const float* radius, float* out);
+	static void TestLastGroup(Vector xPos, Vector yPos, Vector rad,
+		const float* xPosition, const float* yPosition, const float* radius, float* out, int count);
+};
+#endif
+
+template<size_t N, class Simd>
+struct FixedSizeKernel{
+	typedef typename Simd::Vector Vector;
+
+	// N rounded down and up to a whole number of registers.  Both are constants, so
+	// neither costs anything at runtime.
+	static const size_t wholeGroups = N / Simd::width * Simd::width;
+	static const size_t paddedCircles = (N + Simd::width - 1) / Simd::width * Simd::width;
+
+	static void Update(float* xPosition, float* yPosition, const float* xVelocity, const float* yVelocity);
+
+	// Same results as DispatchedCircles::CheckForCollisions: all 1 bits for a collision
+	// and 0 for a miss, for j >= i rounded down to the register width.
+	static void CheckForCollisions(const float* xPosition, const float* yPosition, const float* radius, float** isCollided);
+};
+
+template<size_t N, class Simd>
+void FixedSizeKernel<N, Simd>::Update(float* xPosition, float* yPosition, const float* xVelocity, const float* yVelocity){
+	for (size_t i = 0; i < paddedCircles; i += Simd::width){
+		Simd::Add(xPosition + i, xVelocity + i);
+		Simd::Add(yPosition + i, yVelocity + i);
+	}
+}
+
+template<size_t N, class Simd>
+void FixedSizeKernel<N, Simd>::CheckForCollisions(const float* xPosition, const float* yPosition, const float* radius, float** isCollided){
+	for (size_t i = 0; i < N; ++i){
+		Vector xPos = Simd::Broadcast(xPosition + i);
+		Vector yPos = Simd::Broadcast(yPosition + i);
+		Vector rad = Simd::Broadcast(radius + i);
+		float* row = isCollided[i];
+
+		size_t j = i & ~(size_t)(Simd::width - 1);
+		for (; j < wholeGroups; j += Simd::width){
+			Simd::TestGroup(xPos, yPos, rad, xPosition + j, yPosition + j, radius + j, row + j);
+		}
+
+		// N % width is a constant.  For every size we actually build it's 0, and this whole
+		// block is gone before the program ever runs.
+		if (N % Simd::width != 0){
+			Simd::TestLastGroup(xPos, yPos, rad, xPosition + j, yPosition + j, radius + j, row + j, (int)(N - j));
+		}
+	}
+}
+
+// The sizes that get built, one set per instruction set.  The .cpp files use this with
+// nothing in front to build them.  Everyone else sees it with extern in front, below,
+// which says "these exist somewhere, link to them, don't build your own".  That matters:
+// a copy built anywhere else would be built for the wrong instruction set.
+#define FIXED_SIZE_KERNEL_SIZES(externOrNothing, Simd) \
+	externOrNothing template struct FixedSizeKernel<64, Simd>; \
+	externOrNothing template struct FixedSizeKernel<256, Simd>; \
+	externOrNothing template struct FixedSizeKernel<1024, Simd>;
+
+FIXED_SIZE_KERNEL_SIZES(extern, SimdSSE)
+FIXED_SIZE_KERNEL_SIZES(extern, SimdAVX2)
+#ifdef HAS_AVX512_INTRINSICS
+FIXED_SIZE_KERNEL_SIZES(extern, SimdAVX512)
+#endif
@@ -0,0 +1,65 @@
+/*
+Title: Optimizing Collision Detection
+File Name: FixedSizeKernels_AVX2.cpp
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+The AVX2 copies of FixedSizeKernels.h, for the sizes DispatchedCircles knows about.
+*/
+
+#include "Platform.h"
+
+// TARGET_AVX2 works on one function, but the template's loops are written once for every
+// instruction set, so there's nowhere to put it.  Instead the whole header gets compiled
+// as AVX2 code here.  Nothing else in the program includes it this way, so none of these
+// instructions can leak out into code that runs on an older CPU.
+BEGIN_TARGET_AVX2
+#include "FixedSizeKernels.h"
+
+SimdAVX2::Vector SimdAVX2::Broadcast(const float* value){
+	return _mm256_broadcast_ss(value);
+}
+
+void SimdAVX2::Add(float* position, const float* velocity){
+	_mm256_store_ps(position, _mm256_add_ps(_mm256_load_ps(position), _mm256_load_ps(velocity)));
+}
+
+void SimdAVX2::TestGroup(Vector xPos, Vector yPos, Vector rad,
+	const float* xPosition, const float* yPosition, const float* radius, float* out){
+	Vector xDif = _mm256_sub_ps(_mm256_load_ps(xPosition), xPos);
+	Vector yDif = _mm256_sub_ps(_mm256_load_ps(yPosition), yPos);
+	Vector radiusAdd = _mm256_add_ps(_mm256_load_ps(radius), rad);
+	Vector distance = _mm256_fmadd_ps(yDif, yDif, _mm256_mul_ps(xDif, xDif));
+	_mm256_store_ps(out, _mm256_cmp_ps(distance, _mm256_mul_ps(radiusAdd, radiusAdd), _CMP_LT_OQ));
+}
+
+void SimdAVX2::TestLastGroup(Vector xPos, Vector yPos, Vector rad,
+	const float* xPosition, const float* yPosition, const float* radius, float* out, int count){
+	__m256i lanes = _mm256_cmpgt_epi32(_mm256_set1_epi32(count), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+	Vector xDif = _mm256_sub_ps(_mm256_maskload_ps(xPosition, lanes), xPos);
+	Vector yDif = _mm256_sub_ps(_mm256_maskload_ps(yPosition, lanes), yPos);
+	Vector radiusAdd = _mm256_add_ps(_mm256_maskload_ps(radius, lanes), rad);
+	Vector distance = _mm256_fmadd_ps(yDif, yDif, _mm256_mul_ps(xDif, xDif));
+	_mm256_maskstore_ps(out, lanes, _mm256_cmp_ps(distance, _mm256_mul_ps(radiusAdd, radiusAdd), _CMP_LT_OQ));
+}
+
+FIXED_SIZE_KERNEL_SIZES(, SimdAVX2)
+END_TARGET
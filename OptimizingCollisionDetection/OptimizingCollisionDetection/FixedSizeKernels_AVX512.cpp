@@ -0,0 +1,61 @@
+/*
+Title: Optimizing Collision Detection
+File Name: FixedSizeKernels_AVX512.cpp
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+The AVX-512 copies of FixedSizeKernels.h, for the sizes DispatchedCircles knows about.
+*/
+
+#include "Platform.h"
+
+// Same idea as FixedSizeKernels_AVX2.cpp.
+#ifdef HAS_AVX512_INTRINSICS
+BEGIN_TARGET_AVX512
+#include "FixedSizeKernels.h"
+
+SimdAVX512::Vector SimdAVX512::Broadcast(const float* value){
+	return _mm512_set1_ps(*value);
+}
+
+void SimdAVX512::Add(float* position, const float* velocity){
+	_mm512_store_ps(position, _mm512_add_ps(_mm512_load_ps(position), _mm512_load_ps(velocity)));
+}
+
+void SimdAVX512::TestGroup(Vector xPos, Vector yPos, Vector rad,
+	const float* xPosition, const float* yPosition, const float* radius, float* out){
+	TestLastGroup(xPos, yPos, rad, xPosition, yPosition, radius, out, width);
+}
+
+void SimdAVX512::TestLastGroup(Vector xPos, Vector yPos, Vector rad,
+	const float* xPosition, const float* yPosition, const float* radius, float* out, int count){
+	__mmask16 lanes = (__mmask16)(count >= 16 ? 0xFFFF : (1 << count) - 1);
+	Vector xDif = _mm512_sub_ps(_mm512_maskz_load_ps(lanes, xPosition), xPos);
+	Vector yDif = _mm512_sub_ps(_mm512_maskz_load_ps(lanes, yPosition), yPos);
+	Vector radiusAdd = _mm512_add_ps(_mm512_maskz_load_ps(lanes, radius), rad);
+	Vector distance = _mm512_fmadd_ps(yDif, yDif, _mm512_mul_ps(xDif, xDif));
+	__mmask16 hit = _mm512_mask_cmp_ps_mask(lanes, distance, _mm512_mul_ps(radiusAdd, radiusAdd), _CMP_LT_OQ);
+	_mm512_mask_store_ps(out, lanes, _mm512_maskz_mov_ps(hit, _mm512_castsi512_ps(_mm512_set1_epi32(-1))));
+}
+
+FIXED_SIZE_KERNEL_SIZES(, SimdAVX512)
+END_TARGET
+#endif
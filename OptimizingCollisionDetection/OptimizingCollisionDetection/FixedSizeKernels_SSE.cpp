@@ -0,0 +1,56 @@
+/*
+Title: Optimizing Collision Detection
+File Name: FixedSizeKernels_SSE.cpp
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+The SSE copies of FixedSizeKernels.h, for the sizes DispatchedCircles knows about.
+*/
+
+#include "FixedSizeKernels.h"
+
+// Every x86-64 compiler already assumes SSE, so this one needs no BEGIN_TARGET.
+SimdSSE::Vector SimdSSE::Broadcast(const float* value){
+	return _mm_load1_ps(value);
+}
+
+void SimdSSE::Add(float* position, const float* velocity){
+	_mm_store_ps(position, _mm_add_ps(_mm_load_ps(position), _mm_load_ps(velocity)));
+}
+
+void SimdSSE::TestGroup(Vector xPos, Vector yPos, Vector rad,
+	const float* xPosition, const float* yPosition, const float* radius, float* out){
+	Vector xDif = _mm_sub_ps(_mm_load_ps(xPosition), xPos);
+	Vector yDif = _mm_sub_ps(_mm_load_ps(yPosition), yPos);
+	Vector radiusAdd = _mm_add_ps(_mm_load_ps(radius), rad);
+	_mm_store_ps(out, _mm_cmplt_ps(
+		_mm_add_ps(_mm_mul_ps(xDif, xDif), _mm_mul_ps(yDif, yDif)),
+		_mm_mul_ps(radiusAdd, radiusAdd)));
+}
+
+// SSE has no masked store worth using, so the last group is a whole group.  The
+// padding circles never collide, so their lanes come out false.
+void SimdSSE::TestLastGroup(Vector xPos, Vector yPos, Vector rad,
+	const float* xPosition, const float* yPosition, const float* radius, float* out, int /*count*/){
+	TestGroup(xPos, yPos, rad, xPosition, yPosition, radius, out);
+}
+
+FIXED_SIZE_KERNEL_SIZES(, SimdSSE)
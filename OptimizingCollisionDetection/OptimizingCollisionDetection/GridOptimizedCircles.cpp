@@ -0,0 +1,264 @@
+/*
+Title: Optimizing Collision Detection
+File Name: GridOptimizedCircles.cpp
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+A version of DataOptimizedCircles.cpp that uses a uniform grid (spatial hash)
+as a broadphase so only nearby circles are ever tested against each other.
+*/
+
+#include "GridOptimizedCircles.h"
+#include "HelperFunctions.h"
+#include <cmath>
+#include <cstring>
+
+
+GridOptimizedCircles::GridOptimizedCircles(int numCircles, float worldSize)
+{
+	this->numCircles = numCircles;
+	this->worldSize = worldSize;
+
+	xPosition = (float*)malloc(numCircles * sizeof(float));
+	xVelocity = (float*)malloc(numCircles * sizeof(float));
+	yPosition = (float*)malloc(numCircles * sizeof(float));
+	yVelocity = (float*)malloc(numCircles * sizeof(float));
+	radius = (float*)malloc(numCircles * sizeof(float));
+
+	float maxRadius = 0.0f;
+	for (int i = 0; i < numCircles; ++i){
+		xPosition[i] = Helper::RandomFloat(0, worldSize);
+		yPosition[i] = Helper::RandomFloat(0, worldSize);
+		xVelocity[i] = Helper::RandomFloat(-1.0f, 1.0f);
+		yVelocity[i] = Helper::RandomFloat(-1.0f, 1.0f);
+		radius[i] = Helper::RandomFloat(5.0f, 100.0f);
+		if (radius[i] > maxRadius){
+			maxRadius = radius[i];
+		}
+	}
+
+	// This is the important number.  If a cell is at least as wide as the two biggest
+	// circles put together, then anything touching a circle has to be in that circle's
+	// cell or one of the 8 cells around it.  Nothing further away can possibly reach.
+	cellSize = 2.0f * maxRadius;
+
+	isCollided = (bool**)malloc(sizeof(bool*) * numCircles);
+	for (int i = 0; i < numCircles; ++i){
+		isCollided[i] = (bool*)malloc(sizeof(bool) * numCircles);
+		memset(isCollided[i], 0, sizeof(bool) * numCircles);
+	}
+
+	needsFullClear = false;
+
+	// We hash the cells instead of allocating a fixed 2D array of them.  The circles
+	// drift forever (nothing bounces them back), so a fixed grid would eventually have
+	// everyone piled up in the border cells.  A power of two lets us mask instead of mod.
+	numBuckets = 1;
+	while (numBuckets < numCircles * 2){
+		numBuckets <<= 1;
+	}
+
+	bucketStart = (int*)malloc(sizeof(int) * (numBuckets + 1));
+	circleBucket = (int*)malloc(sizeof(int) * numCircles);
+	cellX = (int*)malloc(sizeof(int) * numCircles);
+	cellY = (int*)malloc(sizeof(int) * numCircles);
+	sortedIndex = (int*)malloc(sizeof(int) * numCircles);
+	sortedX = (float*)malloc(sizeof(float) * numCircles);
+	sortedY = (float*)malloc(sizeof(float) * numCircles);
+	sortedRadius = (float*)malloc(sizeof(float) * numCircles);
+
+	BuildGrid();
+}
+
+
+GridOptimizedCircles::~GridOptimizedCircles()
+{
+	free(xPosition);
+	free(xVelocity);
+	free(yPosition);
+	free(yVelocity);
+	free(radius);
+
+	for (int i = 0; i < numCircles; ++i){
+		free(isCollided[i]);
+	}
+	free(isCollided);
+
+	free(bucketStart);
+	free(circleBucket);
+	free(cellX);
+	free(cellY);
+	free(sortedIndex);
+	free(sortedX);
+	free(sortedY);
+	free(sortedRadius);
+}
+
+int GridOptimizedCircles::HashCell(int x, int y){
+	// Two big primes, xor'd together.  It's a very common hash for grids, and it's cheap.
+	return (int)(((unsigned int)x * 73856093u) ^ ((unsigned int)y * 19349663u)) & (numBuckets - 1);
+}
+
+void GridOptimizedCircles::BuildGrid(){
+	float inverseCellSize = 1.0f / cellSize;
+
+	// This is a counting sort.  First count how many circles land in each bucket...
+	memset(bucketStart, 0, sizeof(int) * (numBuckets + 1));
+	for (int i = 0; i < numCircles; ++i){
+		cellX[i] = (int)floorf(xPosition[i] * inverseCellSize);
+		cellY[i] = (int)floorf(yPosition[i] * inverseCellSize);
+		circleBucket[i] = HashCell(cellX[i], cellY[i]);
+		++bucketStart[circleBucket[i] + 1];
+	}
+
+	// ...then turn the counts into starting offsets...
+	for (int b = 0; b < numBuckets; ++b){
+		bucketStart[b + 1] += bucketStart[b];
+	}
+
+	// ...then drop every circle into its slot.  bucketStart[b] gets pushed forward as we
+	// fill, so afterwards it's pointing at the start of bucket b + 1.  Walking it back
+	// down one is cheaper than keeping a second copy of the offsets around.
+	for (int i = 0; i < numCircles; ++i){
+		int slot = bucketStart[circleBucket[i]]++;
+		sortedIndex[slot] = i;
+		sortedX[slot] = xPosition[i];
+		sortedY[slot] = yPosition[i];
+		sortedRadius[slot] = radius[i];
+	}
+	for (int b = numBuckets; b > 0; --b){
+		bucketStart[b] = bucketStart[b - 1];
+	}
+	bucketStart[0] = 0;
+}
+
+void GridOptimizedCircles::Update(){
+	for (int i = 0; i < numCircles; ++i){
+		xPosition[i] += xVelocity[i];
+		yPosition[i] += yVelocity[i];
+	}
+
+	// Everything moved, so the grid is stale.  Rebuilding is O(N), which is nothing
+	// compared to what we save in CheckForCollisions.
+	BuildGrid();
+}
+
+void GridOptimizedCircles::CheckForCollisions(){
+	// Clear out only what we set last time.
+	if (needsFullClear){
+		for (int i = 0; i < numCircles; ++i){
+			memset(isCollided[i], 0, sizeof(bool) * numCircles);
+		}
+		needsFullClear = false;
+	}
+	for (size_t c = 0; c < contacts.size(); ++c){
+		isCollided[contacts[c].i][contacts[c].j] = false;
+	}
+	contacts.clear();
+
+	int buckets[9];
+
+	for (int i = 0; i < numCircles; ++i){
+		float x = xPosition[i];
+		float y = yPosition[i];
+		float r = radius[i];
+
+		// Find the 9 buckets around this circle.  Two different cells can hash to the
+		// same bucket, and we don't want to walk a bucket twice, so skip repeats.
+		int numNeighbors = 0;
+		for (int dy = -1; dy <= 1; ++dy){
+			for (int dx = -1; dx <= 1; ++dx){
+				int bucket = HashCell(cellX[i] + dx, cellY[i] + dy);
+				bool repeated = false;
+				for (int n = 0; n < numNeighbors; ++n){
+					repeated |= buckets[n] == bucket;
+				}
+				if (!repeated){
+					buckets[numNeighbors++] = bucket;
+				}
+			}
+		}
+
+		for (int n = 0; n < numNeighbors; ++n){
+			int end = bucketStart[buckets[n] + 1];
+			for (int s = bucketStart[buckets[n]]; s < end; ++s){
+				// Every pair shows up twice, once from each side, so only keep the one
+				// where j > i.  That's the same top right triangle everyone else fills in.
+				int j = sortedIndex[s];
+				if (j <= i){
+					continue;
+				}
+
+				float xDif = x - sortedX[s];
+				float yDif = y - sortedY[s];
+				float radiusAdd = r + sortedRadius[s];
+				if (xDif * xDif + yDif * yDif < radiusAdd * radiusAdd){
+					isCollided[i][j] = true;
+					Contact contact = { i, j };
+					contacts.push_back(contact);
+				}
+			}
+		}
+	}
+}
+
+void GridOptimizedCircles::CheckForCollisionsBruteForce(){
+	for (int i = 0; i < numCircles; ++i){
+		for (int j = i + 1; j < numCircles; ++j){
+			isCollided[i][j] = (xPosition[i] - xPosition[j]) * (xPosition[i] - xPosition[j])
+				+ (yPosition[i] - yPosition[j]) * (yPosition[i] - yPosition[j])
+				< (radius[i] + radius[j]) * (radius[i] + radius[j]);
+		}
+	}
+
+	// The brute force just wrote every entry, so our list of what to clear is useless.
+	// If the grid runs next it has to wipe the whole thing once.
+	contacts.clear();
+	needsFullClear = true;
+}
+
+int GridOptimizedCircles::CountMismatches(){
+	int mismatches = 0;
+	for (int i = 0; i < numCircles; ++i){
+		for (int j = i + 1; j < numCircles; ++j){
+			bool expected = (xPosition[i] - xPosition[j]) * (xPosition[i] - xPosition[j])
+				+ (yPosition[i] - yPosition[j]) * (yPosition[i] - yPosition[j])
+				< (radius[i] + radius[j]) * (radius[i] + radius[j]);
+			mismatches += expected != isCollided[i][j];
+		}
+	}
+	return mismatches;
+}
+
+size_t GridOptimizedCircles::MemoryUsage(){
+	return sizeof(int) * (numBuckets + 1) + (sizeof(int) * 4 + sizeof(float) * 3) * numCircles
+		+ sizeof(Contact) * contacts.capacity();
+}
+
+// So how much does this buy us?  The brute force does N * (N - 1) / 2 tests no matter
+// what.  The grid does (roughly) however many circles are in 9 cells, for each circle.
+// If the world grows with the number of circles, that's a constant, so the whole thing
+// is O(N) instead of O(N^2).
+//
+// The catch is the constant.  Building the grid, hashing 9 cells per circle and jumping
+// around the sorted arrays all cost something, and at small N the dumb triangular loop
+// just plows through memory in order and wins.  Run the sweep in main.cpp to see where
+// the two lines cross on your machine.
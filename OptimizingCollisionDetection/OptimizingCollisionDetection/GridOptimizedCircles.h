@@ -0,0 +1,97 @@
+/*
+Title: Optimizing Collision Detection
+File Name: GridOptimizedCircles.h
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+A version of DataOptimizedCircles.cpp that uses a uniform grid (spatial hash)
+as a broadphase so only nearby circles are ever tested against each other.
+*/
+
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "Settings.h"
+
+class GridOptimizedCircles
+{
+public:
+	// Every test up until now has made each individual test faster.  This one makes
+	// us do fewer of them.  It's still the same SOA layout as DataOptimizedCircles,
+	// but the number of circles is picked when we construct it so we can try a bunch
+	// of different sizes and see where the grid starts winning.
+	int numCircles;
+	float worldSize;
+	float cellSize;
+
+	float* xPosition;
+	float* xVelocity;
+	float* yPosition;
+	float* yVelocity;
+	float* radius;
+
+	bool** isCollided;
+
+	GridOptimizedCircles(int numCircles = NUM_CIRCLES, float worldSize = 1000.0f);
+	~GridOptimizedCircles();
+
+	void Update();
+	void CheckForCollisions();
+
+	// The same triangular loop DataOptimizedCircles uses, run on this object's data,
+	// so we can time both against the exact same circles.
+	void CheckForCollisionsBruteForce();
+
+	// Tests every pair the slow way and returns how many entries of isCollided
+	// disagree with it.  Should always be 0.
+	int CountMismatches();
+
+	// Bytes used by the grid itself (not the circles or isCollided).
+	size_t MemoryUsage();
+
+private:
+	// The grid itself.  Each circle is hashed into a bucket by the cell it's in,
+	// and then everything is counting-sorted by bucket so a bucket is just a
+	// contiguous range [bucketStart[b], bucketStart[b + 1]) in the sorted arrays.
+	int numBuckets;
+	int* bucketStart;
+	int* circleBucket;
+	int* cellX;
+	int* cellY;
+
+	// Copies of the data in bucket order, so walking a cell walks memory in order.
+	int* sortedIndex;
+	float* sortedX;
+	float* sortedY;
+	float* sortedRadius;
+
+	// The grid only ever writes true.  To keep isCollided identical to the brute
+	// force output we remember what we set last frame and clear just those.
+	struct Contact{
+		int i;
+		int j;
+	};
+	std::vector<Contact> contacts;
+	bool needsFullClear;
+
+	int HashCell(int x, int y);
+	void BuildGrid();
+};
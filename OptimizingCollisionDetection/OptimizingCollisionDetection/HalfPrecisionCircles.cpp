@@ -0,0 +1,194 @@
+/*
+Title: Optimizing Collision Detection
+File Name: HalfPrecisionCircles.cpp
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+A version of ContactListCircles.cpp that keeps a half precision copy of the
+positions and radii for the pair test, and widens it to floats with F16C.
+*/
+
+#include "HalfPrecisionCircles.h"
+#include "Platform.h"
+#include "HelperFunctions.h"
+#include "PrecisionKernels.h"
+#include <cmath>
+
+// Rounding to nearest, which is what a plain cast to float does too.
+#define HALF_ROUNDING 0
+
+
+HalfPrecisionCircles::HalfPrecisionCircles(int numCircles, float worldSize)
+{
+	this->numCircles = numCircles;
+	paddedCircles = Helper::PadCircles(numCircles, 4);
+	halfStorage = true;
+
+	xPosition = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	xVelocity = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	yPosition = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	yVelocity = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	radius = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	xHalf = (unsigned short*)_aligned_malloc(paddedCircles * sizeof(unsigned short), 16);
+	yHalf = (unsigned short*)_aligned_malloc(paddedCircles * sizeof(unsigned short), 16);
+	radiusHalf = (unsigned short*)_aligned_malloc(paddedCircles * sizeof(unsigned short), 16);
+
+	for (int i = 0; i < numCircles; ++i){
+		xPosition[i] = Helper::RandomFloat(0, worldSize);
+		yPosition[i] = Helper::RandomFloat(0, worldSize);
+		xVelocity[i] = Helper::RandomFloat(-1.0f, 1.0f);
+		yVelocity[i] = Helper::RandomFloat(-1.0f, 1.0f);
+		radius[i] = Helper::RandomFloat(5.0f, 100.0f);
+	}
+	Helper::FillPadding(xPosition, xVelocity, yPosition, yVelocity, radius, numCircles, paddedCircles);
+
+	Encode();
+}
+
+HalfPrecisionCircles::~HalfPrecisionCircles()
+{
+	_aligned_free(xPosition);
+	_aligned_free(yPosition);
+	_aligned_free(xVelocity);
+	_aligned_free(yVelocity);
+	_aligned_free(radius);
+	_aligned_free(xHalf);
+	_aligned_free(yHalf);
+	_aligned_free(radiusHalf);
+}
+
+bool HalfPrecisionCircles::Supported(){
+	static const bool supported = Platform::SupportsF16C();
+	return supported;
+}
+
+TARGET_F16C static void EncodeHalf(const float* from, unsigned short* to, int count){
+	for (int i = 0; i < count; i += 4){
+		_mm_storel_epi64((__m128i*)(to + i), _mm_cvtps_ph(_mm_load_ps(from + i), HALF_ROUNDING));
+	}
+}
+
+TARGET_F16C static float DecodeHalf(unsigned short half){
+	return _mm_cvtss_f32(_mm_cvtph_ps(_mm_cvtsi32_si128(half)));
+}
+
+void HalfPrecisionCircles::Encode(){
+	if (!Supported()){
+		return;
+	}
+
+	// The padding circles at 1e18 are way past the biggest half (65504), so they come out
+	// as infinity.  Infinity minus anything real is still infinity, and infinity is never
+	// less than a radius, so they still never collide.
+	EncodeHalf(xPosition, xHalf, paddedCircles);
+	EncodeHalf(yPosition, yHalf, paddedCircles);
+	EncodeHalf(radius, radiusHalf, paddedCircles);
+}
+
+void HalfPrecisionCircles::Update(){
+	for (int i = 0; i < paddedCircles; i += 4){
+		_mm_store_ps(xPosition + i, _mm_add_ps(_mm_load_ps(xPosition + i), _mm_load_ps(xVelocity + i)));
+		_mm_store_ps(yPosition + i, _mm_add_ps(_mm_load_ps(yPosition + i), _mm_load_ps(yVelocity + i)));
+	}
+
+	// N conversions to save N^2 / 2 loads from being twice as big.
+	Encode();
+}
+
+void HalfPrecisionCircles::CheckForCollisions(){
+	if (halfStorage && Supported()){
+		CheckForCollisionsHalf();
+	}
+	else {
+		// The float arrays are padded to 4 and 16 byte aligned, which is all the SSE float
+		// kernel from PrecisionKernels.h needs, so that's the baseline.
+		PrecisionKernel<FloatSSE>::CheckForCollisions(xPosition, yPosition, radius, numCircles, paddedCircles, contacts);
+	}
+}
+
+TARGET_F16C void HalfPrecisionCircles::CheckForCollisionsHalf(){
+	// The same loop as the float kernel, but every load is 8 bytes of halves instead of
+	// 16 bytes of floats, and _mm_cvtph_ps widens them to 4 floats in the register.  All
+	// the math is still in 32 bits.  Only what's stored was rounded, so the only error is
+	// in where the circles are, not in the test itself.
+	contacts.Clear();
+
+	for (int i = 0; i < numCircles; ++i){
+		__m128 xPos = _mm_set1_ps(DecodeHalf(xHalf[i]));
+		__m128 yPos = _mm_set1_ps(DecodeHalf(yHalf[i]));
+		__m128 rad = _mm_set1_ps(DecodeHalf(radiusHalf[i]));
+
+		int j = i & ~3;
+		int validLanes = (0xF << ((i & 3) + 1)) & 0xF;
+
+		contacts.Reserve(paddedCircles - j + 4);
+		ContactPair* out = contacts.pairs + contacts.count;
+
+		do {
+			__m128 xDif = _mm_sub_ps(xPos, _mm_cvtph_ps(_mm_loadl_epi64((const __m128i*)(xHalf + j))));
+			__m128 yDif = _mm_sub_ps(yPos, _mm_cvtph_ps(_mm_loadl_epi64((const __m128i*)(yHalf + j))));
+			__m128 radiusAdd = _mm_add_ps(rad, _mm_cvtph_ps(_mm_loadl_epi64((const __m128i*)(radiusHalf + j))));
+
+			int mask = _mm_movemask_ps(
+				_mm_cmplt_ps(
+					_mm_add_ps(_mm_mul_ps(xDif, xDif), _mm_mul_ps(yDif, yDif)),
+					_mm_mul_ps(radiusAdd, radiusAdd))) & validLanes;
+
+			out->i = i; out->j = j;     out += mask & 1;
+			out->i = i; out->j = j + 1; out += (mask >> 1) & 1;
+			out->i = i; out->j = j + 2; out += (mask >> 2) & 1;
+			out->i = i; out->j = j + 3; out += (mask >> 3) & 1;
+
+			validLanes = 0xF;
+			j += 4;
+		} while (j < paddedCircles);
+
+		contacts.count = (int)(out - contacts.pairs);
+	}
+}
+
+void HalfPrecisionCircles::CountErrors(int& falsePositives, int& falseNegatives){
+	CountContactErrors(contacts, xPosition, yPosition, radius, numCircles, falsePositives, falseNegatives);
+}
+
+float HalfPrecisionCircles::MaxRoundingError(){
+	if (!Supported()){
+		return 0.0f;
+	}
+
+	float worst = 0.0f;
+	for (int i = 0; i < numCircles; ++i){
+		float errors[3] = {
+			fabsf(DecodeHalf(xHalf[i]) - xPosition[i]),
+			fabsf(DecodeHalf(yHalf[i]) - yPosition[i]),
+			fabsf(DecodeHalf(radiusHalf[i]) - radius[i]) };
+		for (int e = 0; e < 3; ++e){
+			worst = errors[e] > worst ? errors[e] : worst;
+		}
+	}
+	return worst;
+}
+
+// A half has 11 bits of precision, so the gap between one half and the next is about
+// 1/1000th of the number itself.  Up to 1024 that's under half a unit, and each position
+// can be off by half a gap.  Past 2048 the gap is 2, past 32768 it's 32, and past 65504
+// there's nothing at all, just infinity.  How much error is too much depends on how big
+// the circles are next to the gap, which is what the report in main.cpp is for.
@@ -0,0 +1,83 @@
+/*
+Title: Optimizing Collision Detection
+File Name: HalfPrecisionCircles.h
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+A version of ContactListCircles.cpp that keeps a half precision copy of the
+positions and radii for the pair test, and widens it to floats with F16C.
+*/
+#pragma once
+#include "Settings.h"
+#include "ContactList.h"
+
+class HalfPrecisionCircles
+{
+public:
+	// The real circles, in 32 bit floats.  These are what Update moves.  Adding a
+	// velocity of 0.3 to a half precision 900 would round right back to 900, so halves
+	// are no good for keeping the state, only for testing it.
+	int numCircles;
+	int paddedCircles;
+
+	float* xPosition;
+	float* xVelocity;
+	float* yPosition;
+	float* yVelocity;
+	float* radius;
+
+	// The same positions and radii rounded to 16 bit half precision floats, rebuilt
+	// every Update.  This is what CheckForCollisions reads when halfStorage is on.
+	unsigned short* xHalf;
+	unsigned short* yHalf;
+	unsigned short* radiusHalf;
+
+	// Turns the half precision storage on and off.  It's only on if the CPU has F16C,
+	// whatever you set it to.
+	bool halfStorage;
+
+	// Every pair the test said collides, with i < j like ContactListCircles.
+	ContactList contacts;
+
+	HalfPrecisionCircles(int numCircles = NUM_CIRCLES, float worldSize = 1000.0f);
+	~HalfPrecisionCircles();
+
+	void Update();
+	void CheckForCollisions();
+
+	// Checks contacts against the exact 32 bit test.  falsePositives are pairs in the list
+	// that aren't really touching, falseNegatives are pairs that are touching but missing.
+	// With halfStorage off both are 0.
+	void CountErrors(int& falsePositives, int& falseNegatives);
+
+	// The furthest any position or radius moved when it was rounded to half precision.
+	float MaxRoundingError();
+
+	// True if this CPU can run the half precision kernel.
+	static bool Supported();
+
+private:
+	void Encode();
+	void CheckForCollisionsHalf();
+
+	HalfPrecisionCircles(const HalfPrecisionCircles&);
+	HalfPrecisionCircles& operator=(const HalfPrecisionCircles&);
+};
@@ -28,6 +28,8 @@ function as a simple timer.
 #pragma once
 #include <random>
 #include <ctime>
+#include <chrono>
+#include <cstring>
 
 
 namespace Helper{
@@ -44,6 +46,67 @@ namespace Helper{
 		return (max - min) * distribution(generator) + min;
 	}
 
+	/// <summary>
+	/// Rounds a number of circles up to a whole number of SIMD registers
+	/// </summary>
+	/// <param name="numCircles">Number of real circles</param>
+	/// <param name="width">Floats per register, which has to be a power of 2</param>
+	/// <returns>The padded count</returns>
+	static int PadCircles(int numCircles, int width){
+		return (numCircles + width - 1) & ~(width - 1);
+	}
+
+	// Where padding circles live.  Far enough away that nothing can ever reach them, but
+	// small enough that squaring the distance to one doesn't overflow to infinity.
+	static const float paddingPosition = 1.0e18f;
+
+	/// <summary>
+	/// Fills the circles between numCircles and paddedCircles with circles that never
+	/// collide with anything, so a SIMD loop can run straight through them
+	/// </summary>
+	/// <param name="xPosition">X positions</param>
+	/// <param name="xVelocity">X velocities</param>
+	/// <param name="yPosition">Y positions</param>
+	/// <param name="yVelocity">Y velocities</param>
+	/// <param name="radius">Radii</param>
+	/// <param name="numCircles">Number of real circles</param>
+	/// <param name="paddedCircles">Size of the arrays</param>
+	static void FillPadding(float* xPosition, float* xVelocity, float* yPosition, float* yVelocity, float* radius,
+		int numCircles, int paddedCircles){
+		for (int i = numCircles; i < paddedCircles; ++i){
+			xPosition[i] = paddingPosition;
+			yPosition[i] = paddingPosition;
+			xVelocity[i] = 0.0f;
+			yVelocity[i] = 0.0f;
+			radius[i] = 0.0f;
+		}
+	}
+
+	/// <summary>
+	/// Copies one world's circles over another's, so two versions can be run on exactly
+	/// the same circles
+	/// </summary>
+	/// <param name="xPosition">X positions to copy into</param>
+	/// <param name="xVelocity">X velocities to copy into</param>
+	/// <param name="yPosition">Y positions to copy into</param>
+	/// <param name="yVelocity">Y velocities to copy into</param>
+	/// <param name="radius">Radii to copy into</param>
+	/// <param name="fromXPosition">X positions to copy from</param>
+	/// <param name="fromXVelocity">X velocities to copy from</param>
+	/// <param name="fromYPosition">Y positions to copy from</param>
+	/// <param name="fromYVelocity">Y velocities to copy from</param>
+	/// <param name="fromRadius">Radii to copy from</param>
+	/// <param name="count">How many circles to copy, padding included if both have it</param>
+	static void CopyCircles(float* xPosition, float* xVelocity, float* yPosition, float* yVelocity, float* radius,
+		const float* fromXPosition, const float* fromXVelocity, const float* fromYPosition, const float* fromYVelocity,
+		const float* fromRadius, int count){
+		memcpy(xPosition, fromXPosition, sizeof(float) * count);
+		memcpy(xVelocity, fromXVelocity, sizeof(float) * count);
+		memcpy(yPosition, fromYPosition, sizeof(float) * count);
+		memcpy(yVelocity, fromYVelocity, sizeof(float) * count);
+		memcpy(radius, fromRadius, sizeof(float) * count);
+	}
+
 	static clock_t timer;
 
 	static void StartTimer(){
@@ -55,4 +118,17 @@ namespace Helper{
 		return (float)timer / CLOCKS_PER_SEC;
 	}
 
+	// clock() is CPU time on Linux, added up over every thread, so 4 threads each busy
+	// for a second reads as 4 seconds.  Anything that runs on more than one thread is
+	// timed with this instead, which is the time on the wall.
+	static std::chrono::steady_clock::time_point wallTimer;
+
+	static void StartWallTimer(){
+		wallTimer = std::chrono::steady_clock::now();
+	}
+
+	static float StopWallTimer(){
+		return std::chrono::duration<float>(std::chrono::steady_clock::now() - wallTimer).count();
+	}
+
 }
\ No newline at end of file
@@ -0,0 +1,326 @@
+/*
+Title: Optimizing Collision Detection
+File Name: HierarchicalGridCircles.cpp
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+A version of GridOptimizedCircles.cpp with a stack of grids, one for each size of
+circle, kept in SoA form so the SIMD test can run straight down each cell.
+*/
+
+#include "HierarchicalGridCircles.h"
+#include "Platform.h"
+#include "HelperFunctions.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+
+HierarchicalGridCircles::HierarchicalGridCircles(int numCircles, float worldSize, float minRadius, float maxRadius, int maxLevels)
+{
+	this->numCircles = numCircles;
+	this->worldSize = worldSize;
+	this->minRadius = minRadius;
+	this->maxRadius = maxRadius;
+	AllocateCircles();
+
+	for (int i = 0; i < numCircles; ++i){
+		xPosition[i] = Helper::RandomFloat(0, worldSize);
+		yPosition[i] = Helper::RandomFloat(0, worldSize);
+		xVelocity[i] = Helper::RandomFloat(-1.0f, 1.0f);
+		yVelocity[i] = Helper::RandomFloat(-1.0f, 1.0f);
+		radius[i] = Helper::RandomFloat(minRadius, maxRadius);
+	}
+
+	BuildLevels(maxLevels);
+}
+
+HierarchicalGridCircles::HierarchicalGridCircles(const HierarchicalGridCircles& source, int maxLevels)
+{
+	numCircles = source.numCircles;
+	worldSize = source.worldSize;
+	minRadius = source.minRadius;
+	maxRadius = source.maxRadius;
+	AllocateCircles();
+
+	memcpy(xPosition, source.xPosition, numCircles * sizeof(float));
+	memcpy(xVelocity, source.xVelocity, numCircles * sizeof(float));
+	memcpy(yPosition, source.yPosition, numCircles * sizeof(float));
+	memcpy(yVelocity, source.yVelocity, numCircles * sizeof(float));
+	memcpy(radius, source.radius, numCircles * sizeof(float));
+
+	BuildLevels(maxLevels);
+}
+
+void HierarchicalGridCircles::AllocateCircles(){
+	pairsTested = 0;
+
+	xPosition = (float*)malloc(numCircles * sizeof(float));
+	xVelocity = (float*)malloc(numCircles * sizeof(float));
+	yPosition = (float*)malloc(numCircles * sizeof(float));
+	yVelocity = (float*)malloc(numCircles * sizeof(float));
+	radius = (float*)malloc(numCircles * sizeof(float));
+}
+
+void HierarchicalGridCircles::BuildLevels(int maxLevels){
+	// Level 0's cells fit the smallest circles, and each level up doubles.  Stop as soon
+	// as a level fits the biggest, or at maxLevels, in which case the top level's cells
+	// are just made big enough for everything.
+	numLevels = 1;
+	while (numLevels < maxLevels && 2.0f * minRadius * (float)(1 << (numLevels - 1)) < 2.0f * maxRadius){
+		++numLevels;
+	}
+
+	levels = (Level*)malloc(sizeof(Level) * numLevels);
+	int* circleLevel = (int*)malloc(sizeof(int) * numCircles);
+	for (int l = 0; l < numLevels; ++l){
+		levels[l].cellSize = l == numLevels - 1 ? 2.0f * maxRadius : 2.0f * minRadius * (float)(1 << l);
+		levels[l].inverseCellSize = 1.0f / levels[l].cellSize;
+		levels[l].count = 0;
+	}
+
+	// The radii never change, so which level a circle is in never changes either.  Work
+	// it out once, here, and keep a list of each level's circles.
+	for (int i = 0; i < numCircles; ++i){
+		int l = 0;
+		while (l < numLevels - 1 && levels[l].cellSize < 2.0f * radius[i]){
+			++l;
+		}
+		circleLevel[i] = l;
+		++levels[l].count;
+	}
+
+	for (int l = 0; l < numLevels; ++l){
+		Level& level = levels[l];
+		level.numBuckets = 1;
+		while (level.numBuckets < level.count * 2){
+			level.numBuckets <<= 1;
+		}
+
+		level.bucketStart = (int*)malloc(sizeof(int) * (level.numBuckets + 1));
+		level.members = (int*)malloc(sizeof(int) * (level.count + 1));
+		level.circleBucket = (int*)malloc(sizeof(int) * (level.count + 1));
+		level.sortedIndex = (int*)malloc(sizeof(int) * (level.count + 4));
+		level.sortedX = (float*)malloc(sizeof(float) * (level.count + 4));
+		level.sortedY = (float*)malloc(sizeof(float) * (level.count + 4));
+		level.sortedRadius = (float*)malloc(sizeof(float) * (level.count + 4));
+
+		for (int s = level.count; s < level.count + 4; ++s){
+			level.sortedIndex[s] = -1;
+			level.sortedX[s] = Helper::paddingPosition;
+			level.sortedY[s] = Helper::paddingPosition;
+			level.sortedRadius[s] = 0.0f;
+		}
+		level.count = 0;
+	}
+	for (int i = 0; i < numCircles; ++i){
+		Level& level = levels[circleLevel[i]];
+		level.members[level.count++] = i;
+	}
+	free(circleLevel);
+
+	for (int l = 0; l < numLevels; ++l){
+		BuildLevel(levels[l]);
+	}
+}
+
+HierarchicalGridCircles::~HierarchicalGridCircles()
+{
+	free(xPosition);
+	free(xVelocity);
+	free(yPosition);
+	free(yVelocity);
+	free(radius);
+
+	for (int l = 0; l < numLevels; ++l){
+		free(levels[l].bucketStart);
+		free(levels[l].members);
+		free(levels[l].circleBucket);
+		free(levels[l].sortedIndex);
+		free(levels[l].sortedX);
+		free(levels[l].sortedY);
+		free(levels[l].sortedRadius);
+	}
+	free(levels);
+}
+
+int HierarchicalGridCircles::HashCell(const Level& level, int x, int y){
+	return (int)(((unsigned int)x * 73856093u) ^ ((unsigned int)y * 19349663u)) & (level.numBuckets - 1);
+}
+
+void HierarchicalGridCircles::BuildLevel(Level& level){
+	// The same counting sort as GridOptimizedCircles::BuildGrid, over one level's circles.
+	memset(level.bucketStart, 0, sizeof(int) * (level.numBuckets + 1));
+	for (int m = 0; m < level.count; ++m){
+		int i = level.members[m];
+		level.circleBucket[m] = HashCell(level,
+			(int)floorf(xPosition[i] * level.inverseCellSize),
+			(int)floorf(yPosition[i] * level.inverseCellSize));
+		++level.bucketStart[level.circleBucket[m] + 1];
+	}
+
+	for (int b = 0; b < level.numBuckets; ++b){
+		level.bucketStart[b + 1] += level.bucketStart[b];
+	}
+
+	for (int m = 0; m < level.count; ++m){
+		int i = level.members[m];
+		int slot = level.bucketStart[level.circleBucket[m]]++;
+		level.sortedIndex[slot] = i;
+		level.sortedX[slot] = xPosition[i];
+		level.sortedY[slot] = yPosition[i];
+		level.sortedRadius[slot] = radius[i];
+	}
+	for (int b = level.numBuckets; b > 0; --b){
+		level.bucketStart[b] = level.bucketStart[b - 1];
+	}
+	level.bucketStart[0] = 0;
+}
+
+void HierarchicalGridCircles::Update(){
+	for (int i = 0; i < numCircles; ++i){
+		xPosition[i] += xVelocity[i];
+		yPosition[i] += yVelocity[i];
+	}
+
+	for (int l = 0; l < numLevels; ++l){
+		BuildLevel(levels[l]);
+	}
+}
+
+void HierarchicalGridCircles::TestRange(const Level& level, int start, int end, int self, bool sameLevel){
+	// This is SIMDOptimizedCircles' test, just run down one bucket of the sorted arrays
+	// instead of down a row.  A bucket can start anywhere, so these are unaligned loads.
+	__m128 xPos = _mm_set1_ps(xPosition[self]);
+	__m128 yPos = _mm_set1_ps(yPosition[self]);
+	__m128 rad = _mm_set1_ps(radius[self]);
+	__m128i selfIndex = _mm_set1_epi32(self);
+
+	contacts.Reserve(end - start + 4);
+	ContactPair* out = contacts.pairs + contacts.count;
+
+	for (int s = start; s < end; s += 4){
+		__m128 xDif = _mm_sub_ps(xPos, _mm_loadu_ps(level.sortedX + s));
+		__m128 yDif = _mm_sub_ps(yPos, _mm_loadu_ps(level.sortedY + s));
+		__m128 radiusAdd = _mm_add_ps(rad, _mm_loadu_ps(level.sortedRadius + s));
+
+		int mask = _mm_movemask_ps(
+			_mm_cmplt_ps(
+				_mm_add_ps(_mm_mul_ps(xDif, xDif), _mm_mul_ps(yDif, yDif)),
+				_mm_mul_ps(radiusAdd, radiusAdd)));
+
+		// The last group of a bucket runs into the next bucket (or the padding on the
+		// end), so only keep the lanes that are really in this one.
+		mask &= end - s >= 4 ? 0xF : (1 << (end - s)) - 1;
+
+		// In its own level every pair turns up twice, once from each side, so keep the
+		// side where the other index is bigger.  Across levels each pair only turns up
+		// once, from the smaller circle, so there's nothing to throw away.
+		__m128i other = _mm_loadu_si128((const __m128i*)(level.sortedIndex + s));
+		if (sameLevel){
+			mask &= _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(other, selfIndex)));
+		}
+
+		int ids[4];
+		_mm_storeu_si128((__m128i*)ids, other);
+		for (int lane = 0; lane < 4; ++lane){
+			out->i = self < ids[lane] ? self : ids[lane];
+			out->j = self < ids[lane] ? ids[lane] : self;
+			out += (mask >> lane) & 1;
+		}
+	}
+
+	contacts.count = (int)(out - contacts.pairs);
+	pairsTested += end - start;
+}
+
+void HierarchicalGridCircles::CheckForCollisions(){
+	contacts.Clear();
+	pairsTested = 0;
+
+	int buckets[9];
+
+	for (int l = 0; l < numLevels; ++l){
+		const Level& level = levels[l];
+
+		for (int s = 0; s < level.count; ++s){
+			int self = level.sortedIndex[s];
+			float x = xPosition[self];
+			float y = yPosition[self];
+
+			// Its own level, and then every level above it.  Cells at a level are at least
+			// as wide as that level's biggest circle plus anything smaller, so the 3 by 3
+			// block around the circle is still all that can reach it.  Levels below this
+			// one are skipped completely: those circles test against this one from their
+			// side, so every pair gets looked at exactly once.  Empty levels are skipped too.
+			for (int up = l; up < numLevels; ++up){
+				const Level& target = levels[up];
+				if (target.count == 0){
+					continue;
+				}
+
+				int cellX = (int)floorf(x * target.inverseCellSize);
+				int cellY = (int)floorf(y * target.inverseCellSize);
+
+				int numNeighbors = 0;
+				for (int dy = -1; dy <= 1; ++dy){
+					for (int dx = -1; dx <= 1; ++dx){
+						int bucket = HashCell(target, cellX + dx, cellY + dy);
+						bool repeated = false;
+						for (int n = 0; n < numNeighbors; ++n){
+							repeated |= buckets[n] == bucket;
+						}
+						if (!repeated){
+							buckets[numNeighbors++] = bucket;
+						}
+					}
+				}
+
+				for (int n = 0; n < numNeighbors; ++n){
+					int start = target.bucketStart[buckets[n]];
+					int end = target.bucketStart[buckets[n] + 1];
+					if (start < end){
+						TestRange(target, start, end, self, up == l);
+					}
+				}
+			}
+		}
+	}
+}
+
+int HierarchicalGridCircles::CountMismatches(){
+	return CountContactMismatches(contacts, xPosition, yPosition, radius, numCircles);
+}
+
+int HierarchicalGridCircles::LevelCount(int level){
+	return levels[level].count;
+}
+
+float HierarchicalGridCircles::LevelCellSize(int level){
+	return levels[level].cellSize;
+}
+
+// When does this win?  Levels roughly halve the pairs tested in every test in main.cpp,
+// but each circle pays for hashing a 3 by 3 block in every level above it, and a lot of
+// those buckets only hold one or two circles, which wastes most of a SIMD register.  So
+// it wins when the small circles are crowded into cells that were sized for the big ones,
+// and when there are a lot of levels and not much in them it only breaks even.  Raising
+// minRadius (fewer, fuller levels) is the knob to try first.
@@ -0,0 +1,108 @@
+/*
+Title: Optimizing Collision Detection
+File Name: HierarchicalGridCircles.h
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+A version of GridOptimizedCircles.cpp with a stack of grids, one for each size of
+circle, kept in SoA form so the SIMD test can run straight down each cell.
+*/
+#pragma once
+#include "Settings.h"
+#include "ContactList.h"
+
+class HierarchicalGridCircles
+{
+public:
+	// GridOptimizedCircles picks one cell size, big enough for the two biggest circles.
+	// With radii from 5 to 100, a cell that size can hold a whole crowd of small circles
+	// that are nowhere near each other, and every one of them tests every other.  Go the
+	// other way, with small cells, and the big circles poke into dozens of cells each.
+	//
+	// So here's a stack of grids instead, each cell twice the size of the one below.
+	// Every circle goes in the smallest level whose cells are at least its diameter.
+	int numCircles;
+	float worldSize;
+	int numLevels;
+
+	float* xPosition;
+	float* xVelocity;
+	float* yPosition;
+	float* yVelocity;
+	float* radius;
+
+	// Every colliding pair, with i < j like ContactListCircles.
+	ContactList contacts;
+
+	// maxLevels of 1 puts everyone in one level, which is the plain single grid (with the
+	// same SIMD test), to compare against.
+	HierarchicalGridCircles(int numCircles = NUM_CIRCLES, float worldSize = 1000.0f,
+		float minRadius = 5.0f, float maxRadius = 100.0f, int maxLevels = 8);
+
+	// The exact same circles as source, where they are right now, sorted into up to
+	// maxLevels levels.  That way one level and many levels can be run on one world.
+	HierarchicalGridCircles(const HierarchicalGridCircles& source, int maxLevels);
+	~HierarchicalGridCircles();
+
+	void Update();
+	void CheckForCollisions();
+
+	// Checks contacts against every pair the slow way.  Should be 0.
+	int CountMismatches();
+
+	// How many circles ended up in each level, and how many pairs the SIMD test looked
+	// at last frame, for main.cpp to print.
+	int LevelCount(int level);
+	float LevelCellSize(int level);
+	long long pairsTested;
+
+private:
+	// One level is the same hashed, counting-sorted grid as GridOptimizedCircles, just
+	// kept in SoA form so a bucket is 4 floats at a time for the SIMD test.  The sorted
+	// arrays have 4 padding circles on the end so the last load never runs off.
+	struct Level{
+		float cellSize;
+		float inverseCellSize;
+		int count;
+		int numBuckets;
+		int* bucketStart;
+		int* members;
+		int* circleBucket;
+		int* sortedIndex;
+		float* sortedX;
+		float* sortedY;
+		float* sortedRadius;
+	};
+	Level* levels;
+	float minRadius;
+	float maxRadius;
+
+	// Allocates the circle arrays, and once they're filled in, builds the levels.
+	void AllocateCircles();
+	void BuildLevels(int maxLevels);
+
+	int HashCell(const Level& level, int x, int y);
+	void BuildLevel(Level& level);
+	void TestRange(const Level& level, int start, int end, int self, bool sameLevel);
+
+	HierarchicalGridCircles(const HierarchicalGridCircles&);
+	HierarchicalGridCircles& operator=(const HierarchicalGridCircles&);
+};
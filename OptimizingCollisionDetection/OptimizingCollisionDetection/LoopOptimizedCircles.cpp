@@ -26,23 +26,31 @@ Shows off an example of how pulling operations out of a loop can make a big
 difference in performance.
 */
 #include "LoopOptimizedCircles.h"
+#include <cstring>
 
 
 // This is just setting up that array again.
-LoopOptimizedCircles::LoopOptimizedCircles()
+LoopOptimizedCircles::LoopOptimizedCircles(int numCircles)
 {
-	for (int i = 0; i < NUM_CIRCLES; ++i){
-		isCollided[i] = (bool*)malloc(sizeof(bool) * NUM_CIRCLES);
-		memset(isCollided[i], 0, sizeof(bool) * NUM_CIRCLES);
+	// new[] runs Circle's constructor on every one of them, same as the old fixed array did.
+	this->numCircles = numCircles;
+	circles = new Circle[numCircles];
+
+	isCollided = (bool**)malloc(sizeof(bool*) * numCircles);
+	for (int i = 0; i < numCircles; ++i){
+		isCollided[i] = (bool*)malloc(sizeof(bool) * numCircles);
+		memset(isCollided[i], 0, sizeof(bool) * numCircles);
 	}
 }
 
 // And clearing it at the end of the program.  Always free your memory folks.
 LoopOptimizedCircles::~LoopOptimizedCircles()
 {
-	for (int i = 0; i < NUM_CIRCLES; ++i){
+	for (int i = 0; i < numCircles; ++i){
 		free(isCollided[i]);
 	}
+	free(isCollided);
+	delete[] circles;
 }
 
 // Okay, so showing off update first because you get the idea (and this method needed
@@ -51,7 +59,7 @@ void LoopOptimizedCircles::Update(){
 
 	// All this is is the same thing, but the function to Update all of the circles is being
 	// called once, instead of once for each circle.
-	for (int i = 0; i < NUM_CIRCLES; ++i){
+	for (int i = 0; i < numCircles; ++i){
 		circles[i].xPosition += circles[i].xVelocity;
 		circles[i].yPosition += circles[i].yVelocity;
 	}
@@ -59,8 +67,8 @@ void LoopOptimizedCircles::Update(){
 
 void LoopOptimizedCircles::CheckForCollisions(){
 	// Same down here, actually.
-	for (int i = 0; i < NUM_CIRCLES; ++i){
-		for (int j = 0; j < NUM_CIRCLES; ++j){
+	for (int i = 0; i < numCircles; ++i){
+		for (int j = 0; j < numCircles; ++j){
 			isCollided[i][j] = (circles[i].xPosition - circles[j].xPosition) * (circles[i].xPosition - circles[j].xPosition)
 				+ (circles[i].yPosition - circles[j].yPosition) * (circles[i].yPosition - circles[j].yPosition)
 				< (circles[i].radius + circles[j].radius) + (circles[i].radius + circles[j].radius);
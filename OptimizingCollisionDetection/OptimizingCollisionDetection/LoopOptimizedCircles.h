@@ -51,16 +51,17 @@ class LoopOptimizedCircles
 public:
 
 	// And we have an array of this struct.
-	Circle circles[NUM_CIRCLES];
+	Circle* circles;
+	int numCircles;
 
 	// This is actually a data pattern, known as AOS (or Array of Structs).
 	// It's when you lay out your data in this fashion.  Having an array of classes is the same
 	// thing.  If you are confused why this distinction is important, don't worry it'll be clear
 	// in the next test.  For now let's go to LoopOptimizedCircles.cpp to see what's going on.
 
-	bool* isCollided[NUM_CIRCLES];
+	bool** isCollided;
 
-	LoopOptimizedCircles();
+	LoopOptimizedCircles(int numCircles = NUM_CIRCLES);
 	~LoopOptimizedCircles();
 
 	void Update();
@@ -0,0 +1,206 @@
+/*
+Title: Optimizing Collision Detection
+File Name: NeighborListCircles.cpp
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+A version of ContactListCircles.cpp that keeps a list of every pair close enough
+to touch soon, and only tests those until something has moved too far.
+*/
+
+#include "NeighborListCircles.h"
+#include "Platform.h"
+#include "HelperFunctions.h"
+
+NeighborListCircles::NeighborListCircles(int numCircles, float skin)
+{
+	this->numCircles = numCircles;
+	paddedCircles = Helper::PadCircles(numCircles, 4);
+
+	xPosition = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	xVelocity = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	yPosition = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	yVelocity = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	radius = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	xAtBuild = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	yAtBuild = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+
+	for (int i = 0; i < numCircles; ++i){
+		xPosition[i] = Helper::RandomFloat(0, 1000.0f);
+		yPosition[i] = Helper::RandomFloat(0, 1000.0f);
+		xVelocity[i] = Helper::RandomFloat(-1.0f, 1.0f);
+		yVelocity[i] = Helper::RandomFloat(-1.0f, 1.0f);
+		radius[i] = Helper::RandomFloat(5.0f, 100.0f);
+	}
+	Helper::FillPadding(xPosition, xVelocity, yPosition, yVelocity, radius, numCircles, paddedCircles);
+
+	rebuilds = 0;
+	frames = 0;
+	SetSkin(skin);
+}
+
+NeighborListCircles::~NeighborListCircles()
+{
+	_aligned_free(xPosition);
+	_aligned_free(yPosition);
+	_aligned_free(xVelocity);
+	_aligned_free(yVelocity);
+	_aligned_free(radius);
+	_aligned_free(xAtBuild);
+	_aligned_free(yAtBuild);
+}
+
+void NeighborListCircles::SetSkin(float skin){
+	this->skin = skin < 0.0f ? 0.0f : skin;
+	Rebuild();
+}
+
+float NeighborListCircles::Skin(){
+	return skin;
+}
+
+void NeighborListCircles::Update(){
+	for (int i = 0; i < paddedCircles; i += 4){
+		_mm_store_ps(xPosition + i, _mm_add_ps(_mm_load_ps(xPosition + i), _mm_load_ps(xVelocity + i)));
+		_mm_store_ps(yPosition + i, _mm_add_ps(_mm_load_ps(yPosition + i), _mm_load_ps(yVelocity + i)));
+	}
+}
+
+bool NeighborListCircles::NeedsRebuild(){
+	// Say two circles were skin apart (edge to edge) at the rebuild, so they just missed
+	// the list.  For them to touch now, between them they have to have closed that gap.
+	// If nothing has moved more than skin / 2 since, no two circles can have closed more
+	// than skin between them, and the list is still good.  So all we need is the biggest
+	// distance anyone has moved, which is one quick SIMD pass.
+	__m128 farthest = _mm_setzero_ps();
+	for (int i = 0; i < paddedCircles; i += 4){
+		__m128 dx = _mm_sub_ps(_mm_load_ps(xPosition + i), _mm_load_ps(xAtBuild + i));
+		__m128 dy = _mm_sub_ps(_mm_load_ps(yPosition + i), _mm_load_ps(yAtBuild + i));
+		farthest = _mm_max_ps(farthest, _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+	}
+	farthest = _mm_max_ps(farthest, _mm_shuffle_ps(farthest, farthest, _MM_SHUFFLE(1, 0, 3, 2)));
+	farthest = _mm_max_ps(farthest, _mm_shuffle_ps(farthest, farthest, _MM_SHUFFLE(2, 3, 0, 1)));
+
+	float halfSkin = skin * 0.5f;
+	return _mm_cvtss_f32(farthest) > halfSkin * halfSkin;
+}
+
+void NeighborListCircles::Rebuild(){
+	// The same triangle as ContactListCircles, with skin added to every radius.  This is
+	// the expensive part, and the whole point is to do it as rarely as we can get away
+	// with.
+	neighbors.Clear();
+	__m128 padding = _mm_set1_ps(skin);
+
+	for (int i = 0; i < numCircles; ++i){
+		__m128 xPos = _mm_load1_ps(xPosition + i);
+		__m128 yPos = _mm_load1_ps(yPosition + i);
+		__m128 rad = _mm_add_ps(_mm_load1_ps(radius + i), padding);
+
+		int j = i & ~3;
+		int validLanes = (0xF << ((i & 3) + 1)) & 0xF;
+
+		neighbors.Reserve(paddedCircles - j + 4);
+		ContactPair* out = neighbors.pairs + neighbors.count;
+
+		do {
+			__m128 xDif = _mm_sub_ps(xPos, _mm_load_ps(xPosition + j));
+			__m128 yDif = _mm_sub_ps(yPos, _mm_load_ps(yPosition + j));
+			__m128 radiusAdd = _mm_add_ps(rad, _mm_load_ps(radius + j));
+
+			int mask = _mm_movemask_ps(
+				_mm_cmplt_ps(
+					_mm_add_ps(_mm_mul_ps(xDif, xDif), _mm_mul_ps(yDif, yDif)),
+					_mm_mul_ps(radiusAdd, radiusAdd))) & validLanes;
+
+			out->i = i; out->j = j;     out += mask & 1;
+			out->i = i; out->j = j + 1; out += (mask >> 1) & 1;
+			out->i = i; out->j = j + 2; out += (mask >> 2) & 1;
+			out->i = i; out->j = j + 3; out += (mask >> 3) & 1;
+
+			validLanes = 0xF;
+			j += 4;
+		} while (j < paddedCircles);
+
+		neighbors.count = (int)(out - neighbors.pairs);
+	}
+
+	memcpy(xAtBuild, xPosition, paddedCircles * sizeof(float));
+	memcpy(yAtBuild, yPosition, paddedCircles * sizeof(float));
+	++rebuilds;
+}
+
+void NeighborListCircles::CheckForCollisions(){
+	if (NeedsRebuild()){
+		Rebuild();
+	}
+	++frames;
+
+	// Most frames it's just this: run down the list and keep the pairs that overlap.
+	// The list is in no useful order for SIMD, so each group of 4 pairs gets loaded
+	// a lane at a time, the same as ContactResolver does.  Then it's the usual test and
+	// the usual branch free write out.
+	contacts.Clear();
+	contacts.Reserve(neighbors.count + 4);
+	ContactPair* out = contacts.pairs;
+
+	for (int n = 0; n < neighbors.count; n += 4){
+		// Past the end of the list, just repeat the last pair and mask it off.
+		int lanes = neighbors.count - n < 4 ? neighbors.count - n : 4;
+		const ContactPair* pair[4];
+		for (int lane = 0; lane < 4; ++lane){
+			pair[lane] = neighbors.pairs + n + (lane < lanes ? lane : lanes - 1);
+		}
+
+		__m128 xDif = _mm_sub_ps(
+			_mm_setr_ps(xPosition[pair[0]->i], xPosition[pair[1]->i], xPosition[pair[2]->i], xPosition[pair[3]->i]),
+			_mm_setr_ps(xPosition[pair[0]->j], xPosition[pair[1]->j], xPosition[pair[2]->j], xPosition[pair[3]->j]));
+		__m128 yDif = _mm_sub_ps(
+			_mm_setr_ps(yPosition[pair[0]->i], yPosition[pair[1]->i], yPosition[pair[2]->i], yPosition[pair[3]->i]),
+			_mm_setr_ps(yPosition[pair[0]->j], yPosition[pair[1]->j], yPosition[pair[2]->j], yPosition[pair[3]->j]));
+		__m128 radiusAdd = _mm_add_ps(
+			_mm_setr_ps(radius[pair[0]->i], radius[pair[1]->i], radius[pair[2]->i], radius[pair[3]->i]),
+			_mm_setr_ps(radius[pair[0]->j], radius[pair[1]->j], radius[pair[2]->j], radius[pair[3]->j]));
+
+		int mask = _mm_movemask_ps(
+			_mm_cmplt_ps(
+				_mm_add_ps(_mm_mul_ps(xDif, xDif), _mm_mul_ps(yDif, yDif)),
+				_mm_mul_ps(radiusAdd, radiusAdd))) & ((1 << lanes) - 1);
+
+		*out = *pair[0]; out += mask & 1;
+		*out = *pair[1]; out += (mask >> 1) & 1;
+		*out = *pair[2]; out += (mask >> 2) & 1;
+		*out = *pair[3]; out += (mask >> 3) & 1;
+	}
+
+	contacts.count = (int)(out - contacts.pairs);
+}
+
+int NeighborListCircles::CountMismatches(){
+	return CountContactMismatches(contacts, xPosition, yPosition, radius, numCircles);
+}
+
+// Picking the skin is a trade.  Bigger means more frames between rebuilds, but a longer
+// list to test every frame, and the list grows with the square of the reach.  With
+// speeds of about 1 a frame and radii in the tens, a skin of 40 rebuilds about every
+// 15 frames and keeps the list under twice the real contacts.  Past that the list
+// starts costing more than the rebuilds save.  main.cpp sweeps a few values so you can
+// see where it bottoms out.
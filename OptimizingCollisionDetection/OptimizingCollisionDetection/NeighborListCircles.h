@@ -0,0 +1,82 @@
+/*
+Title: Optimizing Collision Detection
+File Name: NeighborListCircles.h
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+A version of ContactListCircles.cpp that keeps a list of every pair close enough
+to touch soon, and only tests those until something has moved too far.
+*/
+#pragma once
+#include "Settings.h"
+#include "ContactList.h"
+
+class NeighborListCircles
+{
+public:
+	float* xPosition;
+	float* xVelocity;
+	float* yPosition;
+	float* yVelocity;
+	float* radius;
+
+	int numCircles;
+	int paddedCircles;
+
+	// Every pair (i < j) that was within r_i + r_j + skin of each other at the last
+	// rebuild.  Nothing outside this list can possibly be touching yet.
+	ContactList neighbors;
+
+	// The pairs from the list that actually overlap this frame.
+	ContactList contacts;
+
+	NeighborListCircles(int numCircles = NUM_CIRCLES, float skin = NEIGHBOR_SKIN);
+	~NeighborListCircles();
+
+	// Rebuilds the list straight away.  Not something to call every frame.
+	void SetSkin(float skin);
+	float Skin();
+
+	void Update();
+
+	// Rebuilds the list if anything has moved far enough to need it, then tests the list.
+	void CheckForCollisions();
+
+	// How many times the list has been rebuilt, and how many frames have been checked.
+	int rebuilds;
+	int frames;
+
+	// Checks the contacts against the brute force answer.  Should always be 0.
+	int CountMismatches();
+
+private:
+	float skin;
+
+	// Where everything was at the last rebuild.
+	float* xAtBuild;
+	float* yAtBuild;
+
+	bool NeedsRebuild();
+	void Rebuild();
+
+	NeighborListCircles(const NeighborListCircles&);
+	NeighborListCircles& operator=(const NeighborListCircles&);
+};
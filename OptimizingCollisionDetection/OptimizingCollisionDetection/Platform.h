@@ -0,0 +1,226 @@
+/*
+Title: Optimizing Collision Detection
+File Name: Platform.h
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+The few things Visual Studio gives us for free that other compilers spell
+differently: intrinsics, aligned allocation, _getch, and asking the CPU what
+instruction sets it has.
+*/
+#pragma once
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <malloc.h>
+#include <conio.h>
+#include <cstdio>
+
+// snprintf only showed up in Visual Studio 2015, and this project builds with 2013.
+// _snprintf_s with _TRUNCATE does the same thing: never writes past size, always ends
+// the string.
+#if _MSC_VER < 1900
+#define snprintf(buffer, size, ...) _snprintf_s(buffer, size, _TRUNCATE, __VA_ARGS__)
+#endif
+
+// Visual Studio lets you use any intrinsic in any function.
+#define TARGET_AVX2
+#define TARGET_AVX512
+#define TARGET_F16C
+#define BEGIN_TARGET_AVX2
+#define BEGIN_TARGET_AVX512
+#define END_TARGET
+
+#else
+#include <immintrin.h>
+#include <cpuid.h>
+#include <cstdio>
+
+static inline void* _aligned_malloc(size_t size, size_t alignment){
+	void* memory = 0;
+	if (posix_memalign(&memory, alignment < sizeof(void*) ? sizeof(void*) : alignment, size) != 0){
+		return 0;
+	}
+	return memory;
+}
+
+static inline void _aligned_free(void* memory){
+	free(memory);
+}
+
+static inline int _getch(){
+	return getchar();
+}
+
+// GCC and Clang won't let you use an AVX2 intrinsic unless the whole file is built for
+// AVX2, which would let the compiler sneak AVX2 into code that's meant to run anywhere.
+// Marking just the functions that need it keeps the rest of the program safe.
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+#define TARGET_F16C __attribute__((target("f16c")))
+
+// The same thing for a whole stretch of a file at once.  Templates need this, because
+// there's no way to put a different attribute on each instantiation.  Everything between
+// BEGIN and END_TARGET is built for that instruction set, so keep it to code that only
+// ever runs after asking the CPU.
+#ifdef __clang__
+#define BEGIN_TARGET_AVX2 _Pragma("clang attribute push (__attribute__((target(\"avx2,fma\"))), apply_to = function)")
+#define BEGIN_TARGET_AVX512 _Pragma("clang attribute push (__attribute__((target(\"avx512f\"))), apply_to = function)")
+#define END_TARGET _Pragma("clang attribute pop")
+#else
+#define BEGIN_TARGET_AVX2 _Pragma("GCC push_options") _Pragma("GCC target(\"avx2,fma\")")
+#define BEGIN_TARGET_AVX512 _Pragma("GCC push_options") _Pragma("GCC target(\"avx512f\")")
+#define END_TARGET _Pragma("GCC pop_options")
+#endif
+#endif
+
+// The AVX-512 intrinsics first showed up in Visual Studio 2017.
+#if !defined(_MSC_VER) || _MSC_VER >= 1911
+#define HAS_AVX512_INTRINSICS
+#endif
+
+namespace Platform{
+	static inline void CpuId(int leaf, unsigned int registers[4]){
+#ifdef _MSC_VER
+		__cpuidex((int*)registers, leaf, 0);
+#else
+		__cpuid_count(leaf, 0, registers[0], registers[1], registers[2], registers[3]);
+#endif
+	}
+
+	// Which registers the OS saves when it switches threads.  If it doesn't save the ymm
+	// or zmm registers, we can't use them even if the CPU has them.
+	static inline unsigned long long EnabledRegisterState(){
+#ifdef _MSC_VER
+		return _xgetbv(0);
+#else
+		unsigned int low, high;
+		__asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+		return ((unsigned long long)high << 32) | low;
+#endif
+	}
+
+	/// <summary>
+	/// True if the CPU and OS both support AVX2 and FMA.
+	/// </summary>
+	static inline bool SupportsAVX2(){
+		unsigned int registers[4];
+		CpuId(0, registers);
+		if (registers[0] < 7){
+			return false;
+		}
+
+		// Leaf 1, ecx: bit 12 is FMA, bit 27 is OSXSAVE (we're allowed to ask xgetbv) and
+		// bit 28 is AVX.
+		CpuId(1, registers);
+		if ((registers[2] & (1 << 12)) == 0 || (registers[2] & (1 << 27)) == 0 || (registers[2] & (1 << 28)) == 0){
+			return false;
+		}
+		if ((EnabledRegisterState() & 0x6) != 0x6){
+			return false;
+		}
+
+		// Leaf 7, ebx: bit 5 is AVX2.
+		CpuId(7, registers);
+		return (registers[1] & (1 << 5)) != 0;
+	}
+
+	/// <summary>
+	/// True if the CPU and OS both support F16C, the instructions that convert between
+	/// half and single precision floats.
+	/// </summary>
+	static inline bool SupportsF16C(){
+		// Leaf 1, ecx: bit 27 is OSXSAVE, bit 28 is AVX and bit 29 is F16C.  It's VEX
+		// encoded like AVX, so the OS has to be saving the ymm registers too.
+		unsigned int registers[4];
+		CpuId(1, registers);
+		if ((registers[2] & (1 << 27)) == 0 || (registers[2] & (1 << 28)) == 0 || (registers[2] & (1 << 29)) == 0){
+			return false;
+		}
+		return (EnabledRegisterState() & 0x6) == 0x6;
+	}
+
+	/// <summary>
+	/// Returns the index of the lowest set bit.  bits can't be 0
+	/// </summary>
+	static inline int LowestBit(unsigned int bits){
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward(&index, bits);
+		return (int)index;
+#else
+		return __builtin_ctz(bits);
+#endif
+	}
+
+	/// <summary>
+	/// Writes the CPU's name, like "Intel(R) Core(TM) i7-6700K CPU @ 4.00GHz", into model
+	/// </summary>
+	/// <param name="model">At least 49 chars</param>
+	static inline void CpuModel(char* model){
+		// Leaves 0x80000002 to 0x80000004 hand back the name 16 chars at a time.
+		unsigned int registers[4];
+		CpuId((int)0x80000000u, registers);
+		if (registers[0] < 0x80000004u){
+			strcpy(model, "unknown");
+			return;
+		}
+
+		char name[49];
+		for (int leaf = 0; leaf < 3; ++leaf){
+			CpuId((int)(0x80000002u + leaf), registers);
+			memcpy(name + leaf * 16, registers, 16);
+		}
+		name[48] = 0;
+
+		// Some chips pad the front with spaces.
+		const char* start = name;
+		while (*start == ' '){
+			++start;
+		}
+		strcpy(model, start);
+	}
+
+	/// <summary>
+	/// True if the CPU and OS both support AVX-512F, and this compiler can build it.
+	/// </summary>
+	static inline bool SupportsAVX512(){
+#ifdef HAS_AVX512_INTRINSICS
+		if (!SupportsAVX2()){
+			return false;
+		}
+
+		// The OS has to save the opmask registers and both halves of all 32 zmm registers.
+		if ((EnabledRegisterState() & 0xE6) != 0xE6){
+			return false;
+		}
+
+		// Leaf 7, ebx: bit 16 is AVX-512F.
+		unsigned int registers[4];
+		CpuId(7, registers);
+		return (registers[1] & (1 << 16)) != 0;
+#else
+		return false;
+#endif
+	}
+}
@@ -0,0 +1,111 @@
+/*
+Title: Optimizing Collision Detection
+File Name: PrecisionCircles.cpp
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+A version of ContactListCircles.cpp templated on the type of number it stores, so
+there is a double version for worlds too big for floats.
+*/
+
+#include "PrecisionCircles.h"
+#include "PrecisionKernels.h"
+#include "Platform.h"
+#include "HelperFunctions.h"
+
+
+template<class Scalar>
+PrecisionCircles<Scalar>::PrecisionCircles(int numCircles, Scalar origin)
+{
+	// Padded to 8, the widest register either type uses, so both kernels can run on the
+	// same arrays.  Aligned to 32 for the AVX loads.
+	this->numCircles = numCircles;
+	paddedCircles = Helper::PadCircles(numCircles, 8);
+	useAVX = Platform::SupportsAVX2();
+
+	xPosition = (Scalar*)_aligned_malloc(paddedCircles * sizeof(Scalar), 32);
+	xVelocity = (Scalar*)_aligned_malloc(paddedCircles * sizeof(Scalar), 32);
+	yPosition = (Scalar*)_aligned_malloc(paddedCircles * sizeof(Scalar), 32);
+	yVelocity = (Scalar*)_aligned_malloc(paddedCircles * sizeof(Scalar), 32);
+	radius = (Scalar*)_aligned_malloc(paddedCircles * sizeof(Scalar), 32);
+
+	for (int i = 0; i < numCircles; ++i){
+		xPosition[i] = origin + (Scalar)Helper::RandomFloat(0, 1000.0f);
+		yPosition[i] = origin + (Scalar)Helper::RandomFloat(0, 1000.0f);
+		xVelocity[i] = (Scalar)Helper::RandomFloat(-1.0f, 1.0f);
+		yVelocity[i] = (Scalar)Helper::RandomFloat(-1.0f, 1.0f);
+		radius[i] = (Scalar)Helper::RandomFloat(5.0f, 100.0f);
+	}
+
+	// Helper::FillPadding only does floats, so this is the same thing by hand.
+	for (int i = numCircles; i < paddedCircles; ++i){
+		xPosition[i] = (Scalar)Helper::paddingPosition;
+		yPosition[i] = (Scalar)Helper::paddingPosition;
+		xVelocity[i] = 0;
+		yVelocity[i] = 0;
+		radius[i] = 0;
+	}
+}
+
+template<class Scalar>
+PrecisionCircles<Scalar>::~PrecisionCircles()
+{
+	_aligned_free(xPosition);
+	_aligned_free(yPosition);
+	_aligned_free(xVelocity);
+	_aligned_free(yVelocity);
+	_aligned_free(radius);
+}
+
+template<class Scalar>
+void PrecisionCircles<Scalar>::Update(){
+	if (useAVX){
+		PrecisionKernel<typename PrecisionSimd<Scalar>::AVX>::Update(xPosition, yPosition, xVelocity, yVelocity, paddedCircles);
+	}
+	else {
+		PrecisionKernel<typename PrecisionSimd<Scalar>::SSE>::Update(xPosition, yPosition, xVelocity, yVelocity, paddedCircles);
+	}
+}
+
+template<class Scalar>
+void PrecisionCircles<Scalar>::CheckForCollisions(){
+	if (useAVX){
+		PrecisionKernel<typename PrecisionSimd<Scalar>::AVX>::CheckForCollisions(xPosition, yPosition, radius,
+			numCircles, paddedCircles, contacts);
+	}
+	else {
+		PrecisionKernel<typename PrecisionSimd<Scalar>::SSE>::CheckForCollisions(xPosition, yPosition, radius,
+			numCircles, paddedCircles, contacts);
+	}
+}
+
+template<class Scalar>
+int PrecisionCircles<Scalar>::CountMismatches(){
+	return CountContactMismatches(contacts, xPosition, yPosition, radius, numCircles);
+}
+
+template class PrecisionCircles<float>;
+template class PrecisionCircles<double>;
+
+// Another way out, if doubles cost too much: keep floats, but store every position
+// relative to the middle of whatever chunk of the map it's in, and move that middle when
+// the camera moves.  Then the numbers stay small and floats stay precise.  It's more
+// bookkeeping, and pairs that straddle two chunks need one of them converted first.
@@ -0,0 +1,86 @@
+/*
+Title: Optimizing Collision Detection
+File Name: PrecisionCircles.h
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+A version of ContactListCircles.cpp templated on the type of number it stores, so
+there is a double version for worlds too big for floats.
+*/
+#pragma once
+#include "Settings.h"
+#include "ContactList.h"
+
+// ContactListCircles, but the positions can be floats or doubles.  Floats have 24 bits of
+// precision, so at 10,000,000 units from the origin the closest two floats can be is a
+// whole unit apart, and a circle moving 0.3 a frame doesn't move at all.  Doubles have 53
+// bits, which is still a billionth of a unit out there.  The price is half as many lanes
+// per register, and twice the memory to read.
+template<class Scalar>
+class PrecisionCircles
+{
+public:
+	Scalar* xPosition;
+	Scalar* xVelocity;
+	Scalar* yPosition;
+	Scalar* yVelocity;
+	Scalar* radius;
+
+	int numCircles;
+	int paddedCircles;
+
+	// Every colliding pair, with i < j.
+	ContactList contacts;
+
+	// True to use the AVX kernel, false for SSE.  Starts out as whatever the CPU can do.
+	bool useAVX;
+
+	// The circles are spread over origin to origin + 1000 in both directions.
+	PrecisionCircles(int numCircles = NUM_CIRCLES, Scalar origin = 0);
+	~PrecisionCircles();
+
+	void Update();
+	void CheckForCollisions();
+
+	// Checks contacts against every pair the slow way, in Scalar.  Should be 0.
+	int CountMismatches();
+
+	// Makes these circles a copy of other's, rounded to Scalar.  That way a float world and
+	// a double world can start out as the same circles.
+	template<class Other>
+	void CopyFrom(const PrecisionCircles<Other>& other){
+		for (int i = 0; i < numCircles && i < other.numCircles; ++i){
+			xPosition[i] = (Scalar)other.xPosition[i];
+			yPosition[i] = (Scalar)other.yPosition[i];
+			xVelocity[i] = (Scalar)other.xVelocity[i];
+			yVelocity[i] = (Scalar)other.yVelocity[i];
+			radius[i] = (Scalar)other.radius[i];
+		}
+	}
+
+private:
+	PrecisionCircles(const PrecisionCircles&);
+	PrecisionCircles& operator=(const PrecisionCircles&);
+};
+
+// Built for float and double in PrecisionCircles.cpp.
+extern template class PrecisionCircles<float>;
+extern template class PrecisionCircles<double>;
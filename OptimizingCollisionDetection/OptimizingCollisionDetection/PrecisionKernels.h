@@ -0,0 +1,162 @@
+/*
+Title: Optimizing Collision Detection
+File Name: PrecisionKernels.h
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+Kernels for PrecisionCircles, the ContactListCircles loop written once and built
+for floats and doubles with SSE and AVX.
+*/
+#pragma once
+#include "Settings.h"
+#include "Platform.h"
+#include "ContactList.h"
+
+// The same idea as FixedSizeKernels.h, but the thing being swapped out is the type of
+// number instead of the number of circles.  A double is twice as big as a float, so a
+// register holds half as many of them: 2 in SSE2 instead of 4, 4 in AVX instead of 8.
+// Everything else about the loop is the same, so it's written once, below, and these
+// structs do the math for one register's worth.
+//
+// As with FixedSizeKernels, only the declarations are here.  The bodies are in
+// PrecisionKernels_SSE.cpp and PrecisionKernels_AVX.cpp, each built for its own
+// instruction set.
+
+struct FloatSSE{
+	typedef float Scalar;
+	typedef __m128 Vector;
+	enum { width = 4 };
+
+	static Vector Broadcast(const float* value);
+	static void Add(float* position, const float* velocity);
+
+	// One bit per lane, set where the circles collide, like _mm_movemask_ps.
+	static int TestGroup(Vector xPos, Vector yPos, Vector rad,
+		const float* xPosition, const float* yPosition, const float* radius);
+};
+
+struct DoubleSSE2{
+	typedef double Scalar;
+	typedef __m128d Vector;
+	enum { width = 2 };
+
+	static Vector Broadcast(const double* value);
+	static void Add(double* position, const double* velocity);
+	static int TestGroup(Vector xPos, Vector yPos, Vector rad,
+		const double* xPosition, const double* yPosition, const double* radius);
+};
+
+struct FloatAVX{
+	typedef float Scalar;
+	typedef __m256 Vector;
+	enum { width = 8 };
+
+	static Vector Broadcast(const float* value);
+	static void Add(float* position, const float* velocity);
+	static int TestGroup(Vector xPos, Vector yPos, Vector rad,
+		const float* xPosition, const float* yPosition, const float* radius);
+};
+
+struct DoubleAVX{
+	typedef double Scalar;
+	typedef __m256d Vector;
+	enum { width = 4 };
+
+	static Vector Broadcast(const double* value);
+	static void Add(double* position, const double* velocity);
+	static int TestGroup(Vector xPos, Vector yPos, Vector rad,
+		const double* xPosition, const double* yPosition, const double* radius);
+};
+
+// Which of those goes with which type, so PrecisionCircles<Scalar> can find its kernels.
+template<class Scalar>
+struct PrecisionSimd;
+
+template<>
+struct PrecisionSimd<float>{
+	typedef FloatSSE SSE;
+	typedef FloatAVX AVX;
+};
+
+template<>
+struct PrecisionSimd<double>{
+	typedef DoubleSSE2 SSE;
+	typedef DoubleAVX AVX;
+};
+
+template<class Simd>
+struct PrecisionKernel{
+	typedef typename Simd::Scalar Scalar;
+	typedef typename Simd::Vector Vector;
+
+	static void Update(Scalar* xPosition, Scalar* yPosition, const Scalar* xVelocity, const Scalar* yVelocity, int paddedCircles);
+
+	// The ContactListCircles loop.  The arrays have to be padded to a whole register.
+	static void CheckForCollisions(const Scalar* xPosition, const Scalar* yPosition, const Scalar* radius,
+		int numCircles, int paddedCircles, ContactList& contacts);
+};
+
+template<class Simd>
+void PrecisionKernel<Simd>::Update(Scalar* xPosition, Scalar* yPosition, const Scalar* xVelocity, const Scalar* yVelocity, int paddedCircles){
+	for (int i = 0; i < paddedCircles; i += Simd::width){
+		Simd::Add(xPosition + i, xVelocity + i);
+		Simd::Add(yPosition + i, yVelocity + i);
+	}
+}
+
+template<class Simd>
+void PrecisionKernel<Simd>::CheckForCollisions(const Scalar* xPosition, const Scalar* yPosition, const Scalar* radius,
+	int numCircles, int paddedCircles, ContactList& contacts){
+	const int allLanes = (1 << Simd::width) - 1;
+	contacts.Clear();
+
+	for (int i = 0; i < numCircles; ++i){
+		Vector xPos = Simd::Broadcast(xPosition + i);
+		Vector yPos = Simd::Broadcast(yPosition + i);
+		Vector rad = Simd::Broadcast(radius + i);
+
+		int j = i & ~(Simd::width - 1);
+		int validLanes = (allLanes << ((i & (Simd::width - 1)) + 1)) & allLanes;
+
+		contacts.Reserve(paddedCircles - j + Simd::width);
+		ContactPair* out = contacts.pairs + contacts.count;
+
+		do {
+			int mask = Simd::TestGroup(xPos, yPos, rad, xPosition + j, yPosition + j, radius + j) & validLanes;
+
+			// width is a constant, so the compiler unrolls this into the same straight
+			// line of writes ContactListCircles has.
+			for (int lane = 0; lane < Simd::width; ++lane){
+				out->i = i; out->j = j + lane; out += (mask >> lane) & 1;
+			}
+
+			validLanes = allLanes;
+			j += Simd::width;
+		} while (j < paddedCircles);
+
+		contacts.count = (int)(out - contacts.pairs);
+	}
+}
+
+extern template struct PrecisionKernel<FloatSSE>;
+extern template struct PrecisionKernel<DoubleSSE2>;
+extern template struct PrecisionKernel<FloatAVX>;
+extern template struct PrecisionKernel<DoubleAVX>;
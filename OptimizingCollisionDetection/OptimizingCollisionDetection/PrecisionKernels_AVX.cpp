@@ -0,0 +1,76 @@
+/*
+Title: Optimizing Collision Detection
+File Name: PrecisionKernels_AVX.cpp
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+Kernels for PrecisionCircles, the ContactListCircles loop written once and built
+for floats and doubles with SSE and AVX.
+*/
+
+#include "Platform.h"
+#include "ContactList.h"
+
+// Same deal as FixedSizeKernels_AVX2.cpp.  Plain AVX is enough for these, but the
+// program only asks the CPU about AVX2, so that's what this is built for.  ContactList.h
+// is included first so its inline functions don't get built as AVX2 code in here.
+BEGIN_TARGET_AVX2
+#include "PrecisionKernels.h"
+
+FloatAVX::Vector FloatAVX::Broadcast(const float* value){
+	return _mm256_broadcast_ss(value);
+}
+
+void FloatAVX::Add(float* position, const float* velocity){
+	_mm256_store_ps(position, _mm256_add_ps(_mm256_load_ps(position), _mm256_load_ps(velocity)));
+}
+
+int FloatAVX::TestGroup(Vector xPos, Vector yPos, Vector rad,
+	const float* xPosition, const float* yPosition, const float* radius){
+	Vector xDif = _mm256_sub_ps(_mm256_load_ps(xPosition), xPos);
+	Vector yDif = _mm256_sub_ps(_mm256_load_ps(yPosition), yPos);
+	Vector radiusAdd = _mm256_add_ps(_mm256_load_ps(radius), rad);
+	return _mm256_movemask_ps(_mm256_cmp_ps(
+		_mm256_add_ps(_mm256_mul_ps(xDif, xDif), _mm256_mul_ps(yDif, yDif)),
+		_mm256_mul_ps(radiusAdd, radiusAdd), _CMP_LT_OQ));
+}
+
+DoubleAVX::Vector DoubleAVX::Broadcast(const double* value){
+	return _mm256_broadcast_sd(value);
+}
+
+void DoubleAVX::Add(double* position, const double* velocity){
+	_mm256_store_pd(position, _mm256_add_pd(_mm256_load_pd(position), _mm256_load_pd(velocity)));
+}
+
+int DoubleAVX::TestGroup(Vector xPos, Vector yPos, Vector rad,
+	const double* xPosition, const double* yPosition, const double* radius){
+	Vector xDif = _mm256_sub_pd(_mm256_load_pd(xPosition), xPos);
+	Vector yDif = _mm256_sub_pd(_mm256_load_pd(yPosition), yPos);
+	Vector radiusAdd = _mm256_add_pd(_mm256_load_pd(radius), rad);
+	return _mm256_movemask_pd(_mm256_cmp_pd(
+		_mm256_add_pd(_mm256_mul_pd(xDif, xDif), _mm256_mul_pd(yDif, yDif)),
+		_mm256_mul_pd(radiusAdd, radiusAdd), _CMP_LT_OQ));
+}
+
+template struct PrecisionKernel<FloatAVX>;
+template struct PrecisionKernel<DoubleAVX>;
+END_TARGET
@@ -0,0 +1,69 @@
+/*
+Title: Optimizing Collision Detection
+File Name: PrecisionKernels_SSE.cpp
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+Kernels for PrecisionCircles, the ContactListCircles loop written once and built
+for floats and doubles with SSE and AVX.
+*/
+
+#include "PrecisionKernels.h"
+
+// SSE2 is part of x86-64, so doubles get their 2 lanes everywhere without asking.
+FloatSSE::Vector FloatSSE::Broadcast(const float* value){
+	return _mm_load1_ps(value);
+}
+
+void FloatSSE::Add(float* position, const float* velocity){
+	_mm_store_ps(position, _mm_add_ps(_mm_load_ps(position), _mm_load_ps(velocity)));
+}
+
+int FloatSSE::TestGroup(Vector xPos, Vector yPos, Vector rad,
+	const float* xPosition, const float* yPosition, const float* radius){
+	Vector xDif = _mm_sub_ps(_mm_load_ps(xPosition), xPos);
+	Vector yDif = _mm_sub_ps(_mm_load_ps(yPosition), yPos);
+	Vector radiusAdd = _mm_add_ps(_mm_load_ps(radius), rad);
+	return _mm_movemask_ps(_mm_cmplt_ps(
+		_mm_add_ps(_mm_mul_ps(xDif, xDif), _mm_mul_ps(yDif, yDif)),
+		_mm_mul_ps(radiusAdd, radiusAdd)));
+}
+
+DoubleSSE2::Vector DoubleSSE2::Broadcast(const double* value){
+	return _mm_load1_pd(value);
+}
+
+void DoubleSSE2::Add(double* position, const double* velocity){
+	_mm_store_pd(position, _mm_add_pd(_mm_load_pd(position), _mm_load_pd(velocity)));
+}
+
+int DoubleSSE2::TestGroup(Vector xPos, Vector yPos, Vector rad,
+	const double* xPosition, const double* yPosition, const double* radius){
+	Vector xDif = _mm_sub_pd(_mm_load_pd(xPosition), xPos);
+	Vector yDif = _mm_sub_pd(_mm_load_pd(yPosition), yPos);
+	Vector radiusAdd = _mm_add_pd(_mm_load_pd(radius), rad);
+	return _mm_movemask_pd(_mm_cmplt_pd(
+		_mm_add_pd(_mm_mul_pd(xDif, xDif), _mm_mul_pd(yDif, yDif)),
+		_mm_mul_pd(radiusAdd, radiusAdd)));
+}
+
+template struct PrecisionKernel<FloatSSE>;
+template struct PrecisionKernel<DoubleSSE2>;
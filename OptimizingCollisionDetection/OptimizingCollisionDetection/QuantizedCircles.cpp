@@ -0,0 +1,250 @@
+/*
+Title: Optimizing Collision Detection
+File Name: QuantizedCircles.cpp
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+A version of ContactListCircles.cpp that does the pair test on 16 bit quantized
+positions and radii, and only re-tests the hits in floats.
+*/
+
+#include "QuantizedCircles.h"
+#include "Platform.h"
+#include "HelperFunctions.h"
+#include <cstring>
+
+
+QuantizedCircles::QuantizedCircles(int numCircles)
+{
+	this->numCircles = numCircles;
+	paddedCircles = Helper::PadCircles(numCircles, 8);
+	useAVX2 = Platform::SupportsAVX2();
+
+	xPosition = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	xVelocity = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	yPosition = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	yVelocity = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	radius = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	xyQuantized = (short*)_aligned_malloc(paddedCircles * 2 * sizeof(short), 32);
+	radiusQuantized = (short*)_aligned_malloc(paddedCircles * sizeof(short), 16);
+
+	for (int i = 0; i < numCircles; ++i){
+		xPosition[i] = Helper::RandomFloat(0, 1000.0f);
+		yPosition[i] = Helper::RandomFloat(0, 1000.0f);
+		xVelocity[i] = Helper::RandomFloat(-1.0f, 1.0f);
+		yVelocity[i] = Helper::RandomFloat(-1.0f, 1.0f);
+		radius[i] = Helper::RandomFloat(5.0f, 100.0f);
+	}
+	Helper::FillPadding(xPosition, xVelocity, yPosition, yVelocity, radius, numCircles, paddedCircles);
+
+	candidates = 0;
+	Quantize();
+}
+
+QuantizedCircles::~QuantizedCircles()
+{
+	_aligned_free(xPosition);
+	_aligned_free(yPosition);
+	_aligned_free(xVelocity);
+	_aligned_free(yVelocity);
+	_aligned_free(radius);
+	_aligned_free(xyQuantized);
+	_aligned_free(radiusQuantized);
+}
+
+void QuantizedCircles::Quantize(){
+	// The circles drift forever, so there's no fixed world box to quantize against.
+	// Instead, every frame, find the box they're in now and stretch 0 to 32767 over it.
+	// Differences of two numbers in that range still fit in 16 bits, and
+	// dx * dx + dy * dy is at most 2 * 32767^2, which just barely fits in 32.
+	float minX = xPosition[0], maxX = xPosition[0];
+	float minY = yPosition[0], maxY = yPosition[0];
+	float maxRadius = 0.0f;
+	for (int i = 1; i < numCircles; ++i){
+		minX = xPosition[i] < minX ? xPosition[i] : minX;
+		maxX = xPosition[i] > maxX ? xPosition[i] : maxX;
+		minY = yPosition[i] < minY ? yPosition[i] : minY;
+		maxY = yPosition[i] > maxY ? yPosition[i] : maxY;
+	}
+	for (int i = 0; i < numCircles; ++i){
+		maxRadius = radius[i] > maxRadius ? radius[i] : maxRadius;
+	}
+
+	float extent = maxX - minX > maxY - minY ? maxX - minX : maxY - minY;
+	xOrigin = minX;
+	yOrigin = minY;
+
+	// Two radii get added together in 16 bits too, so each has to stay under 16384.
+	// Leave room for the extra steps added below.
+	scale = extent > 0.0f ? 32767.0f / extent : 1.0f;
+	if (maxRadius * scale > 16000.0f){
+		scale = 16000.0f / maxRadius;
+	}
+
+	// _mm_cvtps_epi32 rounds to nearest, so each coordinate is off by at most half a step,
+	// and each of dx and dy by at most one.  That's at most sqrt(2) steps of distance.
+	// Rounding each radius up and adding one more step covers that with room to spare,
+	// which is what makes the integer test conservative: it can say yes to a pair that
+	// isn't touching, but never no to one that is.
+	__m128 xBase = _mm_set1_ps(xOrigin);
+	__m128 yBase = _mm_set1_ps(yOrigin);
+	__m128 scaleBy = _mm_set1_ps(scale);
+	for (int i = 0; i < paddedCircles; i += 4){
+		__m128i qx = _mm_cvtps_epi32(_mm_mul_ps(_mm_sub_ps(_mm_load_ps(xPosition + i), xBase), scaleBy));
+		__m128i qy = _mm_cvtps_epi32(_mm_mul_ps(_mm_sub_ps(_mm_load_ps(yPosition + i), yBase), scaleBy));
+		_mm_store_si128((__m128i*)(xyQuantized + 2 * i), _mm_unpacklo_epi16(_mm_packs_epi32(qx, qx), _mm_packs_epi32(qy, qy)));
+	}
+	for (int i = 0; i < paddedCircles; ++i){
+		radiusQuantized[i] = (short)((int)(radius[i] * scale) + 2);
+	}
+
+	// The padding circles are at 1e18, which comes out as garbage here.  They can turn up
+	// as candidates, but the float test knows exactly where they are and throws them out.
+}
+
+void QuantizedCircles::Update(){
+	for (int i = 0; i < paddedCircles; i += 4){
+		_mm_store_ps(xPosition + i, _mm_add_ps(_mm_load_ps(xPosition + i), _mm_load_ps(xVelocity + i)));
+		_mm_store_ps(yPosition + i, _mm_add_ps(_mm_load_ps(yPosition + i), _mm_load_ps(yVelocity + i)));
+	}
+
+	Quantize();
+}
+
+void QuantizedCircles::CheckForCollisions(){
+	contacts.Clear();
+	candidates = 0;
+
+	if (useAVX2){
+		CheckAVX2();
+	}
+	else{
+		CheckSSE();
+	}
+}
+
+void QuantizedCircles::TestCandidates(int i, int j, int mask){
+	// A hit gets the exact float test, so what ends up in the list is exactly what the
+	// float kernels would say.
+	while (mask){
+		int k = j + Platform::LowestBit(mask);
+		mask &= mask - 1;
+		++candidates;
+
+		float xDif = xPosition[i] - xPosition[k];
+		float yDif = yPosition[i] - yPosition[k];
+		float radiusSum = radius[i] + radius[k];
+		if (xDif * xDif + yDif * yDif < radiusSum * radiusSum){
+			contacts.Reserve(1);
+			contacts.pairs[contacts.count].i = i;
+			contacts.pairs[contacts.count].j = k;
+			++contacts.count;
+		}
+	}
+}
+
+void QuantizedCircles::CheckSSE(){
+	// Per group of 4 circles the float kernel loads 48 bytes: x, y and radius, 16 bytes
+	// each.  This one loads 16 bytes of x and y together and 8 bytes of radius, so half.
+	// And where the float kernel does 2 subtracts, 3 multiplies and 2 adds, this does one
+	// subtract on all 8 shorts at once and one _mm_madd_epi16, which multiplies all 8
+	// and adds each x and y pair together into a 32 bit dx * dx + dy * dy.
+	//
+	// That's still only 4 pairs per madd though, the same as the float kernel does per
+	// compare, so the win is all in the loads.  CheckAVX2 is where the lanes pay off.
+	const __m128i zero = _mm_setzero_si128();
+
+	for (int i = 0; i < numCircles; ++i){
+		// One x and y as a single 32 bit number copies both into every pair of lanes.  The
+		// radius goes in the bottom half of each 32 bits with 0 on top, so the same madd
+		// trick squares the radius sum: (ri + rj) * (ri + rj) + 0 * 0.
+		int xy;
+		memcpy(&xy, xyQuantized + 2 * i, sizeof(int));
+		__m128i xyI = _mm_set1_epi32(xy);
+		__m128i radI = _mm_set1_epi32((unsigned short)radiusQuantized[i]);
+
+		int j = i & ~3;
+		int validLanes = (0xF << ((i & 3) + 1)) & 0xF;
+
+		do {
+			__m128i dif = _mm_sub_epi16(xyI, _mm_load_si128((const __m128i*)(xyQuantized + 2 * j)));
+			__m128i distanceSquared = _mm_madd_epi16(dif, dif);
+
+			__m128i radiusAdd = _mm_add_epi16(radI,
+				_mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)(radiusQuantized + j)), zero));
+			__m128i radiusSquared = _mm_madd_epi16(radiusAdd, radiusAdd);
+
+			int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(radiusSquared, distanceSquared))) & validLanes;
+
+			// Almost every group is all misses, and that's one well predicted branch.
+			if (mask){
+				TestCandidates(i, j, mask);
+			}
+
+			validLanes = 0xF;
+			j += 4;
+		} while (j < paddedCircles);
+	}
+}
+
+// TARGET_AVX2 (see Platform.h) lets GCC and Clang use AVX2 in just this function.
+TARGET_AVX2 void QuantizedCircles::CheckAVX2(){
+	// The same loop as CheckSSE, 8 circles at a time.  A 256 bit register holds 16 shorts,
+	// which is x and y for 8 circles, so one _mm256_madd_epi16 gives 8 distances where the
+	// float AVX kernel needs 2 multiplies and an add for the same 8.  The radii come in as
+	// 8 shorts and get zero extended to 32 bits in one go.
+	for (int i = 0; i < numCircles; ++i){
+		int xy;
+		memcpy(&xy, xyQuantized + 2 * i, sizeof(int));
+		__m256i xyI = _mm256_set1_epi32(xy);
+		__m256i radI = _mm256_set1_epi32((unsigned short)radiusQuantized[i]);
+
+		int j = i & ~7;
+		int validLanes = (0xFF << ((i & 7) + 1)) & 0xFF;
+
+		do {
+			__m256i dif = _mm256_sub_epi16(xyI, _mm256_load_si256((const __m256i*)(xyQuantized + 2 * j)));
+			__m256i distanceSquared = _mm256_madd_epi16(dif, dif);
+
+			__m256i radiusAdd = _mm256_add_epi16(radI,
+				_mm256_cvtepu16_epi32(_mm_load_si128((const __m128i*)(radiusQuantized + j))));
+			__m256i radiusSquared = _mm256_madd_epi16(radiusAdd, radiusAdd);
+
+			int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(radiusSquared, distanceSquared))) & validLanes;
+			if (mask){
+				TestCandidates(i, j, mask);
+			}
+
+			validLanes = 0xFF;
+			j += 8;
+		} while (j < paddedCircles);
+	}
+}
+
+int QuantizedCircles::CountMismatches(){
+	return CountContactMismatches(contacts, xPosition, yPosition, radius, numCircles);
+}
+
+// The step size is the size of the box divided by 32767.  For the 1000 wide world that's
+// about 0.03, and the extra steps on the radii only let through pairs a tenth of a unit
+// apart, so nearly every candidate is a real contact.  As the circles spread out the steps
+// get bigger and more near misses get through, but it never misses a real one, it just
+// does more float tests.
@@ -0,0 +1,90 @@
+/*
+Title: Optimizing Collision Detection
+File Name: QuantizedCircles.h
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+A version of ContactListCircles.cpp that does the pair test on 16 bit quantized
+positions and radii, and only re-tests the hits in floats.
+*/
+#pragma once
+#include "Settings.h"
+#include "ContactList.h"
+
+class QuantizedCircles
+{
+public:
+	// The float arrays are still the real circles.  Update moves these, and they're what
+	// the exact test at the end reads.
+	int numCircles;
+	int paddedCircles;
+
+	float* xPosition;
+	float* xVelocity;
+	float* yPosition;
+	float* yVelocity;
+	float* radius;
+
+	// The same circles squeezed into 16 bit integers for the pair test.  x and y sit next
+	// to each other, x0 y0 x1 y1..., because that's the shape _mm_madd_epi16 wants.
+	// Padded to a multiple of 8 circles so the AVX2 kernel can load a whole register.
+	// Both are measured from (xOrigin, yOrigin) in steps of 1 / scale.
+	short* xyQuantized;
+	short* radiusQuantized;
+	float xOrigin;
+	float yOrigin;
+	float scale;
+
+	// Every pair that really collides, with i < j like ContactListCircles.
+	ContactList contacts;
+
+	// How many pairs the integer test let through last frame.  Everything past
+	// contacts.count was a near miss the float test threw back.
+	int candidates;
+
+	// True to use the AVX2 kernel, which does 8 pairs per _mm256_madd_epi16 instead of 4.
+	// Starts out as whatever the CPU can do.
+	bool useAVX2;
+
+	QuantizedCircles(int numCircles = NUM_CIRCLES);
+	~QuantizedCircles();
+
+	// Moves the float circles, then re-quantizes them.
+	void Update();
+	void CheckForCollisions();
+
+	// Checks contacts against every pair the slow way.  Should be 0.
+	int CountMismatches();
+
+	// Works out the origin and scale for where the circles are now and fills in the
+	// 16 bit arrays.  Update calls it, so this is only needed after moving circles by hand.
+	void Quantize();
+
+private:
+	void CheckSSE();
+	void CheckAVX2();
+
+	// The exact float test for the lanes set in mask, starting at circle j.
+	void TestCandidates(int i, int j, int mask);
+
+	QuantizedCircles(const QuantizedCircles&);
+	QuantizedCircles& operator=(const QuantizedCircles&);
+};
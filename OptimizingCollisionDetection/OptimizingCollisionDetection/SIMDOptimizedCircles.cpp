@@ -29,51 +29,77 @@ https://msdn.microsoft.com/en-us/library/t467de55(v=vs.90).aspx
 */
 
 #include "SIMDOptimizedCircles.h"
-#include <intrin.h> //SIMD ops are within <intrin.h>
+#include "Platform.h" //SIMD ops are within <intrin.h>, which Platform.h includes
 #include "HelperFunctions.h"
 
 
-SIMDOptimizedCircles::SIMDOptimizedCircles()
+SIMDOptimizedCircles::SIMDOptimizedCircles(int numCircles, Arena* arena)
 {
 	// So first thing's first.  All of the operations we're going to be using require
 	// 16 bit alignment from our data.
 
 	// Okay yes we COULD use the unaligned calls, but if you're doing that what's
 	// the point of using SIMD in the first place.
-	boolTest = (float*)_aligned_malloc(4 * sizeof(float), 16);
-	xPosition = (float*)_aligned_malloc(NUM_CIRCLES * sizeof(float), 16);
-	xVelocity = (float*)_aligned_malloc(NUM_CIRCLES * sizeof(float), 16);
-	yPosition = (float*)_aligned_malloc(NUM_CIRCLES * sizeof(float), 16);
-	yVelocity = (float*)_aligned_malloc(NUM_CIRCLES * sizeof(float), 16);
-	radius = (float*)_aligned_malloc(NUM_CIRCLES * sizeof(float), 16);
-
-	for (int i = 0; i < NUM_CIRCLES; ++i){
+	//
+	// The number of circles doesn't have to be a multiple of 4 either.  We round the
+	// arrays up to one, and park the extra circles so far away they can't hit anything.
+	// Then the last group of 4 is just a normal group of 4, and their lanes always come
+	// out false, so there's no leftover loop to write.
+	this->numCircles = numCircles;
+	paddedCircles = Helper::PadCircles(numCircles, 4);
+
+	// This used to be a separate _aligned_malloc for every array and every row, with the
+	// rows wherever the heap felt like putting them.  Now it's one block.  Every piece
+	// starts on a cache line, which is more than the 16 we need, and the rows all sit one
+	// after another, so walking down isCollided walks memory in order.  If someone hands
+	// us an arena that's too small, we'd rather hear about it now than halfway through.
+	ownArena = 0;
+	if (!arena){
+		arena = ownArena = new Arena(MemoryNeeded(numCircles));
+	}
+	arena->Require(MemoryNeeded(numCircles), "SIMDOptimizedCircles");
+
+	boolTest = arena->Allocate<float>(4);
+	xPosition = arena->Allocate<float>(paddedCircles);
+	xVelocity = arena->Allocate<float>(paddedCircles);
+	yPosition = arena->Allocate<float>(paddedCircles);
+	yVelocity = arena->Allocate<float>(paddedCircles);
+	radius = arena->Allocate<float>(paddedCircles);
+	isCollided = arena->Allocate<float*>(numCircles);
+
+	for (int i = 0; i < numCircles; ++i){
 		xPosition[i] = Helper::RandomFloat(0, 1000.0f);
 		yPosition[i] = Helper::RandomFloat(0, 1000.0f);
 		xVelocity[i] = Helper::RandomFloat(-1.0f, 1.0f);
 		yVelocity[i] = Helper::RandomFloat(-1.0f, 1.0f);
 		radius[i] = Helper::RandomFloat(5.0f, 100.0f);
 
-		isCollided[i] = (float*)_aligned_malloc(sizeof(float) * NUM_CIRCLES, 32);
-		memset(isCollided[i], 0, sizeof(float) * NUM_CIRCLES);
+		isCollided[i] = arena->Allocate<float>(paddedCircles);
+		memset(isCollided[i], 0, sizeof(float) * paddedCircles);
 	}
+	Helper::FillPadding(xPosition, xVelocity, yPosition, yVelocity, radius, numCircles, paddedCircles);
 
-	int b = 0;
+	// One block for the whole bit matrix.  It's small enough now that there's no reason
+	// to split it up into rows.
+	wordsPerRow = CollisionBits::WordsPerRow(numCircles);
+	collisionBits = arena->Allocate<unsigned int>(wordsPerRow * numCircles);
+	memset(collisionBits, 0, sizeof(unsigned int) * wordsPerRow * numCircles);
 }
 
 SIMDOptimizedCircles::~SIMDOptimizedCircles()
 {
-	// Aligned malloc requires aligned free.
-	_aligned_free(boolTest);
-	_aligned_free(xPosition);
-	_aligned_free(yPosition);
-	_aligned_free(xVelocity);
-	_aligned_free(yVelocity);
-	_aligned_free(radius);
-
-	for (int i = 0; i < NUM_CIRCLES; ++i){
-		_aligned_free(isCollided[i]);
-	}
+	// Everything came out of the arena, so there's nothing to free one at a time.  If the
+	// arena was handed to us it isn't ours to free either.
+	delete ownArena;
+}
+
+size_t SIMDOptimizedCircles::MemoryNeeded(int numCircles){
+	int paddedCircles = Helper::PadCircles(numCircles, 4);
+	return Arena::Footprint(4 * sizeof(float))
+		+ 5 * Arena::Footprint(paddedCircles * sizeof(float))
+		+ Arena::Footprint(numCircles * sizeof(float*))
+		+ numCircles * Arena::Footprint(paddedCircles * sizeof(float))
+		+ Arena::Footprint(CollisionBits::WordsPerRow(numCircles) * numCircles * sizeof(unsigned int));
 }
 
 void SIMDOptimizedCircles::Update(){
@@ -81,7 +107,7 @@ void SIMDOptimizedCircles::Update(){
 	// Alright, our first look at SIMD code.  It looks pretty bad but let's
 	// talk about what it's actually doing.
 
-	for (int i = 0; i < NUM_CIRCLES; i += 4){ //Notice that we're doing 4 at a time.
+	for (int i = 0; i < paddedCircles; i += 4){ //Notice that we're doing 4 at a time.
 
 		// The following code is xPosition += xVelocity
 
@@ -117,7 +143,7 @@ void SIMDOptimizedCircles::Update(){
 
 void SIMDOptimizedCircles::CheckForCollisions(){
 	// Now for the fun one.
-	for (int i = 0; i < NUM_CIRCLES; ++i){
+	for (int i = 0; i < numCircles; ++i){
 
 		// We're going to test the collisions of four circles against one circle at a time.
 
@@ -131,10 +157,12 @@ void SIMDOptimizedCircles::CheckForCollisions(){
 		// Remember how we were starting the inner loop from one above?  Since we're going four at
 		// a time we'll have to overlap a little.  That doesn't mean we have to do all of them now
 		// though.
-		int j = i & 0xFC;
+		int j = i & ~3;
 		// I'm cutting off the last two bits so that the do while loop can still go up
 		// against  4 i's at the same time, but every 4 i's j actually goes up by 4.
 		// so 0 -> 0, 1-> 0, 2-> 0, 3-> 0, 4 -> 4, 5-> 4, and so on.
+		// (This used to be i & 0xFC, which only cuts the bits off the low byte.  Past
+		// i = 255 it sent j right back to near the start of the row.)
 
 		do {
 			// This is x1 -x2... FOUR TIMES AT ONCE!  SIMD is pretty cool like that.
@@ -164,10 +192,101 @@ void SIMDOptimizedCircles::CheckForCollisions(){
 
 
 			j += 4;// Then grab the next four to compare with.
-		} while (j < NUM_CIRCLES);
+		} while (j < paddedCircles);
+	}
+}
+
+void SIMDOptimizedCircles::CheckForCollisionsPacked(){
+	// Here's something worth noticing about CheckForCollisions.  For every 4 pairs we do
+	// 3 loads, a handful of math, and then store 16 bytes.  At 1000 circles that's 4MB
+	// of results every frame for what's really a yes or no answer.  The math is cheap,
+	// so after a while we're really just waiting on memory to take all those stores.
+	//
+	// So instead we keep one bit per pair.  _mm_movemask_ps takes the top bit of each of
+	// the 4 floats in a register and packs them into the bottom 4 bits of an int, and
+	// the top bit of a compare result is exactly the answer we want.
+	for (int i = 0; i < numCircles; ++i){
+		__m128 xPos = _mm_load1_ps(xPosition + i);
+		__m128 yPos = _mm_load1_ps(yPosition + i);
+		__m128 rad = _mm_load1_ps(radius + i);
+
+		unsigned int* row = collisionBits + i * wordsPerRow;
+
+		// Same trick as before, but now we round j down to a multiple of 32 so every
+		// word we write is a whole word.
+		int j = i & ~31;
+
+		do {
+			// Build up a whole word in a register, 4 bits at a time, and store it once.
+			int word = j >> 5;
+			unsigned int bits = 0;
+			for (int shift = 0; shift < 32 && j < paddedCircles; shift += 4, j += 4){
+				__m128 xDif = _mm_sub_ps(xPos, _mm_load_ps(xPosition + j));
+				__m128 yDif = _mm_sub_ps(yPos, _mm_load_ps(yPosition + j));
+				__m128 radiusAdd = _mm_add_ps(rad, _mm_load_ps(radius + j));
+
+				int mask = _mm_movemask_ps(
+					_mm_cmplt_ps(
+						_mm_add_ps(_mm_mul_ps(xDif, xDif), _mm_mul_ps(yDif, yDif)),
+						_mm_mul_ps(radiusAdd, radiusAdd)));
+
+				bits |= (unsigned int)mask << shift;
+			}
+
+			row[word] = bits;
+		} while (j < paddedCircles);
 	}
 }
 
+void SIMDOptimizedCircles::UpdateAndCheckForCollisions(){
+	// main.cpp always calls Update() and then CheckForCollisions(), which means two trips
+	// through the positions.  One to move them, and one to test them.  But we don't need
+	// every circle moved before we can test anything, only the ones a row looks at.
+	//
+	// Row i only ever looks at j >= i rounded down to 4.  So go through the rows backwards,
+	// a group of 4 at a time.  Everything to the right of the group has already moved this
+	// frame.  Move the group itself, and its rows can be tested straight away, while the
+	// positions we just wrote are still sitting in L1.  Same math in the same order on
+	// the same numbers, so isCollided comes out exactly the same as the two passes.
+	for (int group = paddedCircles - 4; group >= 0; group -= 4){
+		_mm_store_ps(xPosition + group, _mm_add_ps(_mm_load_ps(xPosition + group), _mm_load_ps(xVelocity + group)));
+		_mm_store_ps(yPosition + group, _mm_add_ps(_mm_load_ps(yPosition + group), _mm_load_ps(yVelocity + group)));
+
+		int lastRow = group + 3 < numCircles ? group + 3 : numCircles - 1;
+		for (int i = lastRow; i >= group; --i){
+			__m128 xPos = _mm_load1_ps(xPosition + i);
+			__m128 yPos = _mm_load1_ps(yPosition + i);
+			__m128 rad = _mm_load1_ps(radius + i);
+
+			for (int j = group; j < paddedCircles; j += 4){
+				__m128 xDif = _mm_sub_ps(xPos, _mm_load_ps(xPosition + j));
+				__m128 yDif = _mm_sub_ps(yPos, _mm_load_ps(yPosition + j));
+				__m128 radiusAdd = _mm_add_ps(rad, _mm_load_ps(radius + j));
+
+				_mm_store_ps(isCollided[i] + j, _mm_cmplt_ps(
+					_mm_add_ps(_mm_mul_ps(xDif, xDif), _mm_mul_ps(yDif, yDif)),
+					_mm_mul_ps(radiusAdd, radiusAdd)));
+			}
+		}
+	}
+}
+
+int SIMDOptimizedCircles::CountMismatches(){
+	int mismatches = 0;
+
+	for (int i = 0; i < numCircles; ++i){
+		for (int j = i + 1; j < numCircles; ++j){
+			bool expected = (xPosition[i] - xPosition[j]) * (xPosition[i] - xPosition[j])
+				+ (yPosition[i] - yPosition[j]) * (yPosition[i] - yPosition[j])
+				< (radius[i] + radius[j]) * (radius[i] + radius[j]);
+			mismatches += expected != (isCollided[i][j] != 0.0f);
+			mismatches += expected != CollisionBits::Get(collisionBits, wordsPerRow, i, j);
+		}
+	}
+
+	return mismatches;
+}
+
 // See.
 // 
 // That wasn't so bad.
@@ -26,12 +26,17 @@ Optimizing circle collisions with SIMD code.
 */
 #pragma once
 #include "Settings.h"
+#include "Arena.h"
+#include "CollisionBits.h"
 
 class SIMDOptimizedCircles
 {
 private:
 	float* boolTest;
 
+	// The arena this made for itself, or 0 if it was handed one.
+	Arena* ownArena;
+
 public:
 	float* xPosition;
 	float* xVelocity;
@@ -39,14 +44,35 @@ public:
 	float* yVelocity;
 	float* radius;
 
-	
+	// How many circles there really are, and how many the arrays have room for.  The
+	// extra ones at the end only exist so every group of 4 is a whole group of 4.
+	int numCircles;
+	int paddedCircles;
+
+	float** isCollided;
 
-	float* isCollided[NUM_CIRCLES];
+	// The same results, but one bit per pair instead of one float.  See CollisionBits.h
+	// for how it's laid out and how to read it.
+	unsigned int* collisionBits;
+	int wordsPerRow;
 
-	SIMDOptimizedCircles();
+	// Everything is carved out of one Arena.  Pass one in to share it, or to Reset() it
+	// and build the next world in the same memory.  Leave it out and this makes its own.
+	SIMDOptimizedCircles(int numCircles = NUM_CIRCLES, Arena* arena = 0);
 	~SIMDOptimizedCircles();
 
+	// How big an Arena has to be to hold one of these.
+	static size_t MemoryNeeded(int numCircles);
+
 	void Update();
 	void CheckForCollisions();
+	void CheckForCollisionsPacked();
+
+	// Update() and CheckForCollisions() in one pass.  Fills isCollided, not collisionBits.
+	void UpdateAndCheckForCollisions();
+
+	// Checks isCollided and collisionBits against the plain C++ test and returns how many
+	// pairs (j > i) either one gets wrong.  Should always be 0.
+	int CountMismatches();
 };
 
@@ -1,3 +1,30 @@
 #pragma once
 #define NUM_CIRCLES 1000
-#define ITERATIONS 1000
\ No newline at end of file
+#define ITERATIONS 1000
+#define SWEEP_ITERATIONS 100
+
+#define AABB_MARGIN 5.0f
+
+// A cache line is 64 bytes on pretty much every x86 chip out there.
+#define CACHE_LINE_SIZE 64
+
+// How many circles on a side of one tile of the pair matrix.  Keep it a multiple of 4.
+#define TILE_SIZE 64
+
+// The cache blocked kernel tests a block of i's against a block of j's small enough to
+// stay in L1.  A j costs 12 bytes (x, y and radius), so 1024 of them is 12KB, which
+// leaves room in a 32KB L1 for everything else.
+#define TILE_ROWS 256
+#define TILE_COLUMNS 1024
+
+// How much further than touching a pair can be and still go on a neighbor list.
+#define NEIGHBOR_SKIN 40.0f
+
+// A circle slower than this for SLEEP_FRAMES frames in a row goes to sleep.
+#define SLEEP_SPEED 0.05f
+#define SLEEP_FRAMES 30
+
+// The autotuner runs each candidate for batches of at least this many seconds, and keeps
+// the winner in this file so the next run doesn't have to.
+#define AUTOTUNE_SECONDS 0.01
+#define AUTOTUNE_CACHE_FILE "autotune.cache"
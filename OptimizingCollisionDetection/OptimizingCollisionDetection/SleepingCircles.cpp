@@ -0,0 +1,300 @@
+/*
+Title: Optimizing Collision Detection
+File Name: SleepingCircles.cpp
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+A version of ContactListCircles.cpp that lets circles at rest fall asleep, and keeps
+circles that never move apart, so pairs where nothing moved are never tested.
+*/
+
+#include "SleepingCircles.h"
+#include "Platform.h"
+#include "HelperFunctions.h"
+#include <cstdlib>
+#include <cstring>
+
+SleepingCircles::SleepingCircles(int numCircles, float restingFraction, float staticFraction)
+{
+	numStatic = (int)(numCircles * staticFraction);
+	numDynamic = numCircles - numStatic;
+	paddedDynamic = Helper::PadCircles(numDynamic, 4);
+	paddedStatic = Helper::PadCircles(numStatic, 4);
+	numAwake = numDynamic;
+	allowSleep = true;
+
+	xPosition = (float*)_aligned_malloc(paddedDynamic * sizeof(float), 16);
+	xVelocity = (float*)_aligned_malloc(paddedDynamic * sizeof(float), 16);
+	yPosition = (float*)_aligned_malloc(paddedDynamic * sizeof(float), 16);
+	yVelocity = (float*)_aligned_malloc(paddedDynamic * sizeof(float), 16);
+	radius = (float*)_aligned_malloc(paddedDynamic * sizeof(float), 16);
+	id = (int*)malloc(paddedDynamic * sizeof(int));
+	slowFrames = (int*)malloc(paddedDynamic * sizeof(int));
+	slotOf = (int*)malloc(paddedDynamic * sizeof(int));
+	wakeList = (int*)malloc(paddedDynamic * sizeof(int));
+	numWakes = 0;
+
+	int numResting = (int)(numDynamic * restingFraction);
+	for (int i = 0; i < numDynamic; ++i){
+		xPosition[i] = Helper::RandomFloat(0, 1000.0f);
+		yPosition[i] = Helper::RandomFloat(0, 1000.0f);
+		xVelocity[i] = i < numResting ? 0.0f : Helper::RandomFloat(-1.0f, 1.0f);
+		yVelocity[i] = i < numResting ? 0.0f : Helper::RandomFloat(-1.0f, 1.0f);
+		radius[i] = Helper::RandomFloat(5.0f, 100.0f);
+		id[i] = i;
+		slotOf[i] = i;
+		slowFrames[i] = 0;
+	}
+	Helper::FillPadding(xPosition, xVelocity, yPosition, yVelocity, radius, numDynamic, paddedDynamic);
+	for (int i = numDynamic; i < paddedDynamic; ++i){
+		id[i] = -1;
+	}
+
+	// The static circles get the same padding trick, just without velocities to fill.
+	xStatic = (float*)_aligned_malloc((paddedStatic ? paddedStatic : 4) * sizeof(float), 16);
+	yStatic = (float*)_aligned_malloc((paddedStatic ? paddedStatic : 4) * sizeof(float), 16);
+	radiusStatic = (float*)_aligned_malloc((paddedStatic ? paddedStatic : 4) * sizeof(float), 16);
+	for (int i = 0; i < paddedStatic; ++i){
+		bool real = i < numStatic;
+		xStatic[i] = real ? Helper::RandomFloat(0, 1000.0f) : Helper::paddingPosition;
+		yStatic[i] = real ? Helper::RandomFloat(0, 1000.0f) : Helper::paddingPosition;
+		radiusStatic[i] = real ? Helper::RandomFloat(5.0f, 100.0f) : 0.0f;
+	}
+}
+
+SleepingCircles::~SleepingCircles()
+{
+	_aligned_free(xPosition);
+	_aligned_free(yPosition);
+	_aligned_free(xVelocity);
+	_aligned_free(yVelocity);
+	_aligned_free(radius);
+	_aligned_free(xStatic);
+	_aligned_free(yStatic);
+	_aligned_free(radiusStatic);
+	free(id);
+	free(slowFrames);
+	free(slotOf);
+	free(wakeList);
+}
+
+void SleepingCircles::CopyFrom(const SleepingCircles& source){
+	numAwake = source.numAwake;
+	Helper::CopyCircles(xPosition, xVelocity, yPosition, yVelocity, radius,
+		source.xPosition, source.xVelocity, source.yPosition, source.yVelocity, source.radius, paddedDynamic);
+	memcpy(id, source.id, paddedDynamic * sizeof(int));
+	memcpy(slowFrames, source.slowFrames, paddedDynamic * sizeof(int));
+	memcpy(slotOf, source.slotOf, paddedDynamic * sizeof(int));
+
+	numWakes = source.numWakes;
+	memcpy(wakeList, source.wakeList, numWakes * sizeof(int));
+
+	memcpy(xStatic, source.xStatic, paddedStatic * sizeof(float));
+	memcpy(yStatic, source.yStatic, paddedStatic * sizeof(float));
+	memcpy(radiusStatic, source.radiusStatic, paddedStatic * sizeof(float));
+}
+
+void SleepingCircles::Swap(int a, int b){
+	float swapFloat;
+	int swapInt;
+	swapFloat = xPosition[a]; xPosition[a] = xPosition[b]; xPosition[b] = swapFloat;
+	swapFloat = yPosition[a]; yPosition[a] = yPosition[b]; yPosition[b] = swapFloat;
+	swapFloat = xVelocity[a]; xVelocity[a] = xVelocity[b]; xVelocity[b] = swapFloat;
+	swapFloat = yVelocity[a]; yVelocity[a] = yVelocity[b]; yVelocity[b] = swapFloat;
+	swapFloat = radius[a]; radius[a] = radius[b]; radius[b] = swapFloat;
+	swapInt = slowFrames[a]; slowFrames[a] = slowFrames[b]; slowFrames[b] = swapInt;
+	swapInt = id[a]; id[a] = id[b]; id[b] = swapInt;
+	slotOf[id[a]] = a;
+	slotOf[id[b]] = b;
+}
+
+void SleepingCircles::Wake(int slot){
+	// Swap it with the first sleeping circle, and move the line up one.
+	if (slot >= numAwake){
+		Swap(slot, numAwake);
+		slowFrames[numAwake] = 0;
+		++numAwake;
+	}
+}
+
+void SleepingCircles::Update(){
+	// Anything that got hit last frame wakes up first, so it's awake for this frame's test.
+	for (int w = 0; w < numWakes; ++w){
+		Wake(slotOf[wakeList[w]]);
+	}
+	numWakes = 0;
+
+	// Sleeping circles don't move, so they're not here at all.  The awake ones are all at
+	// the front, so this is just a shorter loop.  The last group can run into the first
+	// few sleeping circles, but their velocities are 0, so adding them does nothing.
+	for (int i = 0; i < numAwake; i += 4){
+		_mm_store_ps(xPosition + i, _mm_add_ps(_mm_load_ps(xPosition + i), _mm_load_ps(xVelocity + i)));
+		_mm_store_ps(yPosition + i, _mm_add_ps(_mm_load_ps(yPosition + i), _mm_load_ps(yVelocity + i)));
+	}
+
+	if (!allowSleep){
+		return;
+	}
+
+	// Anything that's been slow for SLEEP_FRAMES in a row goes to sleep.  Stop it dead,
+	// and swap it to just behind the line.  Going backwards means whatever gets swapped
+	// into slot i has already been looked at.
+	float sleepSpeed = SLEEP_SPEED * SLEEP_SPEED;
+	for (int i = numAwake - 1; i >= 0; --i){
+		bool slow = xVelocity[i] * xVelocity[i] + yVelocity[i] * yVelocity[i] < sleepSpeed;
+		slowFrames[i] = slow ? slowFrames[i] + 1 : 0;
+		if (slowFrames[i] >= SLEEP_FRAMES){
+			xVelocity[i] = 0.0f;
+			yVelocity[i] = 0.0f;
+			--numAwake;
+			Swap(i, numAwake);
+		}
+	}
+}
+
+void SleepingCircles::CheckForCollisions(){
+	// Three kinds of pairs are worth testing:
+	//   awake against awake, awake against sleeping, and awake against static.
+	// And three aren't:
+	//   sleeping against sleeping, sleeping against static, and static against static.
+	// None of the second lot have moved, so nothing about them can have changed.
+	//
+	// With the awake circles at the front, the first three are easy.  Rows only go up to
+	// numAwake, and each row runs on to the end of all the dynamic circles, so it picks
+	// up the sleeping ones on the way.  Then each awake row runs once over the static
+	// ones.  The whole bottom right of the triangle, where the sleepers are, is just
+	// never visited.  That's skipping in bulk: not a test per pair, not even a test per
+	// row, just a shorter loop.
+	contacts.Clear();
+
+	for (int i = 0; i < numAwake; ++i){
+		__m128 xPos = _mm_load1_ps(xPosition + i);
+		__m128 yPos = _mm_load1_ps(yPosition + i);
+		__m128 rad = _mm_load1_ps(radius + i);
+		int self = id[i];
+
+		int j = i & ~3;
+		int validLanes = (0xF << ((i & 3) + 1)) & 0xF;
+
+		contacts.Reserve(paddedDynamic - j + paddedStatic + 8);
+		ContactPair* out = contacts.pairs + contacts.count;
+
+		for (; j < paddedDynamic; j += 4){
+			__m128 xDif = _mm_sub_ps(xPos, _mm_load_ps(xPosition + j));
+			__m128 yDif = _mm_sub_ps(yPos, _mm_load_ps(yPosition + j));
+			__m128 radiusAdd = _mm_add_ps(rad, _mm_load_ps(radius + j));
+
+			int mask = _mm_movemask_ps(
+				_mm_cmplt_ps(
+					_mm_add_ps(_mm_mul_ps(xDif, xDif), _mm_mul_ps(yDif, yDif)),
+					_mm_mul_ps(radiusAdd, radiusAdd))) & validLanes;
+
+			out->i = self; out->j = id[j];     out += mask & 1;
+			out->i = self; out->j = id[j + 1]; out += (mask >> 1) & 1;
+			out->i = self; out->j = id[j + 2]; out += (mask >> 2) & 1;
+			out->i = self; out->j = id[j + 3]; out += (mask >> 3) & 1;
+
+			validLanes = 0xF;
+		}
+
+		for (j = 0; j < paddedStatic; j += 4){
+			__m128 xDif = _mm_sub_ps(xPos, _mm_load_ps(xStatic + j));
+			__m128 yDif = _mm_sub_ps(yPos, _mm_load_ps(yStatic + j));
+			__m128 radiusAdd = _mm_add_ps(rad, _mm_load_ps(radiusStatic + j));
+
+			int mask = _mm_movemask_ps(
+				_mm_cmplt_ps(
+					_mm_add_ps(_mm_mul_ps(xDif, xDif), _mm_mul_ps(yDif, yDif)),
+					_mm_mul_ps(radiusAdd, radiusAdd)));
+
+			out->i = self; out->j = numDynamic + j;     out += mask & 1;
+			out->i = self; out->j = numDynamic + j + 1; out += (mask >> 1) & 1;
+			out->i = self; out->j = numDynamic + j + 2; out += (mask >> 2) & 1;
+			out->i = self; out->j = numDynamic + j + 3; out += (mask >> 3) & 1;
+		}
+
+		contacts.count = (int)(out - contacts.pairs);
+	}
+
+	// Anything asleep that something awake and moving touched wakes up next frame.  It has
+	// to be moving: a circle that was just woken up but is still sitting there would wake
+	// all its sleeping neighbors, and they'd wake theirs, and in a pile like this one
+	// everything would be awake in a few frames.
+	//
+	// The contacts are few, so a plain loop is fine here.  A sleeping circle's slowFrames
+	// isn't used for anything, so -1 there marks it as already on the wake list, and it
+	// only goes on once.
+	float sleepSpeed = SLEEP_SPEED * SLEEP_SPEED;
+	for (int c = 0; c < contacts.count; ++c){
+		int other = contacts.pairs[c].j;
+		if (other < numDynamic){
+			int slot = slotOf[other];
+			int hitter = slotOf[contacts.pairs[c].i];
+			bool moving = xVelocity[hitter] * xVelocity[hitter] + yVelocity[hitter] * yVelocity[hitter] >= sleepSpeed;
+			if (moving && slot >= numAwake && slowFrames[slot] >= 0){
+				slowFrames[slot] = -1;
+				wakeList[numWakes++] = other;
+			}
+		}
+	}
+}
+
+int SleepingCircles::CountMismatches(){
+	// Same pairs as CheckForCollisions, the slow way: every dynamic pair with at least
+	// one awake circle, and every awake circle against every static one.
+	int mismatches = 0;
+	int expected = 0;
+
+	for (int a = 0; a < numAwake; ++a){
+		for (int b = a + 1; b < numDynamic; ++b){
+			expected += (xPosition[a] - xPosition[b]) * (xPosition[a] - xPosition[b])
+				+ (yPosition[a] - yPosition[b]) * (yPosition[a] - yPosition[b])
+				< (radius[a] + radius[b]) * (radius[a] + radius[b]);
+		}
+		for (int s = 0; s < numStatic; ++s){
+			expected += (xPosition[a] - xStatic[s]) * (xPosition[a] - xStatic[s])
+				+ (yPosition[a] - yStatic[s]) * (yPosition[a] - yStatic[s])
+				< (radius[a] + radiusStatic[s]) * (radius[a] + radiusStatic[s]);
+		}
+	}
+
+	int listed = 0;
+	for (int c = 0; c < contacts.count; ++c){
+		int a = slotOf[contacts.pairs[c].i];
+		int j = contacts.pairs[c].j;
+		float x = j < numDynamic ? xPosition[slotOf[j]] : xStatic[j - numDynamic];
+		float y = j < numDynamic ? yPosition[slotOf[j]] : yStatic[j - numDynamic];
+		float r = j < numDynamic ? radius[slotOf[j]] : radiusStatic[j - numDynamic];
+		bool real = a < numAwake && (xPosition[a] - x) * (xPosition[a] - x) + (yPosition[a] - y) * (yPosition[a] - y)
+			< (radius[a] + r) * (radius[a] + r);
+		mismatches += !real;
+		listed += real;
+	}
+	mismatches += expected - listed;
+
+	return mismatches;
+}
+
+// How much this saves is all down to how many circles are asleep.  The work is about
+// numAwake * numCircles pairs instead of numCircles^2 / 2, so it only starts winning once
+// more than half of them are asleep, and with 3 in 4 asleep it's about half the work.
+// Static circles cost nothing at all beyond their one pass per awake row, and they never
+// need updating.
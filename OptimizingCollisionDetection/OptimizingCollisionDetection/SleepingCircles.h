@@ -0,0 +1,99 @@
+/*
+Title: Optimizing Collision Detection
+File Name: SleepingCircles.h
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+A version of ContactListCircles.cpp that lets circles at rest fall asleep, and keeps
+circles that never move apart, so pairs where nothing moved are never tested.
+*/
+#pragma once
+#include "Settings.h"
+#include "ContactList.h"
+
+class SleepingCircles
+{
+public:
+	// The circles that can move, awake ones first.  Slots 0 to numAwake - 1 are awake,
+	// numAwake to numDynamic - 1 are asleep, and the padding is after that.  Circles
+	// change slots as they fall asleep and wake up, so id says which circle is in a slot.
+	float* xPosition;
+	float* xVelocity;
+	float* yPosition;
+	float* yVelocity;
+	float* radius;
+	int* id;
+
+	int numDynamic;
+	int paddedDynamic;
+	int numAwake;
+
+	// The circles that never move.  Built once in the constructor and never touched again,
+	// so no velocities and no sleeping.  Their ids come after the dynamic ones.
+	float* xStatic;
+	float* yStatic;
+	float* radiusStatic;
+	int numStatic;
+	int paddedStatic;
+
+	// Every pair with at least one awake circle in it that overlaps this frame, by id.
+	// Sleeping against sleeping and sleeping against static are never tested, so they're
+	// never in here.  They were already touching when they fell asleep.
+	ContactList contacts;
+
+	// Turn off to keep everything awake, to compare against.
+	bool allowSleep;
+
+	// restingFraction of the dynamic circles start out with no velocity, and
+	// staticFraction of all the circles are static.
+	SleepingCircles(int numCircles = NUM_CIRCLES, float restingFraction = 0.7f, float staticFraction = 0.1f);
+	~SleepingCircles();
+
+	// Makes this exactly the same world as source, down to who's asleep and which slot
+	// everything's in, so sleeping on and off can be timed on the same circles.  Both
+	// have to have been built with the same numbers of circles.
+	void CopyFrom(const SleepingCircles& source);
+
+	// Wakes anything that got hit last frame, moves the awake circles, and puts to sleep
+	// anything that's been slow for long enough.
+	void Update();
+	void CheckForCollisions();
+
+	// Checks contacts against the brute force answer over the same pairs.  Should be 0.
+	int CountMismatches();
+
+private:
+	// Frames in a row each slot has been below SLEEP_SPEED.
+	int* slowFrames;
+
+	// Which slot each id is in, so a contact's id can find its circle.
+	int* slotOf;
+
+	// Sleeping circles hit this frame.  They wake at the start of the next Update().
+	int* wakeList;
+	int numWakes;
+
+	void Swap(int a, int b);
+	void Wake(int slot);
+
+	SleepingCircles(const SleepingCircles&);
+	SleepingCircles& operator=(const SleepingCircles&);
+};
@@ -0,0 +1,187 @@
+/*
+Title: Optimizing Collision Detection
+File Name: SweepAndPruneCircles.cpp
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+A version of DataOptimizedCircles.cpp that uses sort and sweep as a broadphase,
+keeping the circles sorted from one frame to the next.
+*/
+
+#include "SweepAndPruneCircles.h"
+#include "HelperFunctions.h"
+#include <algorithm>
+#include <cstring>
+
+
+SweepAndPruneCircles::SweepAndPruneCircles(int numCircles, float worldSize)
+{
+	this->numCircles = numCircles;
+	this->worldSize = worldSize;
+
+	xPosition = (float*)malloc(numCircles * sizeof(float));
+	xVelocity = (float*)malloc(numCircles * sizeof(float));
+	yPosition = (float*)malloc(numCircles * sizeof(float));
+	yVelocity = (float*)malloc(numCircles * sizeof(float));
+	radius = (float*)malloc(numCircles * sizeof(float));
+
+	sortedIndex = (int*)malloc(numCircles * sizeof(int));
+	sortedMinX = (float*)malloc(numCircles * sizeof(float));
+
+	for (int i = 0; i < numCircles; ++i){
+		xPosition[i] = Helper::RandomFloat(0, worldSize);
+		yPosition[i] = Helper::RandomFloat(0, worldSize);
+		xVelocity[i] = Helper::RandomFloat(-1.0f, 1.0f);
+		yVelocity[i] = Helper::RandomFloat(-1.0f, 1.0f);
+		radius[i] = Helper::RandomFloat(5.0f, 100.0f);
+
+		sortedIndex[i] = i;
+	}
+
+	isCollided = (bool**)malloc(sizeof(bool*) * numCircles);
+	for (int i = 0; i < numCircles; ++i){
+		isCollided[i] = (bool*)malloc(sizeof(bool) * numCircles);
+		memset(isCollided[i], 0, sizeof(bool) * numCircles);
+	}
+
+	// The very first sort is on completely random data, and insertion sort on random
+	// data really is O(N^2).  So use a proper sort once, and from then on the list only
+	// ever needs touching up.
+	std::sort(sortedIndex, sortedIndex + numCircles, [this](int a, int b){
+		return xPosition[a] - radius[a] < xPosition[b] - radius[b];
+	});
+	SortIntervals();
+}
+
+
+SweepAndPruneCircles::~SweepAndPruneCircles()
+{
+	free(xPosition);
+	free(xVelocity);
+	free(yPosition);
+	free(yVelocity);
+	free(radius);
+
+	free(sortedIndex);
+	free(sortedMinX);
+
+	for (int i = 0; i < numCircles; ++i){
+		free(isCollided[i]);
+	}
+	free(isCollided);
+}
+
+void SweepAndPruneCircles::SortIntervals(){
+	// Refresh the keys, in the order we had last frame.
+	for (int k = 0; k < numCircles; ++k){
+		int i = sortedIndex[k];
+		sortedMinX[k] = xPosition[i] - radius[i];
+	}
+
+	// Now insertion sort.  Everyone knows insertion sort is O(N^2), but that's the worst
+	// case.  Each element only walks left until it finds something smaller, so if the
+	// list is almost sorted already it barely walks at all.  Every circle moves by at
+	// most its velocity each frame, so last frame's order is almost right, and this ends
+	// up being close to O(N).
+	int swaps = 0;
+	for (int k = 1; k < numCircles; ++k){
+		float key = sortedMinX[k];
+		int index = sortedIndex[k];
+
+		int m = k - 1;
+		while (m >= 0 && sortedMinX[m] > key){
+			sortedMinX[m + 1] = sortedMinX[m];
+			sortedIndex[m + 1] = sortedIndex[m];
+			--m;
+		}
+		swaps += k - 1 - m;
+
+		sortedMinX[m + 1] = key;
+		sortedIndex[m + 1] = index;
+	}
+	lastSortSwaps = swaps;
+}
+
+void SweepAndPruneCircles::Update(){
+	for (int i = 0; i < numCircles; ++i){
+		xPosition[i] += xVelocity[i];
+		yPosition[i] += yVelocity[i];
+	}
+
+	SortIntervals();
+}
+
+void SweepAndPruneCircles::CheckForCollisions(){
+	// Same trick as the grid, only clear what we set last time.
+	for (size_t c = 0; c < contacts.size(); ++c){
+		isCollided[contacts[c].i][contacts[c].j] = false;
+	}
+	contacts.clear();
+
+	// And here's the sweep.  Walk the circles left to right.  Everything to the right of
+	// us in the list starts further right than we do, so as soon as we hit one that starts
+	// past our right edge, everything after it does too and we can stop.
+	for (int k = 0; k < numCircles; ++k){
+		int a = sortedIndex[k];
+		float x = xPosition[a];
+		float y = yPosition[a];
+		float r = radius[a];
+		float maxX = x + r;
+
+		for (int m = k + 1; m < numCircles && sortedMinX[m] <= maxX; ++m){
+			int b = sortedIndex[m];
+
+			float xDif = x - xPosition[b];
+			float yDif = y - yPosition[b];
+			float radiusAdd = r + radius[b];
+			if (xDif * xDif + yDif * yDif < radiusAdd * radiusAdd){
+				// The sort scrambles which one is i and which is j, so put them back
+				// so we're filling the same top right triangle as everyone else.
+				int i = a < b ? a : b;
+				int j = a < b ? b : a;
+				isCollided[i][j] = true;
+				Contact contact = { i, j };
+				contacts.push_back(contact);
+			}
+		}
+	}
+}
+
+int SweepAndPruneCircles::CountMismatches(){
+	int mismatches = 0;
+	for (int i = 0; i < numCircles; ++i){
+		for (int j = i + 1; j < numCircles; ++j){
+			bool expected = (xPosition[i] - xPosition[j]) * (xPosition[i] - xPosition[j])
+				+ (yPosition[i] - yPosition[j]) * (yPosition[i] - yPosition[j])
+				< (radius[i] + radius[j]) * (radius[i] + radius[j]);
+			mismatches += expected != isCollided[i][j];
+		}
+	}
+	return mismatches;
+}
+
+// Sort and sweep only looks at one axis, so if all of your circles are lined up
+// vertically it's no better than brute force.  It's also very sensitive to how big
+// the circles are, since bigger intervals mean more overlaps to walk through.
+//
+// What it has going for it is it's incredibly simple, it uses almost no memory, and
+// it takes advantage of the fact that a frame usually looks a lot like the frame
+// before it.  That idea, called temporal coherence, shows up all over game code.
@@ -0,0 +1,74 @@
+/*
+Title: Optimizing Collision Detection
+File Name: SweepAndPruneCircles.h
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+A version of DataOptimizedCircles.cpp that uses sort and sweep as a broadphase,
+keeping the circles sorted from one frame to the next.
+*/
+
+#pragma once
+#include <vector>
+#include "Settings.h"
+
+class SweepAndPruneCircles
+{
+public:
+	int numCircles;
+	float worldSize;
+
+	float* xPosition;
+	float* xVelocity;
+	float* yPosition;
+	float* yVelocity;
+	float* radius;
+
+	bool** isCollided;
+
+	// How many swaps the insertion sort needed in the last Update().  If the circles
+	// barely move this should be tiny compared to numCircles.
+	int lastSortSwaps;
+
+	SweepAndPruneCircles(int numCircles = NUM_CIRCLES, float worldSize = 1000.0f);
+	~SweepAndPruneCircles();
+
+	void Update();
+	void CheckForCollisions();
+
+	// Tests every pair the slow way and returns how many entries of isCollided
+	// disagree with it.  Should always be 0.
+	int CountMismatches();
+
+private:
+	// The circles, in order of the left edge of their x interval (xPosition - radius).
+	// The order is kept between frames, that's the whole trick.
+	int* sortedIndex;
+	float* sortedMinX;
+
+	struct Contact{
+		int i;
+		int j;
+	};
+	std::vector<Contact> contacts;
+
+	void SortIntervals();
+};
@@ -0,0 +1,259 @@
+/*
+Title: Optimizing Collision Detection
+File Name: SweptCircles.cpp
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+A version of SIMDOptimizedCircles.cpp that sweeps each pair over the whole step and
+finds when they first touch, so fast circles can't pass through each other.
+*/
+
+#include "SweptCircles.h"
+#include "Platform.h"
+#include "HelperFunctions.h"
+#include <cmath>
+
+const float SweptCircles::noImpact = 2.0f;
+
+// The time of impact for one pair, the slow and obvious way.  Same formula as the SIMD
+// version below, so see there for how it works.
+static float TimeOfImpact(float dx, float dy, float vx, float vy, float radiusSum){
+	float c = dx * dx + dy * dy - radiusSum * radiusSum;
+	if (c < 0.0f){
+		return 0.0f;
+	}
+
+	float a = vx * vx + vy * vy;
+	float b = dx * vx + dy * vy;
+	float discriminant = b * b - a * c;
+	if (b >= 0.0f || discriminant < 0.0f){
+		return SweptCircles::noImpact;
+	}
+
+	float root = -b - sqrtf(discriminant);
+	return root >= 0.0f && root <= a ? root / a : SweptCircles::noImpact;
+}
+
+SweptCircles::SweptCircles(int numCircles, float maxSpeed, float timeStep)
+{
+	this->numCircles = numCircles;
+	paddedCircles = Helper::PadCircles(numCircles, 4);
+	this->timeStep = timeStep;
+
+	xPosition = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	xVelocity = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	yPosition = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	yVelocity = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	radius = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	earliestImpact = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	timeOfImpact = (float**)malloc(sizeof(float*) * numCircles);
+
+	for (int i = 0; i < numCircles; ++i){
+		xPosition[i] = Helper::RandomFloat(0, 1000.0f);
+		yPosition[i] = Helper::RandomFloat(0, 1000.0f);
+		xVelocity[i] = Helper::RandomFloat(-maxSpeed, maxSpeed);
+		yVelocity[i] = Helper::RandomFloat(-maxSpeed, maxSpeed);
+		radius[i] = Helper::RandomFloat(5.0f, 100.0f);
+
+		timeOfImpact[i] = (float*)_aligned_malloc(sizeof(float) * paddedCircles, 16);
+		for (int j = 0; j < paddedCircles; ++j){
+			timeOfImpact[i][j] = noImpact;
+		}
+	}
+	Helper::FillPadding(xPosition, xVelocity, yPosition, yVelocity, radius, numCircles, paddedCircles);
+}
+
+SweptCircles::~SweptCircles()
+{
+	_aligned_free(xPosition);
+	_aligned_free(yPosition);
+	_aligned_free(xVelocity);
+	_aligned_free(yVelocity);
+	_aligned_free(radius);
+	_aligned_free(earliestImpact);
+
+	for (int i = 0; i < numCircles; ++i){
+		_aligned_free(timeOfImpact[i]);
+	}
+	free(timeOfImpact);
+}
+
+void SweptCircles::Update(){
+	__m128 step = _mm_set1_ps(timeStep);
+	for (int i = 0; i < paddedCircles; i += 4){
+		_mm_store_ps(xPosition + i, _mm_add_ps(_mm_load_ps(xPosition + i), _mm_mul_ps(_mm_load_ps(xVelocity + i), step)));
+		_mm_store_ps(yPosition + i, _mm_add_ps(_mm_load_ps(yPosition + i), _mm_mul_ps(_mm_load_ps(yVelocity + i), step)));
+	}
+}
+
+void SweptCircles::CheckForCollisions(){
+	// The discrete test asks "do these two overlap right now?"  If two small fast circles
+	// start on opposite sides of each other, and a step later they've swapped sides, the
+	// answer is no both times and they went straight through each other.  The only fix
+	// the discrete test has is smaller steps, and every halving of the step doubles the
+	// work.
+	//
+	// So ask a different question: "when during this step do they first touch?"  Put
+	// circle i at the origin, standing still.  Then j starts at d = pj - pi and moves by
+	// v = (vj - vi) * timeStep over the step.  They touch when the distance is the sum of
+	// the radii, R:
+	//
+	//     |d + v t|^2 = R^2
+	//     (v.v) t^2 + 2 (d.v) t + (d.d - R^2) = 0
+	//
+	// Call those a, b (without the 2) and c.  Then the first touch is
+	//
+	//     t = (-b - sqrt(b^2 - a c)) / a
+	//
+	// and it's only a hit if it's real (b^2 - a c >= 0), they're moving towards each
+	// other (b < 0) and it happens before the step ends (t <= 1).  If c < 0 they already
+	// overlap, and the answer is 0.
+	//
+	// That's a lot of ifs for SIMD.  So work all of it out for every lane anyway and use
+	// the conditions as masks.  Even t <= 1 doesn't need the divide, it's just
+	// -b - sqrt(...) <= a, since a is never negative.
+
+	__m128 step = _mm_set1_ps(timeStep);
+	__m128 zero = _mm_setzero_ps();
+	__m128 never = _mm_set1_ps(noImpact);
+
+	for (int i = 0; i < paddedCircles; i += 4){
+		_mm_store_ps(earliestImpact + i, never);
+	}
+
+	for (int i = 0; i < numCircles; ++i){
+		__m128 xPos = _mm_load1_ps(xPosition + i);
+		__m128 yPos = _mm_load1_ps(yPosition + i);
+		__m128 xVel = _mm_load1_ps(xVelocity + i);
+		__m128 yVel = _mm_load1_ps(yVelocity + i);
+		__m128 rad = _mm_load1_ps(radius + i);
+		__m128 rowEarliest = never;
+
+		int j = i & ~3;
+
+		// The group with i in it includes i itself and the j's before it.  i against i
+		// "already overlaps", so those lanes get pushed out to noImpact before they can
+		// touch earliestImpact.
+		__m128 validLanes = _mm_castsi128_ps(_mm_cmpgt_epi32(
+			_mm_setr_epi32(0, 1, 2, 3), _mm_set1_epi32(i & 3)));
+
+		do {
+			__m128 dx = _mm_sub_ps(_mm_load_ps(xPosition + j), xPos);
+			__m128 dy = _mm_sub_ps(_mm_load_ps(yPosition + j), yPos);
+			__m128 vx = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(xVelocity + j), xVel), step);
+			__m128 vy = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(yVelocity + j), yVel), step);
+			__m128 radiusSum = _mm_add_ps(_mm_load_ps(radius + j), rad);
+
+			__m128 c = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(radiusSum, radiusSum));
+			__m128 a = _mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy));
+			__m128 b = _mm_add_ps(_mm_mul_ps(dx, vx), _mm_mul_ps(dy, vy));
+			__m128 discriminant = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(a, c));
+
+			// A negative discriminant makes sqrt give NaN.  Those lanes are thrown away by
+			// the mask, but clamping first keeps NaNs out of the registers altogether.
+			__m128 root = _mm_sub_ps(_mm_sub_ps(zero, b), _mm_sqrt_ps(_mm_max_ps(discriminant, zero)));
+
+			// The root can't really be negative when c >= 0.  But a padding circle is so far
+			// away that b * b can overflow to infinity, and then it's minus infinity.
+			// Checking it's in 0 to a, not just under a, throws those out too.
+			__m128 overlapping = _mm_cmplt_ps(c, zero);
+			__m128 approaching = _mm_and_ps(
+				_mm_and_ps(_mm_cmplt_ps(b, zero), _mm_cmpge_ps(discriminant, zero)),
+				_mm_and_ps(_mm_cmpge_ps(root, zero), _mm_cmple_ps(root, a)));
+
+			// a is 0 when nothing's moving relative to each other, and the divide gives
+			// garbage.  Same deal as the NaNs: those lanes aren't approaching, so they
+			// never get picked.
+			__m128 time = _mm_div_ps(root, a);
+			time = _mm_or_ps(_mm_and_ps(approaching, time), _mm_andnot_ps(approaching, never));
+			time = _mm_andnot_ps(overlapping, time);
+			time = _mm_or_ps(_mm_and_ps(validLanes, time), _mm_andnot_ps(validLanes, never));
+
+			_mm_store_ps(timeOfImpact[i] + j, time);
+
+			// Both circles in the pair care about it.  i gets a running minimum in a
+			// register, and j's minimum lives in memory, 4 at a time.
+			rowEarliest = _mm_min_ps(rowEarliest, time);
+			_mm_store_ps(earliestImpact + j, _mm_min_ps(_mm_load_ps(earliestImpact + j), time));
+
+			validLanes = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			j += 4;
+		} while (j < paddedCircles);
+
+		// Squash the 4 lanes down to 1, the same way TiledOptimizedCircles adds its counts.
+		rowEarliest = _mm_min_ps(rowEarliest, _mm_shuffle_ps(rowEarliest, rowEarliest, _MM_SHUFFLE(1, 0, 3, 2)));
+		rowEarliest = _mm_min_ps(rowEarliest, _mm_shuffle_ps(rowEarliest, rowEarliest, _MM_SHUFFLE(2, 3, 0, 1)));
+		_mm_store_ss(earliestImpact + i, _mm_min_ss(_mm_load_ss(earliestImpact + i), rowEarliest));
+	}
+}
+
+int SweptCircles::CountMismatches(){
+	int mismatches = 0;
+
+	for (int i = 0; i < numCircles; ++i){
+		float earliest = noImpact;
+		for (int j = 0; j < numCircles; ++j){
+			if (j == i){
+				continue;
+			}
+			float expected = TimeOfImpact(xPosition[j] - xPosition[i], yPosition[j] - yPosition[i],
+				(xVelocity[j] - xVelocity[i]) * timeStep, (yVelocity[j] - yVelocity[i]) * timeStep, radius[i] + radius[j]);
+			if (expected < earliest){
+				earliest = expected;
+			}
+
+			// The plain C++ and the SIMD do the same operations in the same order, so these
+			// should match exactly.  The tolerance is just in case a compiler fuses a
+			// multiply and an add somewhere in the C++.
+			if (j > i && fabsf(expected - timeOfImpact[i][j]) > 1.0e-4f){
+				++mismatches;
+			}
+		}
+		if (fabsf(earliest - earliestImpact[i]) > 1.0e-4f){
+			++mismatches;
+		}
+	}
+
+	return mismatches;
+}
+
+int SweptCircles::CountImpacts(){
+	int impacts = 0;
+	for (int i = 0; i < numCircles; ++i){
+		for (int j = i + 1; j < numCircles; ++j){
+			impacts += timeOfImpact[i][j] <= 1.0f;
+		}
+	}
+	return impacts;
+}
+
+bool SweptCircles::OverlapsAt(int i, int j, float t){
+	float dx = xPosition[j] + xVelocity[j] * timeStep * t - xPosition[i] - xVelocity[i] * timeStep * t;
+	float dy = yPosition[j] + yVelocity[j] * timeStep * t - yPosition[i] - yVelocity[i] * timeStep * t;
+	return dx * dx + dy * dy < (radius[i] + radius[j]) * (radius[i] + radius[j]);
+}
+
+// What's it cost?  About twice the math of the discrete test per pair, plus a square
+// root and a divide, and those two are slow.  In practice one swept step costs about the
+// same as 4 or 5 discrete ticks, so it pays for itself once a discrete version would
+// need more ticks than that to stop the tunneling.  And it still catches the contacts
+// that happen between ticks, which no number of ticks ever quite does.  main.cpp
+// prints both.
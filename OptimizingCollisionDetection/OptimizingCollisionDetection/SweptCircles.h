@@ -0,0 +1,79 @@
+/*
+Title: Optimizing Collision Detection
+File Name: SweptCircles.h
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+A version of SIMDOptimizedCircles.cpp that sweeps each pair over the whole step and
+finds when they first touch, so fast circles can't pass through each other.
+*/
+#pragma once
+#include "Settings.h"
+
+class SweptCircles
+{
+public:
+	float* xPosition;
+	float* xVelocity;
+	float* yPosition;
+	float* yVelocity;
+	float* radius;
+
+	int numCircles;
+	int paddedCircles;
+
+	// How far through the step (0 to 1) pair i, j first touch, for j > i.  Anything over
+	// 1 means they don't touch this step.  Pairs that already overlap at the start are 0.
+	float** timeOfImpact;
+
+	// The smallest timeOfImpact each circle has with anyone, or noImpact.  This is what a
+	// solver actually wants: how far it can move everything before something goes wrong.
+	float* earliestImpact;
+
+	// What timeOfImpact and earliestImpact hold when there's nothing to hit.
+	static const float noImpact;
+
+	// Velocities are per second, and one step moves everything velocity * timeStep.  The
+	// discrete tests are the same thing with timeStep stuck at 1.
+	float timeStep;
+
+	SweptCircles(int numCircles = NUM_CIRCLES, float maxSpeed = 1.0f, float timeStep = 1.0f);
+	~SweptCircles();
+
+	void Update();
+
+	// Sweeps every pair over the step that Update() is about to take.  So call this first,
+	// then Update(), which is the other way around from the discrete tests.
+	void CheckForCollisions();
+
+	// Checks timeOfImpact and earliestImpact against plain C++.  Should always be 0.
+	int CountMismatches();
+
+	// Pairs (j > i) with an impact this step.
+	int CountImpacts();
+
+	// Whether i and j overlap at time t through the coming step (0 to 1), the discrete way.
+	bool OverlapsAt(int i, int j, float t);
+
+private:
+	SweptCircles(const SweptCircles&);
+	SweptCircles& operator=(const SweptCircles&);
+};
@@ -0,0 +1,109 @@
+/*
+Title: Optimizing Collision Detection
+File Name: ThreadPool.cpp
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+A very small pool of threads that are created once and then reused, so running
+work on every core doesn't mean creating threads every frame.
+*/
+
+#include "ThreadPool.h"
+
+
+ThreadPool::ThreadPool(int numThreads)
+{
+	this->numThreads = numThreads < 1 ? 1 : numThreads;
+	currentJob = 0;
+	generation = 0;
+	running = 0;
+	quitting = false;
+
+	// Creating a thread is expensive (it's a trip into the OS), so we do it exactly once
+	// here.  After that the threads just sleep until Run wakes them up.
+	for (int t = 1; t < this->numThreads; ++t){
+		workers.push_back(std::thread(&ThreadPool::WorkerLoop, this, t));
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		quitting = true;
+	}
+	startSignal.notify_all();
+
+	for (size_t t = 0; t < workers.size(); ++t){
+		workers[t].join();
+	}
+}
+
+int ThreadPool::NumThreads(){
+	return numThreads;
+}
+
+void ThreadPool::Run(const std::function<void(int)>& job){
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		currentJob = &job;
+		running = numThreads - 1;
+		++generation;
+	}
+	startSignal.notify_all();
+
+	job(0);
+
+	std::unique_lock<std::mutex> guard(lock);
+	while (running > 0){
+		doneSignal.wait(guard);
+	}
+	currentJob = 0;
+}
+
+void ThreadPool::WorkerLoop(int threadIndex){
+	int seenGeneration = 0;
+
+	for (;;){
+		const std::function<void(int)>* job;
+		{
+			// The generation counter is how a worker tells a new job from the one it just
+			// finished.  Condition variables can wake up for no reason at all, so we
+			// always check it instead of trusting the wake up.
+			std::unique_lock<std::mutex> guard(lock);
+			while (!quitting && generation == seenGeneration){
+				startSignal.wait(guard);
+			}
+			if (quitting){
+				return;
+			}
+			seenGeneration = generation;
+			job = currentJob;
+		}
+
+		(*job)(threadIndex);
+
+		std::unique_lock<std::mutex> guard(lock);
+		if (--running == 0){
+			doneSignal.notify_one();
+		}
+	}
+}
@@ -0,0 +1,65 @@
+/*
+Title: Optimizing Collision Detection
+File Name: ThreadPool.h
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+A very small pool of threads that are created once and then reused, so running
+work on every core doesn't mean creating threads every frame.
+*/
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <vector>
+
+class ThreadPool
+{
+public:
+	// numThreads counts the thread that calls Run, so a pool of 1 starts no threads at all.
+	ThreadPool(int numThreads);
+	~ThreadPool();
+
+	int NumThreads();
+
+	// Runs job(0) through job(numThreads - 1), one on each thread, and waits until
+	// they've all finished.  The calling thread does job(0) itself instead of sitting idle.
+	void Run(const std::function<void(int)>& job);
+
+private:
+	std::vector<std::thread> workers;
+	int numThreads;
+
+	std::mutex lock;
+	std::condition_variable startSignal;
+	std::condition_variable doneSignal;
+
+	const std::function<void(int)>* currentJob;
+	int generation;
+	int running;
+	bool quitting;
+
+	void WorkerLoop(int threadIndex);
+
+	ThreadPool(const ThreadPool&);
+	ThreadPool& operator=(const ThreadPool&);
+};
@@ -0,0 +1,206 @@
+/*
+Title: Optimizing Collision Detection
+File Name: ThreadedOptimizedCircles.cpp
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+A version of SIMDOptimizedCircles.cpp that splits CheckForCollisions across
+every core of the machine.
+*/
+
+#include "ThreadedOptimizedCircles.h"
+#include "Platform.h"
+#include "HelperFunctions.h"
+
+// How many bits are set in a 4 bit movemask.
+static const int bitCount[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+ThreadedOptimizedCircles::ThreadedOptimizedCircles(int numThreads, int numCircles)
+{
+	this->numCircles = numCircles;
+	paddedCircles = Helper::PadCircles(numCircles, 4);
+	rowFloats = Helper::PadCircles(paddedCircles, (int)(CACHE_LINE_SIZE / sizeof(float)));
+
+	xPosition = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	xVelocity = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	yPosition = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	yVelocity = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	radius = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	isCollided = (float**)malloc(sizeof(float*) * numCircles);
+
+	for (int i = 0; i < numCircles; ++i){
+		xPosition[i] = Helper::RandomFloat(0, 1000.0f);
+		yPosition[i] = Helper::RandomFloat(0, 1000.0f);
+		xVelocity[i] = Helper::RandomFloat(-1.0f, 1.0f);
+		yVelocity[i] = Helper::RandomFloat(-1.0f, 1.0f);
+		radius[i] = Helper::RandomFloat(5.0f, 100.0f);
+
+		// Two threads writing to the same cache line, even different bytes of it, fight
+		// over who owns that line (it's called false sharing), and it's slow.  Starting
+		// every row on its own cache line means two threads can never share one.
+		isCollided[i] = (float*)_aligned_malloc(sizeof(float) * rowFloats, CACHE_LINE_SIZE);
+		memset(isCollided[i], 0, sizeof(float) * rowFloats);
+	}
+	Helper::FillPadding(xPosition, xVelocity, yPosition, yVelocity, radius, numCircles, paddedCircles);
+
+	pool = 0;
+	rowStart = 0;
+	threadStats = 0;
+	SetThreadCount(numThreads);
+}
+
+ThreadedOptimizedCircles::~ThreadedOptimizedCircles()
+{
+	delete pool;
+	free(rowStart);
+	_aligned_free(threadStats);
+
+	_aligned_free(xPosition);
+	_aligned_free(yPosition);
+	_aligned_free(xVelocity);
+	_aligned_free(yVelocity);
+	_aligned_free(radius);
+
+	for (int i = 0; i < numCircles; ++i){
+		_aligned_free(isCollided[i]);
+	}
+	free(isCollided);
+}
+
+void ThreadedOptimizedCircles::SetThreadCount(int numThreads){
+	delete pool;
+	free(rowStart);
+	_aligned_free(threadStats);
+
+	pool = new ThreadPool(numThreads);
+	numThreads = pool->NumThreads();
+
+	// Same deal as the rows, each thread's stats get a cache line all to themselves.
+	threadStats = (ThreadStats*)_aligned_malloc(sizeof(ThreadStats) * numThreads, CACHE_LINE_SIZE);
+	memset(threadStats, 0, sizeof(ThreadStats) * numThreads);
+
+	// Now the actual point of this class.  The easy way to split the work is to give each
+	// thread the same number of rows.  But we only do the top right triangle, so row 0
+	// has numCircles pairs and the last row has almost none.  With 4 threads the first
+	// one would get 7 times the work of the last, and everyone would wait on it.
+	//
+	// So instead we add up how much work each row really is (how many j's the SIMD loop
+	// goes through) and cut the triangle where each thread gets the same share of that.
+	double totalWork = 0.0;
+	for (int i = 0; i < numCircles; ++i){
+		totalWork += paddedCircles - (i & ~3);
+	}
+
+	rowStart = (int*)malloc(sizeof(int) * (numThreads + 1));
+	rowStart[0] = 0;
+	int thread = 1;
+	double work = 0.0;
+	for (int i = 0; i < numCircles && thread < numThreads; ++i){
+		work += paddedCircles - (i & ~3);
+		while (thread < numThreads && work >= totalWork * thread / numThreads){
+			rowStart[thread++] = i + 1;
+		}
+	}
+	while (thread <= numThreads){
+		rowStart[thread++] = numCircles;
+	}
+}
+
+int ThreadedOptimizedCircles::ThreadCount(){
+	return pool->NumThreads();
+}
+
+void ThreadedOptimizedCircles::Update(){
+	// Update is only N operations, it's not worth waking everyone up for.
+	for (int i = 0; i < paddedCircles; i += 4){
+		_mm_store_ps(xPosition + i, _mm_add_ps(_mm_load_ps(xPosition + i), _mm_load_ps(xVelocity + i)));
+		_mm_store_ps(yPosition + i, _mm_add_ps(_mm_load_ps(yPosition + i), _mm_load_ps(yVelocity + i)));
+	}
+}
+
+void ThreadedOptimizedCircles::CheckForCollisions(){
+	// Every thread runs CheckRows on its own slice.  The pool's threads are already
+	// running and waiting, so this costs a wake up, not a thread creation.
+	pool->Run([this](int thread){ CheckRows(thread); });
+}
+
+void ThreadedOptimizedCircles::CheckRows(int thread){
+	// This is the same loop as SIMDOptimizedCircles, just on a slice of the rows.
+	// Each thread only ever writes to its own rows, so there's nothing to lock.
+	int collisions = 0;
+
+	for (int i = rowStart[thread]; i < rowStart[thread + 1]; ++i){
+		__m128 xPos = _mm_load1_ps(xPosition + i);
+		__m128 yPos = _mm_load1_ps(yPosition + i);
+		__m128 rad = _mm_load1_ps(radius + i);
+
+		int j = i & ~3;
+		int validLanes = (0xF << ((i & 3) + 1)) & 0xF;
+
+		do {
+			__m128 xDif = _mm_sub_ps(xPos, _mm_load_ps(xPosition + j));
+			__m128 yDif = _mm_sub_ps(yPos, _mm_load_ps(yPosition + j));
+			__m128 radiusAdd = _mm_add_ps(rad, _mm_load_ps(radius + j));
+
+			__m128 result = _mm_cmplt_ps(
+				_mm_add_ps(_mm_mul_ps(xDif, xDif), _mm_mul_ps(yDif, yDif)),
+				_mm_mul_ps(radiusAdd, radiusAdd));
+
+			_mm_store_ps(isCollided[i] + j, result);
+			collisions += bitCount[_mm_movemask_ps(result) & validLanes];
+
+			validLanes = 0xF;
+			j += 4;
+		} while (j < paddedCircles);
+	}
+
+	// Keep the count in a local and write it out once.  Even with the padding there's no
+	// reason to touch shared memory more than we need to.
+	threadStats[thread].collisions = collisions;
+}
+
+int ThreadedOptimizedCircles::CountCollisions(){
+	int total = 0;
+	for (int t = 0; t < pool->NumThreads(); ++t){
+		total += threadStats[t].collisions;
+	}
+	return total;
+}
+
+int ThreadedOptimizedCircles::CountMismatches(){
+	int mismatches = 0;
+
+	for (int i = 0; i < numCircles; ++i){
+		for (int j = i + 1; j < numCircles; ++j){
+			bool expected = (xPosition[i] - xPosition[j]) * (xPosition[i] - xPosition[j])
+				+ (yPosition[i] - yPosition[j]) * (yPosition[i] - yPosition[j])
+				< (radius[i] + radius[j]) * (radius[i] + radius[j]);
+			mismatches += expected != (isCollided[i][j] != 0.0f);
+		}
+	}
+
+	return mismatches;
+}
+
+// Threads aren't free.  Waking them up, and waiting for the slowest one to finish, costs
+// a little every frame no matter how much work there is.  At small N that can eat the
+// whole gain.  Check the scaling numbers main.cpp prints: if going from 8 threads to 16
+// barely helps, you've probably run out of memory bandwidth instead of cores.
@@ -0,0 +1,81 @@
+/*
+Title: Optimizing Collision Detection
+File Name: ThreadedOptimizedCircles.h
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+A version of SIMDOptimizedCircles.cpp that splits CheckForCollisions across
+every core of the machine.
+*/
+#pragma once
+#include "Settings.h"
+#include "ThreadPool.h"
+
+class ThreadedOptimizedCircles
+{
+public:
+	float* xPosition;
+	float* xVelocity;
+	float* yPosition;
+	float* yVelocity;
+	float* radius;
+
+	int numCircles;
+	int paddedCircles;
+
+	float** isCollided;
+
+	// Each thread keeps its own running total here.  See the .cpp for why it's padded.
+	struct ThreadStats{
+		int collisions;
+		char padding[CACHE_LINE_SIZE - sizeof(int)];
+	};
+	ThreadStats* threadStats;
+
+	ThreadedOptimizedCircles(int numThreads = 1, int numCircles = NUM_CIRCLES);
+	~ThreadedOptimizedCircles();
+
+	// Throws away the old pool and makes a new one.  Don't call this every frame,
+	// that's exactly what the pool is there to avoid.
+	void SetThreadCount(int numThreads);
+	int ThreadCount();
+
+	void Update();
+	void CheckForCollisions();
+
+	// Adds up threadStats.  How many pairs (j > i) collided last CheckForCollisions().
+	int CountCollisions();
+
+	// Checks isCollided against the plain C++ test and returns how many pairs (j > i)
+	// disagree.  Should always be 0.
+	int CountMismatches();
+
+private:
+	ThreadPool* pool;
+
+	// Thread t does rows rowStart[t] up to (not including) rowStart[t + 1].
+	int* rowStart;
+
+	// Each row of isCollided gets rounded up to a whole number of cache lines.
+	int rowFloats;
+
+	void CheckRows(int thread);
+};
@@ -0,0 +1,223 @@
+/*
+Title: Optimizing Collision Detection
+File Name: TiledOptimizedCircles.cpp
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+A version of SIMDOptimizedCircles.cpp that works through the pair matrix in tiles
+sized to stay in cache, for when N is too big for the whole arrays to fit.
+*/
+
+#include "TiledOptimizedCircles.h"
+#include "Platform.h"
+#include "HelperFunctions.h"
+
+// How many bits are set in a 4 bit movemask.
+static const int bitCount[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+TiledOptimizedCircles::TiledOptimizedCircles(int numCircles, float worldSize, int tileRows, int tileColumns)
+{
+	// This used to round numCircles itself up to a multiple of 4, which quietly added up
+	// to 3 real circles to the world.  Now the extra ones are padding that never collides.
+	this->numCircles = numCircles;
+	paddedCircles = Helper::PadCircles(numCircles, 4);
+	this->worldSize = worldSize;
+
+	xPosition = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	xVelocity = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	yPosition = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	yVelocity = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	radius = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+
+	for (int i = 0; i < numCircles; ++i){
+		xPosition[i] = Helper::RandomFloat(0, worldSize);
+		yPosition[i] = Helper::RandomFloat(0, worldSize);
+		xVelocity[i] = Helper::RandomFloat(-1.0f, 1.0f);
+		yVelocity[i] = Helper::RandomFloat(-1.0f, 1.0f);
+		radius[i] = Helper::RandomFloat(5.0f, 100.0f);
+	}
+	Helper::FillPadding(xPosition, xVelocity, yPosition, yVelocity, radius, numCircles, paddedCircles);
+
+	collisionCount = 0;
+	SetTileSize(tileRows, tileColumns);
+}
+
+TiledOptimizedCircles::~TiledOptimizedCircles()
+{
+	_aligned_free(xPosition);
+	_aligned_free(yPosition);
+	_aligned_free(xVelocity);
+	_aligned_free(yVelocity);
+	_aligned_free(radius);
+}
+
+void TiledOptimizedCircles::SetTileSize(int tileRows, int tileColumns){
+	this->tileRows = ((tileRows < 4 ? 4 : tileRows) + 3) & ~3;
+	this->tileColumns = ((tileColumns < 4 ? 4 : tileColumns) + 3) & ~3;
+}
+
+int TiledOptimizedCircles::TileRows(){
+	return tileRows;
+}
+
+int TiledOptimizedCircles::TileColumns(){
+	return tileColumns;
+}
+
+void TiledOptimizedCircles::Update(){
+	for (int i = 0; i < paddedCircles; i += 4){
+		_mm_store_ps(xPosition + i, _mm_add_ps(_mm_load_ps(xPosition + i), _mm_load_ps(xVelocity + i)));
+		_mm_store_ps(yPosition + i, _mm_add_ps(_mm_load_ps(yPosition + i), _mm_load_ps(yVelocity + i)));
+	}
+}
+
+void TiledOptimizedCircles::CheckForCollisions(){
+	collisionCount = CheckRowsTiled(0, numCircles);
+}
+
+long long TiledOptimizedCircles::CheckRowsUntiled(int rowBegin, int rowEnd){
+	// The SIMD test the way it's always been done: one i at a time against every j.  Each
+	// row reads all of xPosition, yPosition and radius from i onwards.  At 1000 circles
+	// that's 12KB and it all sits in L1 the whole time.  At a million circles it's 12MB,
+	// and by the time we come back round for the next i, the start of the arrays has long
+	// since been pushed out of cache by the end of them.  So every row goes back out to
+	// L3 or main memory for all of its j's.
+	return CheckTile(rowBegin, rowEnd, rowBegin & ~3, paddedCircles);
+}
+
+long long TiledOptimizedCircles::CheckRowsTiled(int rowBegin, int rowEnd){
+	// Same pairs, different order.  Take tileRows i's, and run all of them against one
+	// tileColumns wide block of j's before moving on to the next block.  The first i pulls
+	// the block into L1 and the other tileRows - 1 get it for free.  Memory traffic for
+	// the j's drops by about a factor of tileRows.
+	//
+	// The order doesn't change the answer, we just visit the pairs in a different order.
+	long long collisions = 0;
+
+	for (int rowBlock = rowBegin; rowBlock < rowEnd; rowBlock += tileRows){
+		int rowBlockEnd = rowBlock + tileRows < rowEnd ? rowBlock + tileRows : rowEnd;
+
+		// Nothing left of the first row of the block is ever tested, so start there.
+		for (int column = rowBlock & ~3; column < paddedCircles; column += tileColumns){
+			int columnEnd = column + tileColumns < paddedCircles ? column + tileColumns : paddedCircles;
+			collisions += CheckTile(rowBlock, rowBlockEnd, column, columnEnd);
+		}
+	}
+
+	return collisions;
+}
+
+void TiledOptimizedCircles::UpdateAndCheckForCollisions(){
+	collisionCount = UpdateAndCheckRows(0, numCircles);
+}
+
+long long TiledOptimizedCircles::UpdateAndCheckRows(int rowBegin, int rowEnd){
+	// At a few million circles Update() is a trip through 16 bytes of every circle from
+	// main memory, and then CheckRowsTiled() goes straight back out for the 12 bytes of
+	// x, y and radius.  The positions have been to the CPU and back for nothing.
+	//
+	// So flip the tiling around.  The block of j's is the outside loop now: move the
+	// block, then test every row that reaches it while the block is still in L1.  A row
+	// only reaches j's from i rounded down to 4 onwards, so every row we test here is
+	// at or left of the block, and has already been moved.  The j block is read from
+	// memory once a frame, and the positions never come from memory twice.
+	//
+	// Nothing about the math changes, only when it happens, so the count is the same.
+	long long collisions = 0;
+
+	for (int column = 0; column < paddedCircles; column += tileColumns){
+		int columnEnd = column + tileColumns < paddedCircles ? column + tileColumns : paddedCircles;
+
+		for (int j = column; j < columnEnd; j += 4){
+			_mm_store_ps(xPosition + j, _mm_add_ps(_mm_load_ps(xPosition + j), _mm_load_ps(xVelocity + j)));
+			_mm_store_ps(yPosition + j, _mm_add_ps(_mm_load_ps(yPosition + j), _mm_load_ps(yVelocity + j)));
+		}
+
+		int lastRow = columnEnd < rowEnd ? columnEnd : rowEnd;
+		for (int rowBlock = rowBegin; rowBlock < lastRow; rowBlock += tileRows){
+			int rowBlockEnd = rowBlock + tileRows < lastRow ? rowBlock + tileRows : lastRow;
+			collisions += CheckTile(rowBlock, rowBlockEnd, column, columnEnd);
+		}
+	}
+
+	return collisions;
+}
+
+long long TiledOptimizedCircles::CheckTile(int rowBegin, int rowEnd, int columnBegin, int columnEnd){
+	long long collisions = 0;
+
+	for (int i = rowBegin; i < rowEnd; ++i){
+		// Rows further down the triangle start further right.  If this whole tile is left
+		// of where row i starts, there's nothing to do for it.
+		int j = i & ~3;
+		if (j >= columnEnd){
+			break;
+		}
+
+		__m128 xPos = _mm_load1_ps(xPosition + i);
+		__m128 yPos = _mm_load1_ps(yPosition + i);
+		__m128 rad = _mm_load1_ps(radius + i);
+
+		if (j >= columnBegin){
+			// The group of 4 that has i in it.  Only the lanes past i count.
+			__m128 xDif = _mm_sub_ps(xPos, _mm_load_ps(xPosition + j));
+			__m128 yDif = _mm_sub_ps(yPos, _mm_load_ps(yPosition + j));
+			__m128 radiusAdd = _mm_add_ps(rad, _mm_load_ps(radius + j));
+
+			int mask = _mm_movemask_ps(
+				_mm_cmplt_ps(
+					_mm_add_ps(_mm_mul_ps(xDif, xDif), _mm_mul_ps(yDif, yDif)),
+					_mm_mul_ps(radiusAdd, radiusAdd)));
+			collisions += bitCount[mask & ((0xF << ((i & 3) + 1)) & 0xF)];
+			j += 4;
+		}
+		else{
+			j = columnBegin;
+		}
+
+		// A true compare is all 1 bits, which as an int is -1.  So subtracting the compare
+		// result counts collisions 4 at a time without ever leaving the SIMD registers.
+		__m128i counts = _mm_setzero_si128();
+		for (; j < columnEnd; j += 4){
+			__m128 xDif = _mm_sub_ps(xPos, _mm_load_ps(xPosition + j));
+			__m128 yDif = _mm_sub_ps(yPos, _mm_load_ps(yPosition + j));
+			__m128 radiusAdd = _mm_add_ps(rad, _mm_load_ps(radius + j));
+
+			__m128 result = _mm_cmplt_ps(
+				_mm_add_ps(_mm_mul_ps(xDif, xDif), _mm_mul_ps(yDif, yDif)),
+				_mm_mul_ps(radiusAdd, radiusAdd));
+
+			counts = _mm_sub_epi32(counts, _mm_castps_si128(result));
+		}
+
+		// Add the 4 lanes together: swap halves and add, then swap neighbours and add.
+		counts = _mm_add_epi32(counts, _mm_shuffle_epi32(counts, _MM_SHUFFLE(1, 0, 3, 2)));
+		counts = _mm_add_epi32(counts, _mm_shuffle_epi32(counts, _MM_SHUFFLE(2, 3, 0, 1)));
+		collisions += _mm_cvtsi128_si32(counts);
+	}
+
+	return collisions;
+}
+
+// Picking the tile size: the j block has to fit in L1 with room to spare, that's
+// TILE_COLUMNS.  The i block can be anything really, its circles only get read once per
+// j block.  Bigger just means the j's get reused more.  But too big and there's not
+// much triangle left to skip on the diagonal, so a few hundred is plenty.
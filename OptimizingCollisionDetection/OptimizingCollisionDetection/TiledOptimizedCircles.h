@@ -0,0 +1,76 @@
+/*
+Title: Optimizing Collision Detection
+File Name: TiledOptimizedCircles.h
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+A version of SIMDOptimizedCircles.cpp that works through the pair matrix in tiles
+sized to stay in cache, for when N is too big for the whole arrays to fit.
+*/
+#pragma once
+#include "Settings.h"
+
+class TiledOptimizedCircles
+{
+public:
+	int numCircles;
+	int paddedCircles;
+	float worldSize;
+
+	float* xPosition;
+	float* xVelocity;
+	float* yPosition;
+	float* yVelocity;
+	float* radius;
+
+	// No matrix here.  At the sizes this class is for, a float matrix would be gigabytes
+	// and writing it would hide everything we're trying to measure.  Just the count.
+	long long collisionCount;
+
+	TiledOptimizedCircles(int numCircles = NUM_CIRCLES, float worldSize = 1000.0f,
+		int tileRows = TILE_ROWS, int tileColumns = TILE_COLUMNS);
+	~TiledOptimizedCircles();
+
+	// Both get rounded up to a multiple of 4.
+	void SetTileSize(int tileRows, int tileColumns);
+	int TileRows();
+	int TileColumns();
+
+	void Update();
+	void CheckForCollisions();
+
+	// Test rows rowBegin up to (not including) rowEnd against everything to their right
+	// and return how many pairs collide.  CheckForCollisions() is just all the rows.
+	// Doing only some of the rows lets the benchmark keep huge N from taking all day.
+	long long CheckRowsTiled(int rowBegin, int rowEnd);
+	long long CheckRowsUntiled(int rowBegin, int rowEnd);
+
+	// Update() and then CheckRowsTiled(rowBegin, rowEnd), fused into one pass over the
+	// arrays.  Every circle moves, not just the rows that get tested.  Same count.
+	void UpdateAndCheckForCollisions();
+	long long UpdateAndCheckRows(int rowBegin, int rowEnd);
+
+private:
+	int tileRows;
+	int tileColumns;
+
+	long long CheckTile(int rowBegin, int rowEnd, int columnBegin, int columnEnd);
+};
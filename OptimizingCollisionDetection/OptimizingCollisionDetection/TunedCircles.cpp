@@ -0,0 +1,119 @@
+/*
+Title: Optimizing Collision Detection
+File Name: TunedCircles.cpp
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+Runs whichever backend and settings the autotuner picked, behind one Update()
+and CheckForCollisions().
+*/
+
+#include "TunedCircles.h"
+#include "Platform.h"
+#include <cstdio>
+
+static const char* backendNames[TunedCircles::BACKEND_COUNT] = { "dispatched", "threaded", "stealing" };
+
+TunedCircles::TunedCircles(const Config& config, int numCircles)
+{
+	this->config = config;
+	dispatched = 0;
+	threaded = 0;
+	stealing = 0;
+
+	switch (config.backend){
+	case BACKEND_THREADED:
+		threaded = new ThreadedOptimizedCircles(config.threads, numCircles);
+		break;
+	case BACKEND_WORK_STEALING:
+		stealing = new WorkStealingCircles(config.threads, config.tileSize, numCircles);
+		break;
+	default:
+		dispatched = new DispatchedCircles(numCircles);
+		dispatched->SelectKernel(config.kernel);
+		break;
+	}
+}
+
+TunedCircles::~TunedCircles()
+{
+	delete dispatched;
+	delete threaded;
+	delete stealing;
+}
+
+// One switch a frame.  Same as DispatchedCircles, it's nothing next to the pairs.
+void TunedCircles::Update(){
+	switch (config.backend){
+	case BACKEND_THREADED:
+		threaded->Update();
+		break;
+	case BACKEND_WORK_STEALING:
+		stealing->Update();
+		break;
+	default:
+		dispatched->Update();
+		break;
+	}
+}
+
+void TunedCircles::CheckForCollisions(){
+	switch (config.backend){
+	case BACKEND_THREADED:
+		threaded->CheckForCollisions();
+		break;
+	case BACKEND_WORK_STEALING:
+		stealing->CheckForCollisions();
+		break;
+	default:
+		dispatched->CheckForCollisions();
+		break;
+	}
+}
+
+int TunedCircles::CountMismatches(){
+	switch (config.backend){
+	case BACKEND_THREADED:
+		return threaded->CountMismatches();
+	case BACKEND_WORK_STEALING:
+		return stealing->CountMismatches();
+	default:
+		return dispatched->CountMismatches();
+	}
+}
+
+const char* TunedCircles::BackendName(Backend backend){
+	return backend >= 0 && backend < BACKEND_COUNT ? backendNames[backend] : "unknown";
+}
+
+void TunedCircles::Describe(const Config& config, char* description, size_t size){
+	switch (config.backend){
+	case BACKEND_THREADED:
+		snprintf(description, size, "%s, %d threads", BackendName(config.backend), config.threads);
+		break;
+	case BACKEND_WORK_STEALING:
+		snprintf(description, size, "%s, %d threads, %d tiles", BackendName(config.backend), config.threads, config.tileSize);
+		break;
+	default:
+		snprintf(description, size, "%s, %s kernel", BackendName(config.backend), DispatchedCircles::KernelName(config.kernel));
+		break;
+	}
+}
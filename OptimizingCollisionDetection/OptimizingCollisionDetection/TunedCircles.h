@@ -0,0 +1,84 @@
+/*
+Title: Optimizing Collision Detection
+File Name: TunedCircles.h
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+Runs whichever backend and settings the autotuner picked, behind one Update()
+and CheckForCollisions().
+*/
+#pragma once
+#include "Settings.h"
+#include "DispatchedCircles.h"
+#include "ThreadedOptimizedCircles.h"
+#include "WorkStealingCircles.h"
+
+class TunedCircles
+{
+public:
+	// Only the classes that give back every colliding pair can take part.  The tiled
+	// kernel only counts collisions, and the earlier tests are all one of these with
+	// less done to them.
+	enum Backend{
+		BACKEND_DISPATCHED,
+		BACKEND_THREADED,
+		BACKEND_WORK_STEALING,
+		BACKEND_COUNT
+	};
+
+	// Everything the autotuner gets to pick.  Settings a backend doesn't use are ignored:
+	// only the dispatched one has a kernel, and only work stealing has a tile size.
+	struct Config{
+		Backend backend;
+		DispatchedCircles::Kernel kernel;
+		int threads;
+		int tileSize;
+
+		// How long one Update() and CheckForCollisions() took when it was tuned.
+		double frameSeconds;
+	};
+
+	Config config;
+
+	TunedCircles(const Config& config, int numCircles = NUM_CIRCLES);
+	~TunedCircles();
+
+	void Update();
+	void CheckForCollisions();
+
+	// Whatever the backend's own CountMismatches() says.  Should always be 0.
+	int CountMismatches();
+
+	// "dispatched", "threaded" or "stealing".
+	static const char* BackendName(Backend backend);
+
+	// Writes something like "stealing, 8 threads, 64 tiles" into description.
+	static void Describe(const Config& config, char* description, size_t size);
+
+private:
+	// Exactly one of these is built, the one config.backend says.
+	DispatchedCircles* dispatched;
+	ThreadedOptimizedCircles* threaded;
+	WorkStealingCircles* stealing;
+
+	TunedCircles(const TunedCircles&);
+	TunedCircles& operator=(const TunedCircles&);
+};
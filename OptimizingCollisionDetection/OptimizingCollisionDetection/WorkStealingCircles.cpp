@@ -0,0 +1,439 @@
+/*
+Title: Optimizing Collision Detection
+File Name: WorkStealingCircles.cpp
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+A version of ContactListCircles.cpp that splits the pair matrix into tiles and
+balances them across threads by letting idle threads steal tiles from busy ones.
+*/
+
+#include "WorkStealingCircles.h"
+#include "Platform.h"
+#include <algorithm>
+#include <chrono>
+#include "HelperFunctions.h"
+
+typedef std::chrono::steady_clock StealClock;
+
+static double SecondsBetween(StealClock::time_point start, StealClock::time_point end){
+	return std::chrono::duration<double>(end - start).count();
+}
+
+WorkStealingCircles::WorkStealingCircles(int numThreads, int tileSize, int numCircles)
+{
+	this->numCircles = numCircles;
+	paddedCircles = Helper::PadCircles(numCircles, 4);
+
+	xPosition = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	xVelocity = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	yPosition = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	yVelocity = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+	radius = (float*)_aligned_malloc(paddedCircles * sizeof(float), 16);
+
+	for (int i = 0; i < numCircles; ++i){
+		xPosition[i] = Helper::RandomFloat(0, 1000.0f);
+		yPosition[i] = Helper::RandomFloat(0, 1000.0f);
+		xVelocity[i] = Helper::RandomFloat(-1.0f, 1.0f);
+		yVelocity[i] = Helper::RandomFloat(-1.0f, 1.0f);
+		radius[i] = Helper::RandomFloat(5.0f, 100.0f);
+	}
+
+	// If the circles are in random order every block covers the whole world, every tile
+	// has to be tested, and every tile costs the same.  Then a static split is already
+	// perfect and there's nothing to steal.  Sorting by x once makes each block a strip of
+	// the world, so tiles far from the diagonal get skipped and the ones near it don't.
+	// That's the kind of lumpy work a real broadphase leaves behind.  Update() keeps them
+	// in order after that.
+	int* order = (int*)malloc(sizeof(int) * numCircles);
+	for (int i = 0; i < numCircles; ++i){
+		order[i] = i;
+	}
+	std::sort(order, order + numCircles, [this](int a, int b){ return xPosition[a] < xPosition[b]; });
+
+	float* sorted = (float*)malloc(sizeof(float) * numCircles);
+	float* arrays[5] = { xPosition, xVelocity, yPosition, yVelocity, radius };
+	for (int a = 0; a < 5; ++a){
+		for (int i = 0; i < numCircles; ++i){
+			sorted[i] = arrays[a][order[i]];
+		}
+		memcpy(arrays[a], sorted, sizeof(float) * numCircles);
+	}
+	free(sorted);
+	free(order);
+
+	// The padding goes on after the sort, and Update() never sorts it, so it stays at the
+	// end where the last tile's final group of 4 runs into it.
+	Helper::FillPadding(xPosition, xVelocity, yPosition, yVelocity, radius, numCircles, paddedCircles);
+
+	this->tileSize = tileSize;
+	stealing = true;
+	pool = 0;
+	workers = 0;
+	tiles = 0;
+	tileOrder = 0;
+	firstTile = 0;
+	blockMinX = 0;
+	blockMaxX = 0;
+	blockMinY = 0;
+	blockMaxY = 0;
+	SetThreadCount(numThreads);
+}
+
+WorkStealingCircles::~WorkStealingCircles()
+{
+	delete pool;
+	delete[] workers;
+	free(tiles);
+	free(tileOrder);
+	free(firstTile);
+	free(blockMinX);
+	free(blockMaxX);
+	free(blockMinY);
+	free(blockMaxY);
+
+	_aligned_free(xPosition);
+	_aligned_free(yPosition);
+	_aligned_free(xVelocity);
+	_aligned_free(yVelocity);
+	_aligned_free(radius);
+}
+
+void WorkStealingCircles::SetThreadCount(int numThreads){
+	delete pool;
+	delete[] workers;
+
+	pool = new ThreadPool(numThreads);
+	workers = new Worker[pool->NumThreads()];
+
+	BuildTiles();
+	ResetStats();
+}
+
+void WorkStealingCircles::SetTileSize(int tileSize){
+	// The SIMD loop goes 4 at a time, so a tile has to as well.
+	this->tileSize = ((tileSize < 4 ? 4 : tileSize) + 3) & ~3;
+
+	BuildTiles();
+	ResetStats();
+}
+
+int WorkStealingCircles::ThreadCount(){
+	return pool->NumThreads();
+}
+
+int WorkStealingCircles::TileSize(){
+	return tileSize;
+}
+
+int WorkStealingCircles::TileCount(){
+	return numTiles;
+}
+
+void WorkStealingCircles::BuildTiles(){
+	free(tiles);
+	free(tileOrder);
+	free(firstTile);
+	free(blockMinX);
+	free(blockMaxX);
+	free(blockMinY);
+	free(blockMaxY);
+
+	numBlocks = (numCircles + tileSize - 1) / tileSize;
+	blockMinX = (float*)malloc(sizeof(float) * numBlocks);
+	blockMaxX = (float*)malloc(sizeof(float) * numBlocks);
+	blockMinY = (float*)malloc(sizeof(float) * numBlocks);
+	blockMaxY = (float*)malloc(sizeof(float) * numBlocks);
+
+	// Only the top right triangle of the pair matrix, same as always, so that's every
+	// tile with colBlock >= rowBlock.
+	numTiles = numBlocks * (numBlocks + 1) / 2;
+	tiles = (Tile*)malloc(sizeof(Tile) * numTiles);
+	tileOrder = (int*)malloc(sizeof(int) * numTiles);
+	int t = 0;
+	for (int row = 0; row < numBlocks; ++row){
+		for (int col = row; col < numBlocks; ++col){
+			tiles[t].rowBlock = row;
+			tiles[t].colBlock = col;
+			tileOrder[t] = t;
+			++t;
+		}
+	}
+
+	// Everyone starts with the same number of tiles, in order.  We have no idea how much
+	// each tile will cost until we run it, and that's fine, that's what stealing is for.
+	int numThreads = pool->NumThreads();
+	firstTile = (int*)malloc(sizeof(int) * (numThreads + 1));
+	for (int w = 0; w <= numThreads; ++w){
+		firstTile[w] = (int)((long long)numTiles * w / numThreads);
+	}
+}
+
+void WorkStealingCircles::ResetStats(){
+	for (int w = 0; w < pool->NumThreads(); ++w){
+		workers[w].tilesRun = 0;
+		workers[w].tilesSkipped = 0;
+		workers[w].steals = 0;
+		workers[w].failedSteals = 0;
+		workers[w].busySeconds = 0.0;
+		workers[w].idleSeconds = 0.0;
+	}
+	frameSeconds = 0.0;
+}
+
+void WorkStealingCircles::Update(){
+	for (int i = 0; i < paddedCircles; i += 4){
+		_mm_store_ps(xPosition + i, _mm_add_ps(_mm_load_ps(xPosition + i), _mm_load_ps(xVelocity + i)));
+		_mm_store_ps(yPosition + i, _mm_add_ps(_mm_load_ps(yPosition + i), _mm_load_ps(yVelocity + i)));
+	}
+
+	// The circles fly apart over a thousand frames, so without this the blocks would slowly
+	// go back to covering the whole world.  Same insertion sort trick as in
+	// SweepAndPruneCircles.cpp: last frame's order is almost right, so this is nearly O(N).
+	// The difference is we move the circles themselves, not a list of indices to them.
+	for (int k = 1; k < numCircles; ++k){
+		float x = xPosition[k];
+		if (xPosition[k - 1] <= x){
+			continue;
+		}
+
+		float xVel = xVelocity[k];
+		float y = yPosition[k];
+		float yVel = yVelocity[k];
+		float rad = radius[k];
+
+		int m = k - 1;
+		while (m >= 0 && xPosition[m] > x){
+			xPosition[m + 1] = xPosition[m];
+			xVelocity[m + 1] = xVelocity[m];
+			yPosition[m + 1] = yPosition[m];
+			yVelocity[m + 1] = yVelocity[m];
+			radius[m + 1] = radius[m];
+			--m;
+		}
+
+		xPosition[m + 1] = x;
+		xVelocity[m + 1] = xVel;
+		yPosition[m + 1] = y;
+		yVelocity[m + 1] = yVel;
+		radius[m + 1] = rad;
+	}
+}
+
+void WorkStealingCircles::ComputeBlockBounds(){
+	// This is our broadphase, and it's about as simple as one gets.  If the boxes around
+	// two blocks don't touch, no circle in one can touch a circle in the other, and the
+	// whole tile can be skipped.
+	for (int b = 0; b < numBlocks; ++b){
+		int start = b * tileSize;
+		int end = std::min(start + tileSize, numCircles);
+
+		float minX = xPosition[start] - radius[start];
+		float maxX = xPosition[start] + radius[start];
+		float minY = yPosition[start] - radius[start];
+		float maxY = yPosition[start] + radius[start];
+		for (int i = start + 1; i < end; ++i){
+			minX = std::min(minX, xPosition[i] - radius[i]);
+			maxX = std::max(maxX, xPosition[i] + radius[i]);
+			minY = std::min(minY, yPosition[i] - radius[i]);
+			maxY = std::max(maxY, yPosition[i] + radius[i]);
+		}
+
+		blockMinX[b] = minX;
+		blockMaxX[b] = maxX;
+		blockMinY[b] = minY;
+		blockMaxY[b] = maxY;
+	}
+}
+
+void WorkStealingCircles::CheckForCollisions(){
+	ComputeBlockBounds();
+
+	int numThreads = pool->NumThreads();
+	for (int w = 0; w < numThreads; ++w){
+		workers[w].head = firstTile[w];
+		workers[w].tail = firstTile[w + 1];
+		workers[w].contacts.Clear();
+	}
+
+	StealClock::time_point start = StealClock::now();
+	pool->Run([this](int worker){ RunWorker(worker); });
+	double elapsed = SecondsBetween(start, StealClock::now());
+
+	// Whatever part of the frame a worker didn't spend running tiles, it spent hunting for
+	// tiles or waiting on everyone else to finish.  Either way it was idle.
+	frameSeconds += elapsed;
+	for (int w = 0; w < numThreads; ++w){
+		workers[w].idleSeconds += elapsed - workers[w].frameBusySeconds;
+	}
+}
+
+bool WorkStealingCircles::TakeTile(int worker, int* tile){
+	Worker& self = workers[worker];
+	{
+		// Our own tiles first, from the back.
+		std::lock_guard<std::mutex> guard(self.lock);
+		if (self.head < self.tail){
+			*tile = tileOrder[--self.tail];
+			return true;
+		}
+	}
+
+	if (!stealing){
+		return false;
+	}
+
+	// Out of our own, so go and take one from the front of someone else's queue.  The owner
+	// works from the back, so the two of us only fight over the lock when there's a single
+	// tile left.  Every tile was handed out before the frame started and nobody makes new
+	// ones, so once every queue is empty there's nothing left anywhere and we can stop.
+	int numThreads = pool->NumThreads();
+	for (int k = 1; k < numThreads; ++k){
+		Worker& victim = workers[(worker + k) % numThreads];
+		std::lock_guard<std::mutex> guard(victim.lock);
+		if (victim.head < victim.tail){
+			*tile = tileOrder[victim.head++];
+			++self.steals;
+			return true;
+		}
+		++self.failedSteals;
+	}
+
+	return false;
+}
+
+void WorkStealingCircles::RunWorker(int worker){
+	Worker& self = workers[worker];
+	double busy = 0.0;
+	int t;
+
+	while (TakeTile(worker, &t)){
+		StealClock::time_point start = StealClock::now();
+
+		const Tile& tile = tiles[t];
+		bool touching = blockMinX[tile.rowBlock] <= blockMaxX[tile.colBlock]
+			&& blockMinX[tile.colBlock] <= blockMaxX[tile.rowBlock]
+			&& blockMinY[tile.rowBlock] <= blockMaxY[tile.colBlock]
+			&& blockMinY[tile.colBlock] <= blockMaxY[tile.rowBlock];
+
+		if (touching){
+			CheckTile(tile, &self.contacts);
+			++self.tilesRun;
+		}
+		else{
+			++self.tilesSkipped;
+		}
+
+		busy += SecondsBetween(start, StealClock::now());
+	}
+
+	self.frameBusySeconds = busy;
+	self.busySeconds += busy;
+}
+
+void WorkStealingCircles::CheckTile(const Tile& tile, ContactList* contacts){
+	// This is ContactListCircles::CheckForCollisions, just on one tile's worth of i and j.
+	// The last column block runs on into the padding, which never collides.
+	int rowEnd = std::min((tile.rowBlock + 1) * tileSize, numCircles);
+	int colStart = tile.colBlock * tileSize;
+	int colEnd = std::min(colStart + tileSize, paddedCircles);
+
+	for (int i = tile.rowBlock * tileSize; i < rowEnd; ++i){
+		__m128 xPos = _mm_load1_ps(xPosition + i);
+		__m128 yPos = _mm_load1_ps(yPosition + i);
+		__m128 rad = _mm_load1_ps(radius + i);
+
+		// Tiles on the diagonal are cut in half like the whole matrix is.  The rest are
+		// entirely above it, so every lane counts.
+		int j = colStart;
+		int validLanes = 0xF;
+		if (tile.rowBlock == tile.colBlock){
+			j = i & ~3;
+			validLanes = (0xF << ((i & 3) + 1)) & 0xF;
+		}
+
+		contacts->Reserve(colEnd - j + 4);
+		ContactPair* out = contacts->pairs + contacts->count;
+
+		for (; j < colEnd; j += 4){
+			__m128 xDif = _mm_sub_ps(xPos, _mm_load_ps(xPosition + j));
+			__m128 yDif = _mm_sub_ps(yPos, _mm_load_ps(yPosition + j));
+			__m128 radiusAdd = _mm_add_ps(rad, _mm_load_ps(radius + j));
+
+			int mask = _mm_movemask_ps(
+				_mm_cmplt_ps(
+					_mm_add_ps(_mm_mul_ps(xDif, xDif), _mm_mul_ps(yDif, yDif)),
+					_mm_mul_ps(radiusAdd, radiusAdd))) & validLanes;
+
+			out->i = i; out->j = j;     out += mask & 1;
+			out->i = i; out->j = j + 1; out += (mask >> 1) & 1;
+			out->i = i; out->j = j + 2; out += (mask >> 2) & 1;
+			out->i = i; out->j = j + 3; out += (mask >> 3) & 1;
+
+			validLanes = 0xF;
+		}
+
+		contacts->count = (int)(out - contacts->pairs);
+	}
+}
+
+int WorkStealingCircles::CountCollisions(){
+	int total = 0;
+	for (int w = 0; w < pool->NumThreads(); ++w){
+		total += workers[w].contacts.count;
+	}
+	return total;
+}
+
+int WorkStealingCircles::CountMismatches(){
+	int mismatches = 0;
+
+	int listed = 0;
+	for (int w = 0; w < pool->NumThreads(); ++w){
+		ContactList& contacts = workers[w].contacts;
+		for (int c = 0; c < contacts.count; ++c){
+			int i = contacts.pairs[c].i;
+			int j = contacts.pairs[c].j;
+			bool expected = i < j && (xPosition[i] - xPosition[j]) * (xPosition[i] - xPosition[j])
+				+ (yPosition[i] - yPosition[j]) * (yPosition[i] - yPosition[j])
+				< (radius[i] + radius[j]) * (radius[i] + radius[j]);
+			mismatches += !expected;
+			listed += expected;
+		}
+	}
+
+	int colliding = 0;
+	for (int i = 0; i < numCircles; ++i){
+		for (int j = i + 1; j < numCircles; ++j){
+			colliding += (xPosition[i] - xPosition[j]) * (xPosition[i] - xPosition[j])
+				+ (yPosition[i] - yPosition[j]) * (yPosition[i] - yPosition[j])
+				< (radius[i] + radius[j]) * (radius[i] + radius[j]);
+		}
+	}
+	mismatches += colliding - listed;
+
+	return mismatches;
+}
+
+// Picking a tile size is a trade.  Small tiles balance better and skip more empty space,
+// but every tile costs a lock, two clock reads and a trip through the bounds test.  Big
+// tiles are cheap to hand out but there are fewer of them to go around at the end of the
+// frame, which is exactly when stealing is supposed to help.  main.cpp prints a few sizes.
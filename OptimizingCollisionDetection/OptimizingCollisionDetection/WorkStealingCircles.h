@@ -0,0 +1,130 @@
+/*
+Title: Optimizing Collision Detection
+File Name: WorkStealingCircles.h
+Copyright  2016
+Original authors: Luna Meier
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Description:
+Splits the collision test into square tiles of the pair matrix and hands them out
+to threads that steal from each other when they run out of their own.
+*/
+#pragma once
+#include "Settings.h"
+#include "ThreadPool.h"
+#include "ContactList.h"
+#include <mutex>
+
+class WorkStealingCircles
+{
+public:
+	float* xPosition;
+	float* xVelocity;
+	float* yPosition;
+	float* yVelocity;
+	float* radius;
+
+	int numCircles;
+	int paddedCircles;
+
+	// Everything one worker owns.  The padding keeps two workers' counters off the same
+	// cache line, see ThreadedOptimizedCircles.cpp for why that matters.
+	struct Worker{
+		std::mutex lock;
+
+		// The tiles still waiting in this worker's queue are tileOrder[head] up to (not
+		// including) tileOrder[tail].  The owner takes from the tail, thieves from the head.
+		int head;
+		int tail;
+
+		// Each worker gets its own list, so nobody has to lock to add a contact.
+		ContactList contacts;
+
+		// Stats.  These add up across frames until ResetStats().
+		int tilesRun;
+		int tilesSkipped;
+		int steals;
+		int failedSteals;
+		double busySeconds;
+		double idleSeconds;
+
+		// Just the last frame's busySeconds, so CheckForCollisions() can work out idle time.
+		double frameBusySeconds;
+
+		char padding[CACHE_LINE_SIZE];
+	};
+	Worker* workers;
+
+	WorkStealingCircles(int numThreads = 1, int tileSize = TILE_SIZE, int numCircles = NUM_CIRCLES);
+	~WorkStealingCircles();
+
+	// Both of these rebuild the tiles and queues.  Not something to call every frame.
+	void SetThreadCount(int numThreads);
+	void SetTileSize(int tileSize);
+	int ThreadCount();
+	int TileSize();
+	int TileCount();
+
+	// With stealing off every worker only runs the tiles it was handed at the start.
+	// That's a plain static split, which is handy to compare against.
+	bool stealing;
+
+	void Update();
+	void CheckForCollisions();
+
+	// Total contacts across every worker's list from the last CheckForCollisions().
+	int CountCollisions();
+
+	// Checks every worker's list against the brute force answer.  Should always be 0.
+	int CountMismatches();
+
+	void ResetStats();
+
+	// Wall time spent in CheckForCollisions() since ResetStats().  Every worker's busy
+	// time plus idle time should come out about equal to this.
+	double frameSeconds;
+
+private:
+	ThreadPool* pool;
+	int tileSize;
+	int numBlocks;
+
+	struct Tile{
+		int rowBlock;
+		int colBlock;
+	};
+	Tile* tiles;
+	int numTiles;
+
+	// Worker w starts each frame owning tileOrder[firstTile[w]] up to firstTile[w + 1].
+	int* tileOrder;
+	int* firstTile;
+
+	// The box around every circle in a block, radius included.
+	float* blockMinX;
+	float* blockMaxX;
+	float* blockMinY;
+	float* blockMaxY;
+
+	void BuildTiles();
+	void ComputeBlockBounds();
+	bool TakeTile(int worker, int* tile);
+	void RunWorker(int worker);
+	void CheckTile(const Tile& tile, ContactList* contacts);
+};
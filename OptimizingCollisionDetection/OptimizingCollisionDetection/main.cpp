@@ -48,7 +48,11 @@ http://www.cs.virginia.edu/~evans/cs216/guides/x86.html
 https://msdn.microsoft.com/en-us/library/t467de55(v=vs.90).aspx
 */
 
-#include <conio.h>
+#include "Platform.h"
+#include <cmath>
+#include <climits>
+#include <chrono>
+#include <vector>
 #include "BasicCircle.h"
 #include "OptimizedCircle.h"
 #include "MoreOptimizedCircle.h"
@@ -57,11 +61,31 @@ https://msdn.microsoft.com/en-us/library/t467de55(v=vs.90).aspx
 #include "SIMDOptimizedCircles.h"
 #include "AssemblyOptimizedCircles.h"
 #include "AVXOptimizedCircles.h"
+#include "AVX512OptimizedCircles.h"
+#include "DispatchedCircles.h"
+#include "GridOptimizedCircles.h"
+#include "SweepAndPruneCircles.h"
+#include "AABBTreeCircles.h"
+#include "ContactListCircles.h"
+#include "ThreadedOptimizedCircles.h"
+#include "WorkStealingCircles.h"
+#include "TiledOptimizedCircles.h"
+#include "SweptCircles.h"
+#include "ContactResolver.h"
+#include "NeighborListCircles.h"
+#include "ContactEventStream.h"
+#include "SleepingCircles.h"
+#include "HierarchicalGridCircles.h"
+#include "QuantizedCircles.h"
+#include "HalfPrecisionCircles.h"
+#include "PrecisionCircles.h"
+#include "Arena.h"
+#include "Autotuner.h"
 #include "HelperFunctions.h"
 #include "Settings.h"
 
 
-int main(){	
+int main(int argc, char* argv[]){	
 
 #pragma region SETUP
 	// The way this example is setup I created a separate class to show off each test.
@@ -75,6 +99,51 @@ int main(){
 	SIMDOptimizedCircles simdOptimizedCircles;
 	AssemblyOptimizedCircles assemblyOptimizedCircles;
 	AVXOptimizedCircles avxOptimizedCircles;
+	AVX512OptimizedCircles avx512OptimizedCircles;
+
+	// DispatchedCircles picks the widest kernel the CPU has on its own.  To force one, set
+	// COLLISION_KERNEL=sse (or scalar, avx2, avx512) in the environment, or pass
+	// --kernel=sse on the command line.  The command line wins if you do both.
+	const char* requestedKernel = getenv("COLLISION_KERNEL");
+	bool retune = false;
+	for (int arg = 1; arg < argc; ++arg){
+		if (strncmp(argv[arg], "--kernel=", 9) == 0){
+			requestedKernel = argv[arg] + 9;
+		}
+		if (strcmp(argv[arg], "--retune") == 0){
+			retune = true;
+		}
+	}
+	DispatchedCircles dispatchedCircles;
+	dispatchedCircles.SelectKernel(DispatchedCircles::ChooseKernel(requestedKernel));
+	GridOptimizedCircles gridOptimizedCircles;
+	SweepAndPruneCircles sweepAndPruneCircles;
+	AABBTreeCircles aabbTreeCircles;
+	ContactListCircles contactListCircles;
+
+	// hardware_concurrency is allowed to return 0 if it can't tell, so don't trust it blindly.
+	int numCores = (int)std::thread::hardware_concurrency();
+	if (numCores < 1){
+		numCores = 1;
+	}
+	ThreadedOptimizedCircles threadedOptimizedCircles(numCores);
+	WorkStealingCircles workStealingCircles(numCores);
+	TiledOptimizedCircles tiledOptimizedCircles;
+
+	// Or don't pick at all.  The autotuner times every backend and setting on this machine
+	// and keeps the fastest.  It saves the answer in autotune.cache, so only the first run
+	// pays for the timing.  Pass --retune (or delete the file) to time everything again.
+	Autotuner autotuner;
+	TunedCircles tunedCircles(autotuner.Tune(retune));
+	char tunedDescription[128];
+	TunedCircles::Describe(tunedCircles.config, tunedDescription, sizeof(tunedDescription));
+	if (autotuner.FromCache()){
+		std::printf("Autotuner: %s, from %s.\n", tunedDescription, AUTOTUNE_CACHE_FILE);
+	}
+	else{
+		std::printf("Autotuner: %s, best of %d candidates, took %.2f seconds.\n", tunedDescription,
+			autotuner.CandidatesTried(), autotuner.TuningSeconds());
+	}
 
 	// This is just setting up a jagged array to store the results in.  In an actual
 	// simulation this would let you resolve collisions after the fact, so I figured it
@@ -225,32 +294,244 @@ int main(){
 	}
 
 	float timeSeven = Helper::StopTimer();
+	int assemblyMismatches = assemblyOptimizedCircles.CountMismatches();
 	std::printf("Test Seven Complete. \n");
 #pragma endregion Test using inline assembly for optimization.
 
+#pragma region PACKED_RESULTS
+	// Tests six and seven again, but writing one bit per pair instead of one float.
+	// Head into SIMDOptimizedCircles.cpp and look at CheckForCollisionsPacked().
+	Helper::StartTimer();
+	for (int test = 0; test < ITERATIONS; ++test){
+		simdOptimizedCircles.Update();
+		simdOptimizedCircles.CheckForCollisionsPacked();
+	}
+	float timeSixPacked = Helper::StopTimer();
+
+	Helper::StartTimer();
+	for (int test = 0; test < ITERATIONS; ++test){
+		assemblyOptimizedCircles.Update();
+		assemblyOptimizedCircles.CheckForCollisionsPacked();
+	}
+	float timeSevenPacked = Helper::StopTimer();
+	std::printf("Packed Tests Complete. \n");
+
+	// Make sure the bits say the same thing as the floats do.
+	simdOptimizedCircles.CheckForCollisions();
+	int packedMismatches = 0;
+	for (int i = 0; i < NUM_CIRCLES; ++i){
+		for (int j = i + 1; j < NUM_CIRCLES; ++j){
+			bool floatResult = simdOptimizedCircles.isCollided[i][j] != 0.0f;
+			bool bitResult = CollisionBits::Get(simdOptimizedCircles.collisionBits, simdOptimizedCircles.wordsPerRow, i, j);
+			packedMismatches += floatResult != bitResult;
+		}
+	}
+
+	// And work out how many bytes of results each version writes per frame.  Both start
+	// each row a little before i (4 floats or 32 bits at a time), so count that too.
+	double floatBytes = 0.0;
+	double packedBytes = 0.0;
+	for (int i = 0; i < NUM_CIRCLES; ++i){
+		floatBytes += (NUM_CIRCLES - (i & ~3)) * sizeof(float);
+		packedBytes += (simdOptimizedCircles.wordsPerRow - (i >> 5)) * sizeof(unsigned int);
+	}
+#pragma endregion Tests writing a packed bit matrix instead of a float per pair.
+
+
+// The following test will not run on processors older than 2013 or so.  It uses AVX2
+// (Advanced Vector Extensions) which is basically SSE with 256 bit registers instead of
+// 128 bit registers.  So yes, 8 floats at a time.  Pretty freaking cool.
+// This used to be commented out because asking for AVX on a machine without it crashes.
+// Now we just ask the CPU first (see Platform.h) and skip the test if it says no.
+	bool hasAVX2 = Platform::SupportsAVX2();
+	bool hasAVX512 = Platform::SupportsAVX512();
+
+#pragma region TEST_EIGHT
+	float timeEight = 0.0f;
+	int avxMismatches = 0;
+	if (hasAVX2){
+		Helper::StartTimer();
+		// Just head into AVXOptimizedCircles.cpp.
+		for (int test = 0; test < ITERATIONS; ++test){
+			avxOptimizedCircles.Update();
+			avxOptimizedCircles.CheckForCollisions();
+		}
+
+		timeEight = Helper::StopTimer();
+		avxMismatches = avxOptimizedCircles.CountMismatches();
+		std::printf("Test Eight Complete. \n");
+	}
+	else{
+		std::printf("Test Eight Skipped, no AVX2. \n");
+	}
+#pragma endregion Test using AVX2 and FMA intrinsics for optimization.
+
+#pragma region TEST_NINE
+	Helper::StartTimer();
+	// Everything before this made each test faster.  This one just does fewer tests.
+	// Head into GridOptimizedCircles.cpp.
+	for (int test = 0; test < ITERATIONS; ++test){
+		gridOptimizedCircles.Update();
+		gridOptimizedCircles.CheckForCollisions();
+	}
+
+	float timeNine = Helper::StopTimer();
+	std::printf("Test Nine Complete. \n");
+
+	// Skipping tests is only fine if we skip the right ones, so make sure we got the
+	// exact same answer the brute force would have.
+	int gridMismatches = gridOptimizedCircles.CountMismatches();
+#pragma endregion Test using a uniform grid broadphase.
+
+#pragma region TEST_TEN
+	Helper::StartTimer();
+	// A different way of doing fewer tests.  Head into SweepAndPruneCircles.cpp.
+	int totalSortSwaps = 0;
+	for (int test = 0; test < ITERATIONS; ++test){
+		sweepAndPruneCircles.Update();
+		sweepAndPruneCircles.CheckForCollisions();
+		totalSortSwaps += sweepAndPruneCircles.lastSortSwaps;
+	}
+
+	float timeTen = Helper::StopTimer();
+	std::printf("Test Ten Complete. \n");
+
+	int sweepAndPruneMismatches = sweepAndPruneCircles.CountMismatches();
+#pragma endregion Test using an incremental sort and sweep broadphase.
+
+#pragma region TEST_ELEVEN
+	// One more broadphase, this one built for circles of very different sizes.
+	// Head into AABBTreeCircles.cpp.  This time Update() and CheckForCollisions() are
+	// timed separately, since keeping the tree up to date is a real cost of its own.
+	float treeUpdateTime = 0.0f;
+	float treeCheckTime = 0.0f;
+	int totalReinsertions = 0;
+	for (int test = 0; test < ITERATIONS; ++test){
+		Helper::StartTimer();
+		aabbTreeCircles.Update();
+		treeUpdateTime += Helper::StopTimer();
+		totalReinsertions += aabbTreeCircles.lastReinsertions;
+
+		Helper::StartTimer();
+		aabbTreeCircles.CheckForCollisions();
+		treeCheckTime += Helper::StopTimer();
+	}
+
+	float timeEleven = treeUpdateTime + treeCheckTime;
+	std::printf("Test Eleven Complete. \n");
+
+	int aabbTreeMismatches = aabbTreeCircles.CountMismatches();
+#pragma endregion Test using a dynamic AABB tree broadphase.
+
+#pragma region TEST_TWELVE
+	Helper::StartTimer();
+	// Back to the SIMD brute force, but this time the output is a list of the pairs that
+	// collide instead of a giant matrix.  Head into ContactListCircles.cpp.
+	for (int test = 0; test < ITERATIONS; ++test){
+		contactListCircles.Update();
+		contactListCircles.CheckForCollisions();
+	}
+
+	float timeTwelve = Helper::StopTimer();
+	std::printf("Test Twelve Complete. \n");
+
+	int contactListMismatches = contactListCircles.CountMismatches();
+#pragma endregion Test writing a list of contacts instead of a matrix.
+
+#pragma region TEST_THIRTEEN
+	Helper::StartWallTimer();
+	// Every test so far has used one core.  Head into ThreadedOptimizedCircles.cpp.
+	for (int test = 0; test < ITERATIONS; ++test){
+		threadedOptimizedCircles.Update();
+		threadedOptimizedCircles.CheckForCollisions();
+	}
+
+	float timeThirteen = Helper::StopWallTimer();
+	std::printf("Test Thirteen Complete. \n");
+#pragma endregion Test splitting the SIMD test across every core.
+
+#pragma region TEST_FOURTEEN
+	Helper::StartWallTimer();
+	// Splitting rows up front only works if you know what each row costs.  Head into
+	// WorkStealingCircles.cpp for what to do when you don't.
+	for (int test = 0; test < ITERATIONS; ++test){
+		workStealingCircles.Update();
+		workStealingCircles.CheckForCollisions();
+	}
+
+	float timeFourteen = Helper::StopWallTimer();
+	std::printf("Test Fourteen Complete. \n");
+#pragma endregion Test stealing tiles of the pair matrix between threads.
+
+#pragma region TEST_FIFTEEN
+	Helper::StartTimer();
+	// Back to one thread.  Head into TiledOptimizedCircles.cpp, and don't expect much
+	// here, this test is mostly for the sweep further down.
+	for (int test = 0; test < ITERATIONS; ++test){
+		tiledOptimizedCircles.Update();
+		tiledOptimizedCircles.CheckForCollisions();
+	}
+
+	float timeFifteen = Helper::StopTimer();
+	std::printf("Test Fifteen Complete. \n");
+#pragma endregion Test the cache blocked SIMD kernel.
+
+#pragma region TEST_SIXTEEN
+	float timeSixteen = 0.0f;
+	float timeSixteenPacked = 0.0f;
+	int avx512Mismatches = 0;
+	if (hasAVX512){
+		Helper::StartTimer();
+		// Twice as wide again.  Head into AVX512OptimizedCircles.cpp.
+		for (int test = 0; test < ITERATIONS; ++test){
+			avx512OptimizedCircles.Update();
+			avx512OptimizedCircles.CheckForCollisions();
+		}
+		timeSixteen = Helper::StopTimer();
+
+		Helper::StartTimer();
+		for (int test = 0; test < ITERATIONS; ++test){
+			avx512OptimizedCircles.Update();
+			avx512OptimizedCircles.CheckForCollisionsPacked();
+		}
+		timeSixteenPacked = Helper::StopTimer();
+
+		// The float matrix is from the frame before the packed one, so bring it up to date.
+		avx512OptimizedCircles.CheckForCollisions();
+		avx512Mismatches = avx512OptimizedCircles.CountMismatches();
+		std::printf("Test Sixteen Complete. \n");
+	}
+	else{
+		std::printf("Test Sixteen Skipped, no AVX-512. \n");
+	}
+#pragma endregion Test using AVX-512 and its mask registers.
+
+#pragma region TEST_SEVENTEEN
+	Helper::StartTimer();
+	// No more commenting tests in and out depending on your CPU.  Head into
+	// DispatchedCircles.cpp.
+	for (int test = 0; test < ITERATIONS; ++test){
+		dispatchedCircles.Update();
+		dispatchedCircles.CheckForCollisions();
+	}
+
+	float timeSeventeen = Helper::StopTimer();
+	int dispatchedMismatches = dispatchedCircles.CountMismatches();
+	std::printf("Test Seventeen Complete. \n");
+#pragma endregion Test picking the kernel at runtime.
+
+#pragma region TEST_EIGHTEEN
+	Helper::StartWallTimer();
+	// Whatever won on this machine.  Head into Autotuner.cpp.
+	for (int test = 0; test < ITERATIONS; ++test){
+		tunedCircles.Update();
+		tunedCircles.CheckForCollisions();
+	}
 
-// The following test will not run on processors older than 2011 for sure.
-// Since the chance of your computer supporting it is <100%, I've commented out the test,
-// and the code in AVXOptimizedCircles.cpp that will prevent your code from running.
-// If you want to test it out go into AVXOptimizedCircles.cpp and uncomment the code in Update()
-// and CheckCollisions().  It uses AVX (Advanced Vector Extensions) which is basically SSE with
-// 256 bit registers instead of 128 bit registers.  So yes, 8 floats at a time.  Pretty freaking cool.
-
-// You also might need to right click your project file Properties->Configuration Properties->C/C++->
-// Code Generation->Enable Enhanced Instruction Set and set to AVX.  Maybe not, I'm not sure how the
-// project file will transfer over github.
-
-//#pragma region TEST_EIGHT
-//	Helper::StartTimer();
-//	// Just head into AVXOptimizedCircles.cpp.
-//	for (int test = 0; test < ITERATIONS; ++test){
-//		avxOptimizedCircles.Update();
-//		avxOptimizedCircles.CheckForCollisions();
-//	}
-//
-//	float timeEight = Helper::StopTimer();
-//	std::printf("Test Eight Complete. \n");
-//#pragma endregion Test using inline assembly with AVX operations for optimization.
+	float timeEighteen = Helper::StopWallTimer();
+	int tunedMismatches = tunedCircles.CountMismatches();
+	std::printf("Test Eighteen Complete. \n");
+#pragma endregion Test the autotuned backend.
 
 	std::printf("\nBasic Circle Code: %f seconds.\n", timeOne); // Supports ~750 circles at 60FPS
 	// 1.00x
@@ -264,12 +545,1059 @@ int main(){
 	// 8.06x (EIGHT TIMES SPEEDUP FOR BASIC OPTIMIZATION PATTERNS)
 	//std::printf("SIMD ops: %f seconds.\n", timeSix); // supports ~3400 circles at 60FPS
 	// 12.0x (You said something about SIMD being too complicated to bother with?)
-	std::printf("Assembly optimized: %f seconds.\n", timeSeven); // supports ~8300 circles at 60FPS
+	std::printf("Assembly optimized: %f seconds. (%s, %d mismatches)\n", timeSeven,
+		assemblyOptimizedCircles.Implementation(), assemblyMismatches); // supports ~8300 circles at 60FPS
 	// 138.83x (Okay even I was surprised at this one.  That's just nuts.)
 
+	std::printf("SIMD ops, packed bits: %f seconds. (%f as floats, %d mismatches)\n",
+		timeSixPacked, timeSix, packedMismatches);
+	std::printf("Assembly optimized, packed bits: %f seconds.\n", timeSevenPacked);
+	std::printf("    results written per frame: %.0f KB as floats, %.0f KB as bits\n",
+		floatBytes / 1024.0, packedBytes / 1024.0);
+
 
-	//std::printf("AVX optimized: %f seconds.\n", timeEight); // supports ~8700 circles at 60FPS
+	if (hasAVX2){
+		std::printf("AVX optimized: %f seconds. (%d mismatches)\n", timeEight, avxMismatches); // supports ~8700 circles at 60FPS
+
+		// On 64 bit Linux test seven is hand written AVX2, and test eight is the compiler's
+		// AVX2 from intrinsics.  Same instructions, same data sizes, so this is us vs it.
+		std::printf("    hand written assembly is %.2fx the speed of the intrinsics\n", timeEight / timeSeven);
+	}
 	// ~256x (Oh look a nice round number.  Turns out doing 8 at a time is better than 4 at a time)
+
+	std::printf("Uniform grid broadphase: %f seconds. (%d mismatches)\n", timeNine, gridMismatches);
+	std::printf("Sort and sweep broadphase: %f seconds. (%d mismatches, %d swaps per frame)\n",
+		timeTen, sweepAndPruneMismatches, totalSortSwaps / ITERATIONS);
+	std::printf("AABB tree broadphase: %f seconds. (%d mismatches)\n", timeEleven, aabbTreeMismatches);
+	std::printf("    update %f seconds, %d reinsertions per frame, height %d\n",
+		treeUpdateTime, totalReinsertions / ITERATIONS, aabbTreeCircles.Height());
+	std::printf("    tree uses %u bytes, grid uses %u bytes\n",
+		(unsigned int)aabbTreeCircles.MemoryUsage(), (unsigned int)gridOptimizedCircles.MemoryUsage());
+	std::printf("SIMD ops, contact list: %f seconds. (%d mismatches)\n", timeTwelve, contactListMismatches);
+	std::printf("    %d contacts in %u bytes, a float matrix would be %u bytes\n",
+		contactListCircles.contacts.count, (unsigned int)contactListCircles.contacts.MemoryUsage(),
+		(unsigned int)(sizeof(float) * NUM_CIRCLES * NUM_CIRCLES));
+	std::printf("SIMD ops on %d threads: %f seconds.\n", numCores, timeThirteen);
+	std::printf("Work stealing tiles on %d threads: %f seconds.\n", numCores, timeFourteen);
+	std::printf("SIMD ops, cache blocked: %f seconds. (%lld collisions, %lld untiled)\n", timeFifteen,
+		tiledOptimizedCircles.collisionCount, tiledOptimizedCircles.CheckRowsUntiled(0, tiledOptimizedCircles.numCircles));
+	if (hasAVX512){
+		std::printf("AVX-512 optimized: %f seconds. (%f packed, %d mismatches)\n", timeSixteen, timeSixteenPacked, avx512Mismatches);
+	}
+
+	// Same work, three widths.  SSE is the SIMDOptimizedCircles test from way back.
+	std::printf("\n%10s %14s %8s %14s %8s\n", "", "floats", "vs SSE", "bits", "vs SSE");
+	std::printf("%10s %13fs %7.2fx %13fs %7.2fx\n", "SSE", timeSix, 1.0f, timeSixPacked, 1.0f);
+	if (hasAVX2){
+		std::printf("%10s %13fs %7.2fx %14s %8s\n", "AVX2", timeEight, timeSix / timeEight, "-", "-");
+	}
+	if (hasAVX512){
+		std::printf("%10s %13fs %7.2fx %13fs %7.2fx\n", "AVX-512", timeSixteen, timeSix / timeSixteen,
+			timeSixteenPacked, timeSixPacked / timeSixteenPacked);
+	}
+
+	std::printf("Runtime dispatch, %s kernel: %f seconds. (%d mismatches)\n",
+		DispatchedCircles::KernelName(dispatchedCircles.SelectedKernel()), timeSeventeen, dispatchedMismatches);
+	std::printf("Autotuned, %s: %f seconds. (%d mismatches, %s)\n", tunedDescription, timeEighteen, tunedMismatches,
+		autotuner.CpuModel());
+
+#pragma region KERNEL_DISPATCH
+	// Every kernel this machine can run, on the same circles.
+	DispatchedCircles::Kernel chosenKernel = dispatchedCircles.SelectedKernel();
+	std::printf("\nKernels on this CPU, best is %s:\n", DispatchedCircles::KernelName(DispatchedCircles::BestKernel()));
+	std::printf("%8s %14s %11s\n", "kernel", "time", "mismatches");
+	for (int k = 0; k < DispatchedCircles::KERNEL_COUNT; ++k){
+		DispatchedCircles::Kernel kernel = (DispatchedCircles::Kernel)k;
+		if (!dispatchedCircles.SelectKernel(kernel)){
+			std::printf("%8s %14s %11s\n", DispatchedCircles::KernelName(kernel), "unsupported", "-");
+			continue;
+		}
+
+		Helper::StartTimer();
+		for (int test = 0; test < ITERATIONS; ++test){
+			dispatchedCircles.Update();
+			dispatchedCircles.CheckForCollisions();
+		}
+		float kernelTime = Helper::StopTimer();
+
+		std::printf("%8s %13fs %11d\n", DispatchedCircles::KernelName(kernel), kernelTime, dispatchedCircles.CountMismatches());
+	}
+	dispatchedCircles.SelectKernel(chosenKernel);
+#pragma endregion Time every kernel the CPU supports.
+
+#pragma region THREAD_SCALING
+	// Strong scaling: same problem, more threads.  Perfect scaling would be N times faster
+	// on N threads.
+	std::printf("\nThread scaling, %d iterations each:\n", ITERATIONS);
+	std::printf("%8s %14s %8s\n", "threads", "time", "speedup");
+	float oneThreadTime = 0.0f;
+	for (int threads = 1; threads <= numCores; ++threads){
+		threadedOptimizedCircles.SetThreadCount(threads);
+
+		Helper::StartWallTimer();
+		for (int test = 0; test < ITERATIONS; ++test){
+			threadedOptimizedCircles.Update();
+			threadedOptimizedCircles.CheckForCollisions();
+		}
+		float threadTime = Helper::StopWallTimer();
+		if (threads == 1){
+			oneThreadTime = threadTime;
+		}
+
+		std::printf("%8d %13fs %7.2fx\n", threads, threadTime, oneThreadTime / threadTime);
+	}
+#pragma endregion Run the threaded test on 1 through all cores.
+
+#pragma region WORK_STEALING
+	std::printf("\nWork stealing on %d threads, %d tiles of %d, %d mismatches\n",
+		workStealingCircles.ThreadCount(), workStealingCircles.TileCount(),
+		workStealingCircles.TileSize(), workStealingCircles.CountMismatches());
+	std::printf("%8s %10s %10s %8s %8s %12s %12s\n", "worker", "tiles", "skipped", "steals", "missed", "busy", "idle");
+	for (int w = 0; w < workStealingCircles.ThreadCount(); ++w){
+		WorkStealingCircles::Worker& worker = workStealingCircles.workers[w];
+		std::printf("%8d %10d %10d %8d %8d %11fs %11fs\n", w, worker.tilesRun, worker.tilesSkipped,
+			worker.steals, worker.failedSteals, worker.busySeconds, worker.idleSeconds);
+	}
+
+	// Same tiles, with and without stealing, at a few tile sizes.  Idle is the average
+	// across workers, as a share of the whole time.  Without stealing that's how long
+	// everyone sat waiting on whoever got the dense tiles.
+	std::printf("\n%8s %8s %14s %8s %14s %8s\n", "tile", "tiles", "static", "idle", "stealing", "idle");
+	const int tileSizes[] = { 16, 32, 64, 128, 256 };
+	const int numTileSizes = sizeof(tileSizes) / sizeof(tileSizes[0]);
+	for (int s = 0; s < numTileSizes; ++s){
+		workStealingCircles.SetTileSize(tileSizes[s]);
+		float tileTimes[2];
+		double idleShare[2];
+
+		for (int mode = 0; mode < 2; ++mode){
+			workStealingCircles.stealing = mode == 1;
+			workStealingCircles.ResetStats();
+
+			Helper::StartWallTimer();
+			for (int test = 0; test < ITERATIONS; ++test){
+				workStealingCircles.Update();
+				workStealingCircles.CheckForCollisions();
+			}
+			tileTimes[mode] = Helper::StopWallTimer();
+
+			double idle = 0.0;
+			for (int w = 0; w < workStealingCircles.ThreadCount(); ++w){
+				idle += workStealingCircles.workers[w].idleSeconds;
+			}
+			idleShare[mode] = idle / (workStealingCircles.ThreadCount() * workStealingCircles.frameSeconds);
+		}
+
+		std::printf("%8d %8d %13fs %7.1f%% %13fs %7.1f%%\n", workStealingCircles.TileSize(),
+			workStealingCircles.TileCount(), tileTimes[0], idleShare[0] * 100.0, tileTimes[1], idleShare[1] * 100.0);
+	}
+#pragma endregion Compare a static split against stealing at different tile sizes.
+
+#pragma region CACHE_SWEEP
+	// At 1000 circles the whole problem is 12KB and lives in L1, so tiling can't help.
+	// Grow N until the arrays are bigger than L1, then L2, then L3, and they have to come
+	// from main memory.  At a few million circles N^2 is far too many pairs to test every
+	// frame, so we only test as many rows as fit in a fixed budget of pairs, and report
+	// the rate.  The rows are the same for both kernels.
+	const int cacheSweepSizes[] = { 1024, 4096, 16384, 65536, 262144, 1048576, 4194304 };
+	const int numCacheSweepSizes = sizeof(cacheSweepSizes) / sizeof(cacheSweepSizes[0]);
+	const double pairBudget = 256.0 * 1024.0 * 1024.0;
+
+	std::printf("\nCache blocked vs not, tiles of %d by %d:\n", TILE_ROWS, TILE_COLUMNS);
+	std::printf("%8s %12s %8s %16s %16s %8s\n", "circles", "working set", "rows", "untiled", "tiled", "speedup");
+	for (int s = 0; s < numCacheSweepSizes; ++s){
+		int n = cacheSweepSizes[s];
+		TiledOptimizedCircles sweepCircles(n, 1000.0f * sqrtf(n / 1000.0f));
+
+		int rows = (int)(pairBudget / n);
+		if (rows > n){
+			rows = n;
+		}
+		double pairs = 0.0;
+		for (int i = 0; i < rows; ++i){
+			pairs += n - (i & ~3);
+		}
+
+		// Run each kernel until it's done about the same number of pairs no matter the N.
+		int repeats = (int)(pairBudget / pairs);
+		if (repeats < 1){
+			repeats = 1;
+		}
+
+		long long untiledCount = 0;
+		Helper::StartTimer();
+		for (int test = 0; test < repeats; ++test){
+			untiledCount = sweepCircles.CheckRowsUntiled(0, rows);
+		}
+		float untiledTime = Helper::StopTimer();
+
+		long long tiledCount = 0;
+		Helper::StartTimer();
+		for (int test = 0; test < repeats; ++test){
+			tiledCount = sweepCircles.CheckRowsTiled(0, rows);
+		}
+		float tiledTime = Helper::StopTimer();
+
+		double million = 1000000.0;
+		std::printf("%8d %10dKB %8d %9.0f Mpair/s %9.0f Mpair/s %7.2fx%s\n", n, (int)(n * 3 * sizeof(float) / 1024), rows,
+			pairs * repeats / untiledTime / million, pairs * repeats / tiledTime / million, untiledTime / tiledTime,
+			untiledCount == tiledCount ? "" : "  counts differ!");
+	}
+#pragma endregion Sweep N past each level of cache.
+
+#pragma region GRID_SWEEP
+	// At 1000 circles the grid doesn't get to show off much.  The brute force is O(N^2)
+	// and the grid is O(N), so let's grow N and watch them cross.  The world grows with N
+	// so the number of circles per cell (and so the work per circle) stays the same.
+	const int sweepSizes[] = { 250, 500, 1000, 2000, 4000, 8000 };
+	const int numSweepSizes = sizeof(sweepSizes) / sizeof(sweepSizes[0]);
+
+	std::printf("\nBroadphases vs brute force, %d iterations each:\n", SWEEP_ITERATIONS);
+	std::printf("%8s %14s %14s %14s %14s\n", "circles", "brute force", "grid", "sort and sweep", "AABB tree");
+	for (int s = 0; s < numSweepSizes; ++s){
+		int n = sweepSizes[s];
+		GridOptimizedCircles sweepCircles(n, 1000.0f * sqrtf(n / 1000.0f));
+
+		Helper::StartTimer();
+		for (int test = 0; test < SWEEP_ITERATIONS; ++test){
+			sweepCircles.Update();
+			sweepCircles.CheckForCollisionsBruteForce();
+		}
+		float bruteTime = Helper::StopTimer();
+
+		Helper::StartTimer();
+		for (int test = 0; test < SWEEP_ITERATIONS; ++test){
+			sweepCircles.Update();
+			sweepCircles.CheckForCollisions();
+		}
+		float gridTime = Helper::StopTimer();
+
+		SweepAndPruneCircles sweepAndPrune(n, 1000.0f * sqrtf(n / 1000.0f));
+		Helper::StartTimer();
+		for (int test = 0; test < SWEEP_ITERATIONS; ++test){
+			sweepAndPrune.Update();
+			sweepAndPrune.CheckForCollisions();
+		}
+		float sweepAndPruneTime = Helper::StopTimer();
+
+		AABBTreeCircles aabbTree(n, 1000.0f * sqrtf(n / 1000.0f));
+		Helper::StartTimer();
+		for (int test = 0; test < SWEEP_ITERATIONS; ++test){
+			aabbTree.Update();
+			aabbTree.CheckForCollisions();
+		}
+		float aabbTreeTime = Helper::StopTimer();
+
+		std::printf("%8d %13fs %13fs %13fs %13fs\n", n, bruteTime, gridTime, sweepAndPruneTime, aabbTreeTime);
+	}
+#pragma endregion Sweep over N to find where the grid starts beating the brute force.
+
+#pragma region ODD_SIZES
+	// Every test above uses NUM_CIRCLES, which is a nice round 1000.  A real game doesn't
+	// get to pick, so here's every SIMD class built at sizes that don't line up with 4, 8
+	// or 16 (and a couple that are too small to fill even one register), run for a few
+	// frames, and checked against the plain C++ answer.  The padding and masks are what
+	// make this work, and if any of them are off by one it shows up here.
+	const int oddSizes[] = { 1, 3, 5, 13, 31, 67, 1003 };
+	const int numOddSizes = sizeof(oddSizes) / sizeof(oddSizes[0]);
+	const int oddFrames = 10;
+
+	std::printf("\nMismatches at sizes that aren't a multiple of the register width:\n");
+	std::printf("%8s %6s %9s %6s %8s %7s %10s %9s %8s\n", "circles", "SIMD", "assembly", "AVX2",
+		"AVX-512", "list", "dispatched", "threaded", "stealing");
+	for (int s = 0; s < numOddSizes; ++s){
+		int n = oddSizes[s];
+
+		SIMDOptimizedCircles simd(n);
+		AssemblyOptimizedCircles assembly(n);
+		ContactListCircles contactList(n);
+		ThreadedOptimizedCircles threaded(numCores, n);
+		WorkStealingCircles stealing(numCores, TILE_SIZE, n);
+		for (int test = 0; test < oddFrames; ++test){
+			simd.Update();
+			simd.CheckForCollisions();
+			simd.CheckForCollisionsPacked();
+			assembly.Update();
+			assembly.CheckForCollisions();
+			contactList.Update();
+			contactList.CheckForCollisions();
+			threaded.Update();
+			threaded.CheckForCollisions();
+			stealing.Update();
+			stealing.CheckForCollisions();
+		}
+
+		// -1 means this CPU can't run it.
+		int avxOdd = -1;
+		if (hasAVX2){
+			AVXOptimizedCircles avx(n);
+			for (int test = 0; test < oddFrames; ++test){
+				avx.Update();
+				avx.CheckForCollisions();
+			}
+			avxOdd = avx.CountMismatches();
+		}
+
+		int avx512Odd = -1;
+		if (hasAVX512){
+			AVX512OptimizedCircles avx512(n);
+			for (int test = 0; test < oddFrames; ++test){
+				avx512.Update();
+				avx512.CheckForCollisions();
+				avx512.CheckForCollisionsPacked();
+			}
+			avx512Odd = avx512.CountMismatches();
+		}
+
+		// Every kernel the CPU has, on the same circles.
+		DispatchedCircles dispatched(n);
+		int dispatchedOdd = 0;
+		for (int k = 0; k < DispatchedCircles::KERNEL_COUNT; ++k){
+			if (dispatched.SelectKernel((DispatchedCircles::Kernel)k)){
+				dispatched.Update();
+				dispatched.CheckForCollisions();
+				dispatchedOdd += dispatched.CountMismatches();
+			}
+		}
+
+		std::printf("%8d %6d %9d %6d %8d %7d %10d %9d %8d\n", n, simd.CountMismatches(), assembly.CountMismatches(),
+			avxOdd, avx512Odd, contactList.CountMismatches(), dispatchedOdd, threaded.CountMismatches(),
+			stealing.CountMismatches());
+	}
+#pragma endregion Check every SIMD class at sizes that are not a multiple of the register width.
+
+#pragma region FIXED_SIZES
+	// DispatchedCircles has copies of its kernels with N baked in at compile time, for a
+	// few sizes (see FixedSizeKernels.h).  Same circles, same kernel, fixed size copy on and
+	// off.  Each size runs about the same number of pairs, so the rates line up.
+	const int fixedSizeList[] = { 64, 256, 1024 };
+	const int numFixedSizes = sizeof(fixedSizeList) / sizeof(fixedSizeList[0]);
+
+	std::printf("\nFixed size kernels vs the runtime N ones:\n");
+	std::printf("%8s %8s %16s %16s %8s %11s\n", "circles", "kernel", "runtime N", "fixed N", "speedup", "mismatches");
+	for (int s = 0; s < numFixedSizes; ++s){
+		int n = fixedSizeList[s];
+		DispatchedCircles fixedCircles(n);
+		int frames = (int)(pairBudget / (n * (double)n / 2.0));
+
+		for (int k = DispatchedCircles::KERNEL_SSE; k < DispatchedCircles::KERNEL_COUNT; ++k){
+			if (!fixedCircles.SelectKernel((DispatchedCircles::Kernel)k) || !fixedCircles.HasFixedSizeKernel()){
+				continue;
+			}
+
+			fixedCircles.fixedSize = false;
+			Helper::StartTimer();
+			for (int test = 0; test < frames; ++test){
+				fixedCircles.Update();
+				fixedCircles.CheckForCollisions();
+			}
+			float runtimeTime = Helper::StopTimer();
+			int mismatches = fixedCircles.CountMismatches();
+
+			fixedCircles.fixedSize = true;
+			Helper::StartTimer();
+			for (int test = 0; test < frames; ++test){
+				fixedCircles.Update();
+				fixedCircles.CheckForCollisions();
+			}
+			float fixedTime = Helper::StopTimer();
+			mismatches += fixedCircles.CountMismatches();
+
+			double pairs = n * (double)n / 2.0 * frames / 1000000.0;
+			std::printf("%8d %8s %9.0f Mpair/s %9.0f Mpair/s %7.2fx %11d\n", n,
+				DispatchedCircles::KernelName((DispatchedCircles::Kernel)k),
+				pairs / runtimeTime, pairs / fixedTime, runtimeTime / fixedTime, mismatches);
+		}
+	}
+#pragma endregion Compare the compile time N kernels against the same kernels with N at runtime.
+
+#pragma region FUSED_SWEEP
+	// Update() and CheckForCollisions() in one pass instead of two.  First at the usual
+	// 1000 circles, on two copies of the same world, to show the results come out the same.
+	SIMDOptimizedCircles twoPassCircles;
+	SIMDOptimizedCircles fusedCircles;
+	Helper::CopyCircles(fusedCircles.xPosition, fusedCircles.xVelocity, fusedCircles.yPosition, fusedCircles.yVelocity, fusedCircles.radius,
+		twoPassCircles.xPosition, twoPassCircles.xVelocity, twoPassCircles.yPosition, twoPassCircles.yVelocity, twoPassCircles.radius, twoPassCircles.paddedCircles);
+
+	Helper::StartTimer();
+	for (int test = 0; test < ITERATIONS; ++test){
+		twoPassCircles.Update();
+		twoPassCircles.CheckForCollisions();
+	}
+	float twoPassTime = Helper::StopTimer();
+
+	Helper::StartTimer();
+	for (int test = 0; test < ITERATIONS; ++test){
+		fusedCircles.UpdateAndCheckForCollisions();
+	}
+	float fusedTime = Helper::StopTimer();
+
+	int fusedDifferences = 0;
+	for (int i = 0; i < NUM_CIRCLES; ++i){
+		fusedDifferences += memcmp(twoPassCircles.isCollided[i], fusedCircles.isCollided[i],
+			sizeof(float) * twoPassCircles.paddedCircles) != 0;
+	}
+	std::printf("\nFused update and check, %d circles: %f seconds, two passes %f seconds. (%d rows differ)\n",
+		NUM_CIRCLES, fusedTime, twoPassTime, fusedDifferences);
+
+	// At 1000 circles everything's in L1 and there's no memory traffic to save.  So grow N
+	// the same way as the cache sweep and count what each version has to bring in from
+	// memory once the arrays don't fit in cache.  Two passes: Update() reads x, y and both
+	// velocities and writes x and y back (24 bytes a circle), then every block of rows
+	// reads x, y and radius for every j (12 bytes).  Fused: the same 24 bytes to move, but
+	// x and y are still in L1 when they're tested, so only the radius comes in (4 bytes),
+	// and each block of j's reads the 12 bytes of every row instead.  These are estimates
+	// from counting, not measurements.  The GB/s columns are each version's own estimate
+	// over its own time, so if fewer bytes don't make it faster, you'll see it there.
+	std::printf("\nFused vs two passes, tiles of %d by %d:\n", TILE_ROWS, TILE_COLUMNS);
+	std::printf("%8s %8s %13s %13s %8s %14s %14s %14s %12s\n", "circles", "rows", "two passes", "fused", "speedup",
+		"two pass MB", "fused MB", "two pass GB/s", "fused GB/s");
+	for (int s = 0; s < numCacheSweepSizes; ++s){
+		int n = cacheSweepSizes[s];
+		TiledOptimizedCircles twoPass(n, 1000.0f * sqrtf(n / 1000.0f));
+		TiledOptimizedCircles fused(n, 1000.0f * sqrtf(n / 1000.0f));
+		Helper::CopyCircles(fused.xPosition, fused.xVelocity, fused.yPosition, fused.yVelocity, fused.radius,
+			twoPass.xPosition, twoPass.xVelocity, twoPass.yPosition, twoPass.yVelocity, twoPass.radius, twoPass.paddedCircles);
+
+		int rows = (int)(pairBudget / n);
+		if (rows > n){
+			rows = n;
+		}
+		double pairs = 0.0;
+		for (int i = 0; i < rows; ++i){
+			pairs += n - (i & ~3);
+		}
+		int repeats = (int)(pairBudget / pairs);
+		if (repeats < 1){
+			repeats = 1;
+		}
+
+		// Both copies take the same steps, so every frame's count has to match.
+		int countsDiffer = 0;
+		long long twoPassCount = 0;
+		Helper::StartTimer();
+		for (int test = 0; test < repeats; ++test){
+			twoPass.Update();
+			twoPassCount += twoPass.CheckRowsTiled(0, rows);
+		}
+		float twoPassSweepTime = Helper::StopTimer();
+
+		long long fusedCount = 0;
+		Helper::StartTimer();
+		for (int test = 0; test < repeats; ++test){
+			fusedCount += fused.UpdateAndCheckRows(0, rows);
+		}
+		float fusedSweepTime = Helper::StopTimer();
+		countsDiffer = twoPassCount != fusedCount;
+
+		double rowBlocks = (rows + TILE_ROWS - 1) / TILE_ROWS;
+		double columnBlocks = (n + TILE_COLUMNS - 1) / TILE_COLUMNS;
+		double twoPassBytes = 24.0 * n + 12.0 * n * rowBlocks;
+		double fusedBytes = 24.0 * n + 4.0 * n + 12.0 * rows * columnBlocks;
+		double megabyte = 1024.0 * 1024.0;
+		std::printf("%8d %8d %12fs %12fs %7.2fx %14.1f %14.1f %14.2f %12.2f%s\n", n, rows, twoPassSweepTime, fusedSweepTime,
+			twoPassSweepTime / fusedSweepTime, twoPassBytes / megabyte, fusedBytes / megabyte,
+			twoPassBytes * repeats / twoPassSweepTime / (1024.0 * megabyte),
+			fusedBytes * repeats / fusedSweepTime / (1024.0 * megabyte),
+			countsDiffer ? "  counts differ!" : "");
+	}
+#pragma endregion Fuse Update and CheckForCollisions into one pass and see what it saves.
+
+#pragma region SWEPT
+	// Fast circles, and a step 4 times as long as usual.  For one step, count the pairs
+	// each approach catches touching: the discrete test at the end of the step, the
+	// discrete test at 4 ticks through it (what you'd have to do to keep the step short),
+	// and the swept test once.  Anything the 4 ticks see, the sweep has to see too.
+	const int sweptSubsteps = 4;
+	SweptCircles sweptCircles(NUM_CIRCLES, 40.0f, (float)sweptSubsteps);
+	sweptCircles.CheckForCollisions();
+
+	int coarseContacts = 0;
+	int fineContacts = 0;
+	int sweptMissed = 0;
+	for (int i = 0; i < NUM_CIRCLES; ++i){
+		for (int j = i + 1; j < NUM_CIRCLES; ++j){
+			bool fine = false;
+			for (int tick = 1; tick <= sweptSubsteps; ++tick){
+				fine = fine || sweptCircles.OverlapsAt(i, j, (float)tick / sweptSubsteps);
+			}
+			fineContacts += fine;
+			coarseContacts += sweptCircles.OverlapsAt(i, j, 1.0f);
+			sweptMissed += fine && sweptCircles.timeOfImpact[i][j] > 1.0f;
+		}
+	}
+	int sweptContacts = sweptCircles.CountImpacts();
+	int sweptMismatches = sweptCircles.CountMismatches();
+
+	// Now the cost of the same stretch of simulated time both ways.
+	Helper::StartTimer();
+	for (int test = 0; test < ITERATIONS / sweptSubsteps; ++test){
+		sweptCircles.CheckForCollisions();
+		sweptCircles.Update();
+	}
+	float sweptTime = Helper::StopTimer();
+
+	Helper::StartTimer();
+	for (int test = 0; test < ITERATIONS; ++test){
+		simdOptimizedCircles.Update();
+		simdOptimizedCircles.CheckForCollisions();
+	}
+	float substepTime = Helper::StopTimer();
+
+	std::printf("\nSwept circles, one step of %d ticks with speeds up to 40:\n", sweptSubsteps);
+	std::printf("    discrete at the end of the step: %d contacts\n", coarseContacts);
+	std::printf("    discrete at every tick:          %d contacts\n", fineContacts);
+	std::printf("    swept:                           %d contacts (%d of the ticks' missed, %d mismatches)\n",
+		sweptContacts, sweptMissed, sweptMismatches);
+	std::printf("    %d ticks of time: swept %f seconds, discrete every tick %f seconds\n",
+		ITERATIONS, sweptTime, substepTime);
+#pragma endregion Sweep fast circles over a long step instead of taking short ones.
+
+#pragma region FULL_FRAME
+	// Detection by itself isn't a frame.  Something has to do something about the
+	// contacts, so here's a whole frame: move, detect, resolve.  First check that the
+	// SIMD resolver and the plain one agree, on two copies of the same world.
+	ContactListCircles simdFrame;
+	ContactListCircles scalarFrame;
+	Helper::CopyCircles(scalarFrame.xPosition, scalarFrame.xVelocity, scalarFrame.yPosition, scalarFrame.yVelocity, scalarFrame.radius,
+		simdFrame.xPosition, simdFrame.xVelocity, simdFrame.yPosition, simdFrame.yVelocity, simdFrame.radius, simdFrame.paddedCircles);
+	ContactResolver resolver;
+
+	simdFrame.CheckForCollisions();
+	scalarFrame.CheckForCollisions();
+	resolver.Resolve(simdFrame.contacts, simdFrame.xPosition, simdFrame.yPosition,
+		simdFrame.xVelocity, simdFrame.yVelocity, simdFrame.radius);
+	resolver.ResolveScalar(scalarFrame.contacts, scalarFrame.xPosition, scalarFrame.yPosition,
+		scalarFrame.xVelocity, scalarFrame.yVelocity, scalarFrame.radius);
+
+	float resolveDifference = 0.0f;
+	for (int i = 0; i < NUM_CIRCLES; ++i){
+		resolveDifference = fmaxf(resolveDifference, fabsf(simdFrame.xPosition[i] - scalarFrame.xPosition[i]));
+		resolveDifference = fmaxf(resolveDifference, fabsf(simdFrame.yPosition[i] - scalarFrame.yPosition[i]));
+		resolveDifference = fmaxf(resolveDifference, fabsf(simdFrame.xVelocity[i] - scalarFrame.xVelocity[i]));
+		resolveDifference = fmaxf(resolveDifference, fabsf(simdFrame.yVelocity[i] - scalarFrame.yVelocity[i]));
+	}
+
+	// Now time whole frames, each stage separately.  The old timer only measures the whole
+	// loop, so this uses the wall clock around each stage.  The world changes as it gets
+	// resolved (circles get pushed apart, so there are fewer contacts every frame), so both
+	// resolvers run the same frames from the same start.
+	typedef std::chrono::steady_clock FrameClock;
+	for (int pass = 0; pass < 2; ++pass){
+		ContactListCircles& frame = pass == 0 ? simdFrame : scalarFrame;
+		double detectSeconds = 0.0;
+		double resolveSeconds = 0.0;
+		long long totalContacts = 0;
+
+		for (int test = 0; test < ITERATIONS; ++test){
+			FrameClock::time_point start = FrameClock::now();
+			frame.Update();
+			frame.CheckForCollisions();
+			FrameClock::time_point detected = FrameClock::now();
+			if (pass == 0){
+				resolver.Resolve(frame.contacts, frame.xPosition, frame.yPosition, frame.xVelocity, frame.yVelocity, frame.radius);
+			}
+			else{
+				resolver.ResolveScalar(frame.contacts, frame.xPosition, frame.yPosition, frame.xVelocity, frame.yVelocity, frame.radius);
+			}
+			FrameClock::time_point resolved = FrameClock::now();
+
+			detectSeconds += std::chrono::duration<double>(detected - start).count();
+			resolveSeconds += std::chrono::duration<double>(resolved - detected).count();
+			totalContacts += frame.contacts.count;
+		}
+
+		if (pass == 0){
+			std::printf("\nFull frames, update + detect + resolve (largest difference from plain C++ %g):\n", resolveDifference);
+		}
+		std::printf("    %s resolver: detect %f seconds, resolve %f seconds (%.0f%% of the frame), %lld contacts a frame\n",
+			pass == 0 ? "SIMD  " : "scalar", detectSeconds, resolveSeconds,
+			100.0 * resolveSeconds / (detectSeconds + resolveSeconds), totalContacts / ITERATIONS);
+	}
+#pragma endregion Resolve the contacts as part of a full frame.
+
+#pragma region NEIGHBOR_LIST
+	// Circles only move about 1 a frame, but every frame the contact list test goes
+	// through the whole triangle to find out which ones are close.  A neighbor list only
+	// does that now and then, and tests its short list the rest of the time.  Every
+	// neighbor list starts from a copy of where the contact list started, so they all run
+	// the same world and end up with the same contacts, a few different skins.
+	const float skins[] = { 5.0f, 10.0f, 20.0f, 40.0f, 80.0f };
+	const int numSkins = sizeof(skins) / sizeof(skins[0]);
+
+	ContactListCircles everyFrame;
+	ContactListCircles neighborStart;
+	Helper::CopyCircles(neighborStart.xPosition, neighborStart.xVelocity, neighborStart.yPosition, neighborStart.yVelocity,
+		neighborStart.radius, everyFrame.xPosition, everyFrame.xVelocity, everyFrame.yPosition, everyFrame.yVelocity,
+		everyFrame.radius, everyFrame.paddedCircles);
+
+	Helper::StartTimer();
+	for (int test = 0; test < ITERATIONS; ++test){
+		everyFrame.Update();
+		everyFrame.CheckForCollisions();
+	}
+	float everyFrameTime = Helper::StopTimer();
+
+	std::printf("\nNeighbor lists vs the whole triangle every frame (%f seconds, %d contacts):\n",
+		everyFrameTime, everyFrame.contacts.count);
+	std::printf("%6s %13s %8s %9s %10s %9s %11s\n", "skin", "time", "speedup", "rebuilds", "list", "contacts", "mismatches");
+	for (int s = 0; s < numSkins; ++s){
+		NeighborListCircles neighborList(NUM_CIRCLES, skins[s]);
+		Helper::CopyCircles(neighborList.xPosition, neighborList.xVelocity, neighborList.yPosition, neighborList.yVelocity,
+			neighborList.radius, neighborStart.xPosition, neighborStart.xVelocity, neighborStart.yPosition,
+			neighborStart.yVelocity, neighborStart.radius, NUM_CIRCLES);
+
+		// The list it built in the constructor was for its own circles.  SetSkin rebuilds
+		// it for the ones we just copied in.
+		neighborList.SetSkin(skins[s]);
+		neighborList.rebuilds = 0;
+
+		Helper::StartTimer();
+		for (int test = 0; test < ITERATIONS; ++test){
+			neighborList.Update();
+			neighborList.CheckForCollisions();
+		}
+		float neighborTime = Helper::StopTimer();
+
+		std::printf("%6.0f %12fs %7.2fx %9d %10d %9d %11d\n", skins[s], neighborTime, everyFrameTime / neighborTime,
+			neighborList.rebuilds, neighborList.neighbors.count, neighborList.contacts.count, neighborList.CountMismatches());
+	}
+#pragma endregion Keep a list of nearby pairs and only rebuild it when something moves too far.
+
+#pragma region CONTACT_EVENTS
+	// Most things that care about contacts only care when one starts or stops: a sound
+	// plays, a trigger fires, a score goes up.  ContactEventStream diffs the packed bits
+	// from one frame to the next and hands over just those.  To check it, keep our own
+	// copy of the contacts built only from the events, and at the end it has to match
+	// the bits exactly.
+	SIMDOptimizedCircles eventCircles;
+	ContactEventStream eventStream;
+	std::vector<char> fromEvents(NUM_CIRCLES * NUM_CIRCLES, 0);
+	long long totalBegan = 0;
+	long long totalEnded = 0;
+	long long totalContacts = 0;
+
+	Helper::StartTimer();
+	for (int test = 0; test < ITERATIONS; ++test){
+		eventCircles.Update();
+		eventCircles.CheckForCollisionsPacked();
+	}
+	float packedOnlyTime = Helper::StopTimer();
+
+	Helper::StartTimer();
+	for (int test = 0; test < ITERATIONS; ++test){
+		eventCircles.Update();
+		eventCircles.CheckForCollisionsPacked();
+		eventStream.Update(eventCircles.collisionBits);
+
+		// Skip the first frame in the totals: it's every contact beginning at once.
+		if (test > 0){
+			totalBegan += eventStream.began;
+			totalEnded += eventStream.ended;
+			totalContacts += eventStream.Contacts();
+		}
+		for (int e = 0; e < eventStream.count; ++e){
+			fromEvents[eventStream.events[e].i * NUM_CIRCLES + eventStream.events[e].j] =
+				eventStream.events[e].type != ContactEventStream::CONTACT_END;
+		}
+	}
+	float eventsTime = Helper::StopTimer();
+
+	int eventMismatches = 0;
+	for (int i = 0; i < NUM_CIRCLES; ++i){
+		for (int j = i + 1; j < NUM_CIRCLES; ++j){
+			eventMismatches += (fromEvents[i * NUM_CIRCLES + j] != 0) !=
+				CollisionBits::Get(eventCircles.collisionBits, eventCircles.wordsPerRow, i, j);
+		}
+	}
+
+	std::printf("\nContact events: %.1f began and %.1f ended a frame, out of %.0f contacts (%d mismatches)\n",
+		(double)totalBegan / (ITERATIONS - 1), (double)totalEnded / (ITERATIONS - 1),
+		(double)totalContacts / (ITERATIONS - 1), eventMismatches);
+	std::printf("    packed kernel %f seconds, with the diff %f seconds\n", packedOnlyTime, eventsTime);
+#pragma endregion Turn each frame into the contacts that began and ended.
+
+#pragma region SLEEPING
+	// A tenth of these circles are walls that never move, and most of the rest start out
+	// sitting still.  SleepingCircles puts the still ones to sleep and only tests pairs
+	// with something awake in them.  The same world with sleeping turned off is the one
+	// to beat.  Anything a moving circle touches wakes up, and this world is crowded
+	// (every circle touches a couple dozen others), so how much stays asleep depends a
+	// lot on how few circles are moving.
+	//
+	// Both passes have to be the same world, or the one with fewer circles touching wins
+	// for free.  So build one world for each row and copy it into both passes.
+	const float restingFractions[] = { 0.7f, 0.9f, 0.98f };
+	const int numRestingFractions = sizeof(restingFractions) / sizeof(restingFractions[0]);
+
+	std::printf("\nSleeping and static circles (10%% static):\n");
+	std::printf("%8s %6s %13s %8s %11s %9s %11s\n", "resting", "sleep", "time", "speedup", "avg awake", "contacts", "mismatches");
+	for (int r = 0; r < numRestingFractions; ++r){
+		float alwaysAwakeTime = 0.0f;
+		SleepingCircles sleepingStart(NUM_CIRCLES, restingFractions[r], 0.1f);
+		for (int pass = 0; pass < 2; ++pass){
+			SleepingCircles sleeping(NUM_CIRCLES, restingFractions[r], 0.1f);
+			sleeping.CopyFrom(sleepingStart);
+			sleeping.allowSleep = pass == 1;
+			long long totalAwake = 0;
+
+			Helper::StartTimer();
+			for (int test = 0; test < ITERATIONS; ++test){
+				sleeping.Update();
+				sleeping.CheckForCollisions();
+				totalAwake += sleeping.numAwake;
+			}
+			float sleepingTime = Helper::StopTimer();
+			if (pass == 0){
+				alwaysAwakeTime = sleepingTime;
+			}
+
+			std::printf("%7.0f%% %6s %12fs %7.2fx %11.0f %9d %11d\n", 100.0f * restingFractions[r],
+				pass == 1 ? "on" : "off", sleepingTime, alwaysAwakeTime / sleepingTime,
+				(double)totalAwake / ITERATIONS, sleeping.contacts.count, sleeping.CountMismatches());
+		}
+	}
+#pragma endregion Skip circles that are asleep or never move.
+
+#pragma region HIERARCHICAL_GRID
+	// One grid has to pick one cell size, and with sizes this spread out any choice is bad
+	// for somebody.  HierarchicalGridCircles gives each size its own level.  Running it
+	// with one level is the single grid with the exact same SIMD test, so the difference
+	// is all down to the levels.  Same size world as the grid sweep at 4000 circles, and
+	// the same circles for both, copied from one world.
+	const float radiusRanges[][2] = { { 5.0f, 100.0f }, { 1.0f, 100.0f }, { 1.0f, 400.0f } };
+	const int numRadiusRanges = sizeof(radiusRanges) / sizeof(radiusRanges[0]);
+	const int hierarchyCircles = 4000;
+	const float hierarchyWorld = 1000.0f * sqrtf(hierarchyCircles / 1000.0f);
+
+	std::printf("\nHierarchical grid vs one grid, %d circles, %d iterations each:\n", hierarchyCircles, SWEEP_ITERATIONS);
+	std::printf("%11s %7s %13s %8s %13s %9s %11s\n", "radii", "levels", "time", "speedup", "pairs tested", "contacts", "mismatches");
+	for (int r = 0; r < numRadiusRanges; ++r){
+		float oneLevelTime = 0.0f;
+		HierarchicalGridCircles hierarchyWorldState(hierarchyCircles, hierarchyWorld, radiusRanges[r][0], radiusRanges[r][1]);
+		for (int pass = 0; pass < 2; ++pass){
+			HierarchicalGridCircles hierarchy(hierarchyWorldState, pass == 0 ? 1 : 8);
+
+			Helper::StartTimer();
+			for (int test = 0; test < SWEEP_ITERATIONS; ++test){
+				hierarchy.Update();
+				hierarchy.CheckForCollisions();
+			}
+			float hierarchyTime = Helper::StopTimer();
+			if (pass == 0){
+				oneLevelTime = hierarchyTime;
+			}
+
+			std::printf("%5.0f-%-5.0f %7d %12fs %7.2fx %13lld %9d %11d\n", radiusRanges[r][0], radiusRanges[r][1],
+				hierarchy.numLevels, hierarchyTime, oneLevelTime / hierarchyTime, hierarchy.pairsTested,
+				hierarchy.contacts.count, hierarchy.CountMismatches());
+		}
+	}
+#pragma endregion Give every size of circle a grid of its own.
+
+#pragma region QUANTIZED
+	// Same circles as a ContactListCircles (copied over, then quantized), so both lists
+	// should come out exactly the same.  The quantized one tests in 16 bit integers and
+	// only does the float test on the pairs that pass.  It runs twice, once with the
+	// 4 pair SSE madd and once with the 8 pair AVX2 one, when the CPU has it.
+	ContactListCircles floatList;
+	QuantizedCircles quantized[2];
+	bool quantizedHasAVX2 = Platform::SupportsAVX2();
+	for (int isa = 0; isa < 2; ++isa){
+		Helper::CopyCircles(quantized[isa].xPosition, quantized[isa].xVelocity, quantized[isa].yPosition, quantized[isa].yVelocity, quantized[isa].radius,
+			floatList.xPosition, floatList.xVelocity, floatList.yPosition, floatList.yVelocity, floatList.radius, floatList.paddedCircles);
+		quantized[isa].Quantize();
+		quantized[isa].useAVX2 = isa == 1;
+	}
+
+	Helper::StartTimer();
+	for (int test = 0; test < ITERATIONS; ++test){
+		floatList.Update();
+		floatList.CheckForCollisions();
+	}
+	float floatListTime = Helper::StopTimer();
+
+	std::printf("\n16 bit quantized test vs float contact list:\n");
+	std::printf("    float:          %f seconds, %d contacts\n", floatListTime, floatList.contacts.count);
+	for (int isa = 0; isa < (quantizedHasAVX2 ? 2 : 1); ++isa){
+		long long totalCandidates = 0;
+		long long totalQuantizedContacts = 0;
+		Helper::StartTimer();
+		for (int test = 0; test < ITERATIONS; ++test){
+			quantized[isa].Update();
+			quantized[isa].CheckForCollisions();
+			totalCandidates += quantized[isa].candidates;
+			totalQuantizedContacts += quantized[isa].contacts.count;
+		}
+		float quantizedTime = Helper::StopTimer();
+
+		int sameContacts = floatList.contacts.count == quantized[isa].contacts.count;
+		for (int c = 0; sameContacts && c < floatList.contacts.count; ++c){
+			sameContacts = floatList.contacts.pairs[c].i == quantized[isa].contacts.pairs[c].i
+				&& floatList.contacts.pairs[c].j == quantized[isa].contacts.pairs[c].j;
+		}
+
+		std::printf("    quantized %4s: %f seconds (%.2fx), %d contacts, step %f units, %d mismatches, same list: %s\n",
+			isa == 1 ? "AVX2" : "SSE", quantizedTime, floatListTime / quantizedTime, quantized[isa].contacts.count,
+			1.0f / quantized[isa].scale, quantized[isa].CountMismatches(), sameContacts ? "yes" : "no");
+		std::printf("        %.1f candidates a frame for %.1f contacts, %.2f%% thrown back by the float test\n",
+			(double)totalCandidates / ITERATIONS, (double)totalQuantizedContacts / ITERATIONS,
+			100.0 * (totalCandidates - totalQuantizedContacts) / (totalCandidates ? totalCandidates : 1));
+	}
+#pragma endregion Test in 16 bit integers and only check the hits in floats.
+
+#pragma region HALF_PRECISION
+	// Half precision storage halves what the kernel loads, but it rounds the positions.
+	// First how much time that saves, with the world growing with N like the grid sweep,
+	// then how wrong it gets as the world gets bigger, so you can pick a cutoff.
+	if (HalfPrecisionCircles::Supported()){
+		const int halfSizes[] = { 1000, 4000, 8000 };
+		const int numHalfSizes = sizeof(halfSizes) / sizeof(halfSizes[0]);
+
+		std::printf("\nHalf precision storage vs floats, %d iterations each:\n", SWEEP_ITERATIONS);
+		std::printf("%8s %13s %13s %8s\n", "circles", "float", "half", "speedup");
+		for (int s = 0; s < numHalfSizes; ++s){
+			HalfPrecisionCircles halfCircles(halfSizes[s], 1000.0f * sqrtf(halfSizes[s] / 1000.0f));
+			float halfTimes[2];
+			for (int pass = 0; pass < 2; ++pass){
+				halfCircles.halfStorage = pass == 1;
+				Helper::StartTimer();
+				for (int test = 0; test < SWEEP_ITERATIONS; ++test){
+					halfCircles.Update();
+					halfCircles.CheckForCollisions();
+				}
+				halfTimes[pass] = Helper::StopTimer();
+			}
+			std::printf("%8d %12fs %12fs %7.2fx\n", halfSizes[s], halfTimes[0], halfTimes[1], halfTimes[0] / halfTimes[1]);
+		}
+
+		// Same number of circles, same sizes, just spread over bigger and bigger worlds.
+		// Errors are added up over every frame.
+		const float halfWorlds[] = { 1000.0f, 4000.0f, 16000.0f, 60000.0f, 100000.0f };
+		const int numHalfWorlds = sizeof(halfWorlds) / sizeof(halfWorlds[0]);
+
+		std::printf("\nHalf precision error against floats, %d circles, %d frames each:\n", NUM_CIRCLES, SWEEP_ITERATIONS);
+		std::printf("%10s %13s %10s %15s %15s\n", "world", "worst round", "contacts", "false positive", "false negative");
+		for (int w = 0; w < numHalfWorlds; ++w){
+			HalfPrecisionCircles halfCircles(NUM_CIRCLES, halfWorlds[w]);
+			long long totalHalfContacts = 0;
+			long long totalFalsePositives = 0;
+			long long totalFalseNegatives = 0;
+			float worstRounding = 0.0f;
+			for (int test = 0; test < SWEEP_ITERATIONS; ++test){
+				halfCircles.Update();
+				halfCircles.CheckForCollisions();
+
+				int falsePositives, falseNegatives;
+				halfCircles.CountErrors(falsePositives, falseNegatives);
+				totalFalsePositives += falsePositives;
+				totalFalseNegatives += falseNegatives;
+				totalHalfContacts += halfCircles.contacts.count - falsePositives + falseNegatives;
+
+				float rounding = halfCircles.MaxRoundingError();
+				worstRounding = rounding > worstRounding ? rounding : worstRounding;
+			}
+			std::printf("%10.0f %13f %10lld %15lld %15lld\n", halfWorlds[w], worstRounding,
+				totalHalfContacts, totalFalsePositives, totalFalseNegatives);
+		}
+	}
+	else {
+		std::printf("\nThis CPU doesn't have F16C, so no half precision test.\n");
+	}
+#pragma endregion Store positions as half precision floats and see what it costs.
+
+#pragma region DOUBLE_PRECISION
+	// What do doubles cost?  The same circles in floats and doubles, with SSE and with
+	// AVX.  Doubles get half the lanes, so you'd expect half the speed, but this loop
+	// writes one contact slot per pair whichever it is, and that's most of its time.
+	// A kernel that only counted or wrote bits would feel the lanes a lot more.
+	//
+	// The two are close enough that how they're timed matters more than the lanes do.
+	// Whichever runs first pays for faulting in its pages and growing its contact list,
+	// so each gets one frame up front that isn't counted, like Autotuner::Benchmark.  Then
+	// the frames are split into batches, taking turns on which goes first, and the best
+	// batch of each is the one that wasn't interrupted by something else on the machine.
+	// Each batch is only a few milliseconds, too short for clock(), so this is wall time.
+	// Even timed this way, SSE doubles can come out level with floats or a little ahead,
+	// because with 2 lanes or 4 the loop is still writing a contact slot for every pair.
+	const int precisionSizes[] = { 1000, 4000 };
+	const int numPrecisionSizes = sizeof(precisionSizes) / sizeof(precisionSizes[0]);
+	const int precisionBatches = 5;
+	const int precisionFrames = SWEEP_ITERATIONS / precisionBatches;
+	bool precisionHasAVX = Platform::SupportsAVX2();
+
+	std::printf("\nFloats vs doubles, best of %d batches of %d frames, time per frame:\n", precisionBatches, precisionFrames);
+	std::printf("%8s %6s %13s %13s %10s\n", "circles", "isa", "float", "double", "slowdown");
+	for (int s = 0; s < numPrecisionSizes; ++s){
+		PrecisionCircles<double> doubleCircles(precisionSizes[s]);
+		PrecisionCircles<float> floatCircles(precisionSizes[s]);
+		for (int isa = 0; isa < (precisionHasAVX ? 2 : 1); ++isa){
+			floatCircles.CopyFrom(doubleCircles);
+			floatCircles.useAVX = isa == 1;
+			doubleCircles.useAVX = isa == 1;
+
+			floatCircles.Update();
+			floatCircles.CheckForCollisions();
+			doubleCircles.Update();
+			doubleCircles.CheckForCollisions();
+
+			float floatTime = 0.0f;
+			float doubleTime = 0.0f;
+			for (int batch = 0; batch < precisionBatches; ++batch){
+				for (int turn = 0; turn < 2; ++turn){
+					bool doublesNow = (turn == 0) == (batch % 2 == 1);
+
+					Helper::StartWallTimer();
+					for (int test = 0; test < precisionFrames; ++test){
+						if (doublesNow){
+							doubleCircles.Update();
+							doubleCircles.CheckForCollisions();
+						}
+						else {
+							floatCircles.Update();
+							floatCircles.CheckForCollisions();
+						}
+					}
+					float batchTime = Helper::StopWallTimer() / precisionFrames;
+
+					float& bestTime = doublesNow ? doubleTime : floatTime;
+					if (batch == 0 || batchTime < bestTime){
+						bestTime = batchTime;
+					}
+				}
+			}
+
+			std::printf("%8d %6s %12fs %12fs %9.2fx\n", precisionSizes[s], isa == 1 ? "AVX" : "SSE",
+				floatTime, doubleTime, doubleTime / floatTime);
+		}
+	}
+
+	// And what do floats cost?  Start a double world at each distance from the origin,
+	// copy it into floats, run both, and count the pairs where the two lists disagree.
+	// The doubles are the right answer here.
+	const double precisionOrigins[] = { 0.0, 1.0e5, 1.0e6, 1.0e7 };
+	const int numPrecisionOrigins = sizeof(precisionOrigins) / sizeof(precisionOrigins[0]);
+
+	std::printf("\nFloats vs doubles far from the origin, %d circles, %d frames each:\n", NUM_CIRCLES, SWEEP_ITERATIONS);
+	std::printf("%10s %14s %16s %17s %11s\n", "origin", "worst drift", "contacts/frame", "disagree/frame", "mismatches");
+	for (int o = 0; o < numPrecisionOrigins; ++o){
+		PrecisionCircles<double> doubleWorld(NUM_CIRCLES, precisionOrigins[o]);
+		PrecisionCircles<float> floatWorld(NUM_CIRCLES);
+		floatWorld.CopyFrom(doubleWorld);
+
+		long long totalDisagree = 0;
+		long long totalDoubleContacts = 0;
+		for (int test = 0; test < SWEEP_ITERATIONS; ++test){
+			floatWorld.Update();
+			floatWorld.CheckForCollisions();
+			doubleWorld.Update();
+			doubleWorld.CheckForCollisions();
+			totalDoubleContacts += doubleWorld.contacts.count;
+
+			// Both lists are in the same order, i then j, so walk them side by side.
+			int f = 0, d = 0;
+			while (f < floatWorld.contacts.count || d < doubleWorld.contacts.count){
+				long long floatKey = f < floatWorld.contacts.count ?
+					(long long)floatWorld.contacts.pairs[f].i * NUM_CIRCLES + floatWorld.contacts.pairs[f].j : LLONG_MAX;
+				long long doubleKey = d < doubleWorld.contacts.count ?
+					(long long)doubleWorld.contacts.pairs[d].i * NUM_CIRCLES + doubleWorld.contacts.pairs[d].j : LLONG_MAX;
+				totalDisagree += floatKey != doubleKey;
+				f += floatKey <= doubleKey;
+				d += doubleKey <= floatKey;
+			}
+		}
+
+		double worstDrift = 0.0;
+		for (int i = 0; i < NUM_CIRCLES; ++i){
+			double drift = fabs((double)floatWorld.xPosition[i] - doubleWorld.xPosition[i]);
+			worstDrift = drift > worstDrift ? drift : worstDrift;
+		}
+
+		std::printf("%10.0e %14f %16.1f %17.1f %11d\n", precisionOrigins[o], worstDrift,
+			(double)totalDoubleContacts / SWEEP_ITERATIONS, (double)totalDisagree / SWEEP_ITERATIONS,
+			doubleWorld.CountMismatches() + floatWorld.CountMismatches());
+	}
+#pragma endregion See what doubles cost and what floats get wrong far from the origin.
+
+#pragma region ARENA
+	// How much does building a world cost?  First the way SIMDOptimizedCircles used to
+	// do it, one allocation per array and per row, then the arena it has now, then one
+	// arena shared by every world and Reset() in between, so nothing goes back to the OS
+	// at all.  Each world is filled in and zeroed the same way every time, so the
+	// difference is all allocation.  This is wall time, since most of it is in the OS.
+	const int arenaBuilds = 200;
+	int separateRows = NUM_CIRCLES;
+	int separatePadded = Helper::PadCircles(NUM_CIRCLES, 4);
+
+	std::chrono::steady_clock::time_point arenaStart = std::chrono::steady_clock::now();
+	for (int build = 0; build < arenaBuilds; ++build){
+		float* separateArrays[5];
+		for (int a = 0; a < 5; ++a){
+			separateArrays[a] = (float*)_aligned_malloc(separatePadded * sizeof(float), 16);
+			memset(separateArrays[a], 0, separatePadded * sizeof(float));
+		}
+		float** separateCollided = (float**)malloc(sizeof(float*) * separateRows);
+		for (int i = 0; i < separateRows; ++i){
+			separateCollided[i] = (float*)_aligned_malloc(sizeof(float) * separatePadded, 32);
+			memset(separateCollided[i], 0, sizeof(float) * separatePadded);
+		}
+		for (int i = 0; i < separateRows; ++i){
+			_aligned_free(separateCollided[i]);
+		}
+		free(separateCollided);
+		for (int a = 0; a < 5; ++a){
+			_aligned_free(separateArrays[a]);
+		}
+	}
+	double separateSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - arenaStart).count();
+
+	arenaStart = std::chrono::steady_clock::now();
+	for (int build = 0; build < arenaBuilds; ++build){
+		SIMDOptimizedCircles ownArenaWorld;
+	}
+	double ownArenaSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - arenaStart).count();
+
+	double sharedSeconds[2];
+	float sharedKernelTime[2];
+	bool askedForHugePages = false;
+	size_t hugePageBytes = 0;
+	for (int huge = 0; huge < 2; ++huge){
+		Arena sharedArena(SIMDOptimizedCircles::MemoryNeeded(NUM_CIRCLES), huge == 1);
+		askedForHugePages |= huge == 1 && sharedArena.HugePages();
+
+		arenaStart = std::chrono::steady_clock::now();
+		for (int build = 0; build < arenaBuilds; ++build){
+			SIMDOptimizedCircles sharedWorld(NUM_CIRCLES, &sharedArena);
+			sharedArena.Reset();
+		}
+		sharedSeconds[huge] = std::chrono::duration<double>(std::chrono::steady_clock::now() - arenaStart).count();
+
+		// And whether the pages make any difference to the kernel itself.
+		SIMDOptimizedCircles kernelWorld(NUM_CIRCLES, &sharedArena);
+		Helper::StartTimer();
+		for (int test = 0; test < ITERATIONS; ++test){
+			kernelWorld.Update();
+			kernelWorld.CheckForCollisions();
+		}
+		sharedKernelTime[huge] = Helper::StopTimer();
+
+		// The OS saying yes to huge pages isn't the same as getting them, so look at what
+		// actually backs the block now that the kernel has touched all of it.
+		if (huge == 1){
+			hugePageBytes = sharedArena.HugePageBytes();
+		}
+	}
+
+	std::printf("\nBuilding and tearing down %d worlds of %d circles (%.1f MB each):\n", arenaBuilds, NUM_CIRCLES,
+		SIMDOptimizedCircles::MemoryNeeded(NUM_CIRCLES) / (1024.0 * 1024.0));
+	std::printf("    %d separate allocations each:    %f seconds\n", separateRows + 6, separateSeconds);
+	std::printf("    one arena each:                   %f seconds\n", ownArenaSeconds);
+	std::printf("    one arena, Reset() in between:    %f seconds\n", sharedSeconds[0]);
+	std::printf("    same, asking for huge pages:      %f seconds (%s, %.1f MB of huge pages)\n", sharedSeconds[1],
+		askedForHugePages ? "requested" : "the OS said no", hugePageBytes / (1024.0 * 1024.0));
+	std::printf("    CheckForCollisions in the arena:  %f seconds, %f seconds asking for huge pages\n",
+		sharedKernelTime[0], sharedKernelTime[1]);
+#pragma endregion Carve every array out of one block, and reuse it between worlds.
 	
 	
 	std::printf("\nPress Enter to Continue.");